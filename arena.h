@@ -0,0 +1,73 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16   // Alignment of every block, enough for any scalar type
+
+// Bump allocator over memory reserved once, e.g. the per-session block the
+// runtime allocates for a game. Blocks are never freed one by one: the whole
+// arena is reset or released at once, so carving a block costs a few
+// instructions and can never fail halfway through a frame. Header-only so that
+// plugins built on their own can use it too.
+struct arena {
+    unsigned char *base;
+    size_t size;    // Bytes reserved
+    size_t used;    // Bytes handed out so far, including padding
+};
+
+// Function to round n up to ARENA_ALIGN, for sizing an arena from its blocks
+static inline size_t arena_round(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+// Function to set up an arena over size bytes at mem, which must be ARENA_ALIGN aligned
+static inline void arena_init(struct arena *a, void *mem, size_t size) {
+    a->base = mem;
+    a->size = size;
+    a->used = 0;
+}
+
+// Function to carve n zeroed bytes from the arena, returns NULL if they do not fit
+static inline void *arena_alloc(struct arena *a, size_t n) {
+    n = arena_round(n);
+    if (a->base == NULL || n > a->size - a->used) {
+        return NULL;
+    }
+    void *p = a->base + a->used;
+    a->used += n;
+    memset(p, 0, n);
+    return p;
+}
+
+// Function to carve n zeroed bytes starting on a multiple of align, a power of
+// two, e.g. a cache line for data several threads write; sizing the arena,
+// count align - ARENA_ALIGN bytes of padding on top of arena_round(n)
+static inline void *arena_alloc_aligned(struct arena *a, size_t n, size_t align) {
+    if (a->base == NULL) {
+        return NULL;
+    }
+    size_t pad = (size_t)(-(uintptr_t)(a->base + a->used)) & (align - 1);
+    if (pad > a->size - a->used || arena_round(n) > a->size - a->used - pad) {
+        return NULL;  // Nothing taken, not even the padding
+    }
+    a->used += pad;
+    return arena_alloc(a, n);
+}
+
+// Function to carve an array of count elements of size bytes, NULL if it does not fit
+static inline void *arena_array(struct arena *a, size_t count, size_t size) {
+    if (size != 0 && count > (size_t)-1 / size) {
+        return NULL;
+    }
+    return arena_alloc(a, count * size);
+}
+
+// Function to hand out the whole arena again; earlier blocks become invalid
+static inline void arena_reset(struct arena *a) {
+    a->used = 0;
+}
+
+#endif
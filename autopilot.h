@@ -0,0 +1,360 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "snake.h"
+
+// Environment variable making the snake play itself with the named strategy,
+// e.g. VGC_AUTOPILOT=shortcut; the launcher sets it for its attract mode
+#define AUTOPILOT_ENV "VGC_AUTOPILOT"
+
+#define AUTOPILOT_NO_CELL UINT32_MAX
+#define AUTOPILOT_RETRY 8   // Moves before searching again for a route that was not there
+#define AUTOPILOT_SLACK 8   // Free cells a shortcut leaves ahead of the tail along the cycle
+
+struct autopilot;
+
+// A way of steering a snake, picked by name. next() returns the enum snake_dir
+// to move in, given the food cell or AUTOPILOT_NO_CELL once the board is full.
+struct autopilot_strategy {
+    const char *name;
+    const char *about;
+    int (*next)(struct autopilot *a, const struct snake *s, uint32_t food);
+};
+
+// Steering state of one snake, kept from move to move so that no move
+// recomputes what an earlier one found. The Hamiltonian cycle is laid out
+// once per board. A* searches stamp the cells they reach with the search
+// number instead of clearing arrays, and the route found is followed until
+// the food moves or something blocks it, so there is one search per food
+// rather than one per move. All memory comes from an arena.
+//
+// On a grid every step changes the distance left to the food by one either
+// way, so the estimated length of a route through a cell, steps so far plus
+// distance left, is either the same as its neighbour's or two more. A* then
+// needs no heap: one stack for the cells of the current estimate and one for
+// the next. Taking the newest cell first also heads straight for the food
+// among the many routes of the same length on an open board.
+struct autopilot {
+    const struct autopilot_strategy *strategy;
+    int width, height;
+    uint32_t cells;
+    uint32_t *cycle_pos;      // Place of every cell along the cycle, NULL if the board has no cycle
+    uint32_t *cycle_cell;     // Cell at every place along the cycle
+    uint32_t *stamp;          // Search that last reached each cell
+    uint32_t *cost;           // Steps from the head, where stamp is current
+    unsigned char *came;      // Direction each cell was entered by, where stamp is current
+    uint32_t *open_now;       // Open cells of a search at the current estimate
+    uint32_t *open_next;      // and at the next one, two steps longer
+    uint32_t open_cap;
+    unsigned char *route;     // Directions from the head to the food found by the last search
+    uint32_t route_len, route_pos;
+    uint32_t route_food;      // Food cell the route leads to, AUTOPILOT_NO_CELL if there is none
+    uint32_t search;          // Number of the last search
+    uint32_t wait;            // Moves left before searching again after finding no route
+    long long searches;       // Searches run, for the benchmarks
+};
+
+// Function to work out the direction from a cell to one next to it
+static inline int autopilot_dir(const struct autopilot *a, uint32_t from, uint32_t to) {
+    if (to + (uint32_t)a->width == from) {
+        return SNAKE_UP;
+    }
+    if (to == from + (uint32_t)a->width) {
+        return SNAKE_DOWN;
+    }
+    return to == from + 1 ? SNAKE_RIGHT : SNAKE_LEFT;
+}
+
+// Function to get the cell next to another in a direction, AUTOPILOT_NO_CELL past the border
+static inline uint32_t autopilot_step(const struct autopilot *a, uint32_t cell, int dir) {
+    int x = (int)(cell % (uint32_t)a->width) + snake_dx[dir];
+    int y = (int)(cell / (uint32_t)a->width) + snake_dy[dir];
+
+    if (x < 0 || x >= a->width || y < 0 || y >= a->height) {
+        return AUTOPILOT_NO_CELL;
+    }
+    return (uint32_t)y * (uint32_t)a->width + (uint32_t)x;
+}
+
+// Function to tell how far along the cycle a cell lies after another
+static inline uint32_t autopilot_ahead(const struct autopilot *a, uint32_t from, uint32_t to) {
+    uint32_t d = a->cycle_pos[to] - a->cycle_pos[from];
+    return d >= a->cells ? d + a->cells : d;   // Wrapped around below zero
+}
+
+// Function to get the direction of the cell after the head along the cycle
+static inline int autopilot_cycle_dir(const struct autopilot *a, uint32_t head) {
+    uint32_t pos = a->cycle_pos[head] + 1;
+    return autopilot_dir(a, head, a->cycle_cell[pos == a->cells ? 0 : pos]);
+}
+
+// Function to lay out a Hamiltonian cycle: along the first row, back in a zigzag
+// over the other columns and up the first column. It needs an even number of
+// rows; with an odd one the board is walked transposed. Returns -1 when both
+// sides are odd, where no cycle exists.
+static inline int autopilot_lay_cycle(struct autopilot *a) {
+    int w = a->width, h = a->height;
+    int transposed = h % 2 != 0;
+    uint32_t pos = 0;
+
+    if (transposed) {
+        w = a->height;
+        h = a->width;
+    }
+    if (h % 2 != 0 || w < 2) {
+        return -1;
+    }
+    for (int i = 0; i < h * w; i++) {
+        int x, y;
+        if (i < w) {
+            x = i;             // The first row, left to right
+            y = 0;
+        } else if (i < w + (h - 1) * (w - 1)) {
+            int k = i - w;     // Zigzag over columns 1..w-1 of the rows below
+            y = 1 + k / (w - 1);
+            x = y % 2 != 0 ? w - 1 - k % (w - 1) : 1 + k % (w - 1);
+        } else {
+            x = 0;             // Up the first column
+            y = h - 1 - (i - w - (h - 1) * (w - 1));
+        }
+        uint32_t cell = transposed ? (uint32_t)x * (uint32_t)a->width + (uint32_t)y
+                                   : (uint32_t)y * (uint32_t)a->width + (uint32_t)x;
+        a->cycle_pos[cell] = pos;
+        a->cycle_cell[pos++] = cell;
+    }
+    return 0;
+}
+
+// Function to work out the distance between two cells, ignoring the body
+static inline uint32_t autopilot_distance(const struct autopilot *a, uint32_t from, uint32_t to) {
+    int dx = (int)(from % (uint32_t)a->width) - (int)(to % (uint32_t)a->width);
+    int dy = (int)(from / (uint32_t)a->width) - (int)(to / (uint32_t)a->width);
+    return (uint32_t)(abs(dx) + abs(dy));
+}
+
+// Function to find a shortest route from the head to the food around the
+// body with A*, the body counting as walls; returns 0 if there is one
+static inline int autopilot_search(struct autopilot *a, const struct snake *s, uint32_t food) {
+    uint32_t head = (uint32_t)s->head_y * (uint32_t)a->width + (uint32_t)s->head_x;
+    uint32_t estimate = autopilot_distance(a, head, food);
+    uint32_t now = 0, next = 0;
+
+    a->searches++;
+    a->route_len = a->route_pos = 0;
+    a->route_food = food;
+    if (++a->search == 0) {
+        memset(a->stamp, 0, a->cells * sizeof(uint32_t));   // Stamps wrapped around
+        a->search = 1;
+    }
+    a->stamp[head] = a->search;
+    a->cost[head] = 0;
+    a->open_now[now++] = head;
+
+    while (now > 0 || next > 0) {
+        if (now == 0) {
+            // Every route of this estimate is blocked, go on with the longer ones
+            uint32_t *swap = a->open_now;
+            a->open_now = a->open_next;
+            a->open_next = swap;
+            now = next;
+            next = 0;
+            estimate += 2;
+        }
+        uint32_t cell = a->open_now[--now];
+        if (a->cost[cell] + autopilot_distance(a, cell, food) != estimate) {
+            continue;   // Reached again by a shorter route since it was pushed
+        }
+        if (cell == food) {
+            // Walk back to the head, writing the route from its end
+            uint32_t n = a->cost[food];
+            a->route_len = n;
+            while (cell != head) {
+                int dir = a->came[cell];
+                a->route[--n] = (unsigned char)dir;
+                cell = autopilot_step(a, cell, (dir + 2) & 3);
+            }
+            return 0;
+        }
+        for (int dir = 0; dir < 4; dir++) {
+            uint32_t to = autopilot_step(a, cell, dir);
+            if (to == AUTOPILOT_NO_CELL || snake_occupied(s, to)) {
+                continue;
+            }
+            uint32_t cost = a->cost[cell] + 1;
+            if (a->stamp[to] == a->search && a->cost[to] <= cost) {
+                continue;
+            }
+            a->stamp[to] = a->search;
+            a->cost[to] = cost;
+            a->came[to] = (unsigned char)dir;
+            if (cost + autopilot_distance(a, to, food) == estimate) {
+                if (now < a->open_cap) {
+                    a->open_now[now++] = to;
+                }
+            } else if (next < a->open_cap) {
+                a->open_next[next++] = to;
+            }
+        }
+    }
+    a->wait = AUTOPILOT_RETRY;
+    return -1;
+}
+
+// Function to pick any direction that does not run into the body or the border, -1 if none
+static inline int autopilot_any_free(const struct autopilot *a, const struct snake *s, uint32_t head) {
+    for (int dir = 0; dir < 4; dir++) {
+        uint32_t next = autopilot_step(a, head, dir);
+        if (next != AUTOPILOT_NO_CELL && !snake_occupied(s, next)) {
+            return dir;
+        }
+    }
+    return -1;
+}
+
+// Function to steer along the shortest route to the food, found again only
+// when the food moved or the route got blocked; with no route, along the
+// cycle or anywhere free. Greedy: it can wall itself in.
+static inline int autopilot_next_astar(struct autopilot *a, const struct snake *s, uint32_t food) {
+    uint32_t head = (uint32_t)s->head_y * (uint32_t)a->width + (uint32_t)s->head_x;
+
+    if (food != AUTOPILOT_NO_CELL) {
+        int fresh = a->route_food == food && a->route_pos < a->route_len;
+        if (fresh) {
+            uint32_t next = autopilot_step(a, head, a->route[a->route_pos]);
+            fresh = next != AUTOPILOT_NO_CELL && !snake_occupied(s, next);
+        }
+        if (fresh) {
+            return a->route[a->route_pos++];
+        }
+        // Cut off from the food: the tail frees a cell every move, so look again a few moves later
+        if (a->wait == 0 || a->route_food != food) {
+            if (autopilot_search(a, s, food) == 0) {
+                return a->route[a->route_pos++];
+            }
+        } else {
+            a->wait--;
+        }
+    }
+    if (a->cycle_pos != NULL) {
+        int dir = autopilot_cycle_dir(a, head);
+        uint32_t next = autopilot_step(a, head, dir);
+        if (!snake_occupied(s, next)) {
+            return dir;
+        }
+    }
+    int dir = autopilot_any_free(a, s, head);
+    return dir < 0 ? SNAKE_UP : dir;
+}
+
+// Function to steer strictly along the Hamiltonian cycle. The body then always
+// lies along the cycle behind the head, so the cell ahead is free until the
+// body fills the board: the snake never dies, it just takes its time.
+static inline int autopilot_next_cycle(struct autopilot *a, const struct snake *s, uint32_t food) {
+    (void)food;
+    return autopilot_cycle_dir(a, (uint32_t)s->head_y * (uint32_t)a->width + (uint32_t)s->head_x);
+}
+
+// Function to steer along the cycle but cut across it towards the food while
+// the snake is short, to any free neighbour that does not overtake the tail
+// along the cycle. The body stays in cycle order, so the cycle can always be
+// picked up again; past half the board it is followed strictly. The cells
+// skipped are left as gaps in the body, and food eaten before the tail gets
+// there uses up the room ahead of it, hence the slack.
+static inline int autopilot_next_shortcut(struct autopilot *a, const struct snake *s, uint32_t food) {
+    uint32_t head = (uint32_t)s->head_y * (uint32_t)a->width + (uint32_t)s->head_x;
+    uint32_t tail = (uint32_t)s->tail_y * (uint32_t)a->width + (uint32_t)s->tail_x;
+    int best = autopilot_cycle_dir(a, head);
+
+    if (food == AUTOPILOT_NO_CELL || s->length > a->cells / 2) {
+        return best;
+    }
+    uint32_t room = s->length == 1 ? a->cells : autopilot_ahead(a, head, tail);
+    uint32_t goal = autopilot_ahead(a, head, food);
+    uint32_t best_ahead = 1;
+    for (int dir = 0; dir < 4; dir++) {
+        uint32_t next = autopilot_step(a, head, dir);
+        if (next == AUTOPILOT_NO_CELL || snake_occupied(s, next)) {
+            continue;
+        }
+        // Skipping ahead, but not past the food, and leaving room behind the tail to grow
+        uint32_t ahead = autopilot_ahead(a, head, next);
+        if (ahead > best_ahead && ahead <= goal && ahead + AUTOPILOT_SLACK <= room) {
+            best = dir;
+            best_ahead = ahead;
+        }
+    }
+    return best;
+}
+
+// Strategies by name; the ones following the cycle need a board with an even side
+static const struct autopilot_strategy autopilot_strategies[] = {
+    { "astar", "greedy A* to the food", autopilot_next_astar },
+    { "cycle", "Hamiltonian cycle, never dies", autopilot_next_cycle },
+    { "shortcut", "Hamiltonian cycle with safe shortcuts", autopilot_next_shortcut },
+};
+
+#define AUTOPILOT_STRATEGIES (sizeof(autopilot_strategies) / sizeof(autopilot_strategies[0]))
+
+// Function to find a strategy by name, NULL if there is none
+static inline const struct autopilot_strategy *autopilot_find(const char *name) {
+    for (size_t i = 0; name != NULL && i < AUTOPILOT_STRATEGIES; i++) {
+        if (strcmp(autopilot_strategies[i].name, name) == 0) {
+            return &autopilot_strategies[i];
+        }
+    }
+    return NULL;
+}
+
+// Function to work out the arena bytes an autopilot on a width x height board needs
+static inline size_t autopilot_arena_size(int width, int height) {
+    size_t cells = (size_t)width * height;
+
+    return 4 * arena_round(cells * sizeof(uint32_t)) + 2 * arena_round(cells)
+           + 2 * arena_round(4 * cells * sizeof(uint32_t));
+}
+
+// Function to carve an autopilot for a board from an arena and lay out its
+// cycle. On a board with two odd sides, which has no cycle, it steers with
+// A* whatever the strategy asked. Returns 0 on success.
+static inline int autopilot_setup(struct autopilot *a, struct arena *arena, const struct autopilot_strategy *strategy,
+                                  int width, int height) {
+    size_t cells = (size_t)width * height;
+
+    memset(a, 0, sizeof(*a));
+    a->width = width;
+    a->height = height;
+    a->cells = (uint32_t)cells;
+    a->open_cap = 4 * a->cells;   // A cell is pushed at most once from each neighbour
+    a->route_food = AUTOPILOT_NO_CELL;
+    a->cycle_pos = arena_array(arena, cells, sizeof(uint32_t));
+    a->cycle_cell = arena_array(arena, cells, sizeof(uint32_t));
+    a->stamp = arena_array(arena, cells, sizeof(uint32_t));
+    a->cost = arena_array(arena, cells, sizeof(uint32_t));
+    a->came = arena_alloc(arena, cells);
+    a->route = arena_alloc(arena, cells);
+    a->open_now = arena_array(arena, 4 * cells, sizeof(uint32_t));
+    a->open_next = arena_array(arena, 4 * cells, sizeof(uint32_t));
+    if (a->cycle_pos == NULL || a->cycle_cell == NULL || a->stamp == NULL || a->cost == NULL || a->came == NULL
+        || a->route == NULL || a->open_now == NULL || a->open_next == NULL) {
+        return -1;
+    }
+    if (autopilot_lay_cycle(a) != 0) {
+        a->cycle_pos = a->cycle_cell = NULL;
+        strategy = &autopilot_strategies[0];
+    }
+    a->strategy = strategy;
+    return 0;
+}
+
+// Function to pick the direction of the snake's next move
+static inline int autopilot_next(struct autopilot *a, const struct snake *s, uint32_t food) {
+    return a->strategy->next(a, s, food);
+}
+
+#endif
@@ -0,0 +1,332 @@
+#include <string.h>
+
+#include "battle.h"
+#include "snake.h"
+
+#define CLAIM_STAMP(tick) (((tick) & 0x3fffffffu) << 2)   // Claims of this tick, in the top bits
+
+// Function to stir a number into a well-spread nonzero random state (splitmix64)
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return (x ^ (x >> 31)) | 1;
+}
+
+// Function to draw the next number of a xorshift state
+static uint64_t next_random(uint64_t *state) {
+    uint64_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// Function to read move i of a snake's ring
+static int move_at(const struct battle_snake *s, uint32_t i) {
+    return (s->moves[i / 4] >> ((i % 4) * 2)) & 3;
+}
+
+// Function to write move i of a snake's ring
+static void set_move(struct battle_snake *s, uint32_t i, int dir) {
+    unsigned char shift = (unsigned char)((i % 4) * 2);
+    s->moves[i / 4] = (unsigned char)((s->moves[i / 4] & ~(3 << shift)) | (dir << shift));
+}
+
+// Function to look at the cell next to a snake's head, -1 past the border
+static int look(const struct battle *b, const struct battle_snake *s, int dir) {
+    int x = s->head_x + snake_dx[dir];
+    int y = s->head_y + snake_dy[dir];
+
+    if (x < 0 || x >= b->width || y < 0 || y >= b->height) {
+        return -1;
+    }
+    return b->cells[y * b->width + x];
+}
+
+// Function to work out the arena bytes a width x height battle needs, 0 if it is too large
+size_t battle_arena_size(int width, int height) {
+    size_t cells = (size_t)width * height;
+    size_t snakes = cells / BATTLE_CELLS_PER_SNAKE;
+    size_t bands = ((size_t)height + BATTLE_BAND_ROWS - 1) / BATTLE_BAND_ROWS;
+
+    if (width < BATTLE_MIN_SIDE || height < BATTLE_MIN_SIDE || width > BATTLE_MAX_SIDE
+        || height > BATTLE_MAX_SIDE) {
+        return 0;
+    }
+    return arena_round(cells) + arena_round(cells * sizeof(uint32_t))
+           + arena_round(snakes * sizeof(struct battle_snake)) + arena_round(snakes * sizeof(int))
+           + arena_round((bands + 1) * sizeof(int)) + bands * sizeof(struct battle_band)
+           + sizeof(struct battle_band) - ARENA_ALIGN;
+}
+
+// Function to put a snake of one segment on a random empty cell, trying a few;
+// it tries again next tick if the board is too full
+static void spawn(struct battle *b, struct battle_snake *s) {
+    size_t cells = (size_t)b->width * b->height;
+
+    for (int tries = 0; tries < 8; tries++) {
+        uint64_t r = next_random(&b->random);
+        size_t cell = (size_t)(r % cells);
+        if (b->cells[cell] == BATTLE_EMPTY) {
+            b->cells[cell] = BATTLE_HEAD;
+            s->head_x = s->tail_x = (int)(cell % b->width);
+            s->head_y = s->tail_y = (int)(cell / b->width);
+            s->length = 1;
+            s->first = 0;
+            s->dir = (unsigned char)((r >> 32) & 3);
+            return;
+        }
+    }
+    s->respawn = b->tick + 1;
+}
+
+// Function to scatter food on empty cells until one in BATTLE_FOOD_SHARE holds some
+static void add_food(struct battle *b) {
+    size_t cells = (size_t)b->width * b->height;
+    long wanted = (long)(cells / BATTLE_FOOD_SHARE);
+    long tries = 2 * (wanted - b->food) + 16;
+
+    while (b->food < wanted && tries-- > 0) {
+        size_t cell = (size_t)(next_random(&b->random) % cells);
+        if (b->cells[cell] == BATTLE_EMPTY) {
+            b->cells[cell] = BATTLE_FOOD;
+            b->food++;
+        }
+    }
+}
+
+// Function to carve a width x height battle from an arena and fill it with
+// snakes and food placed from seed; returns 0 on success
+int battle_setup(struct battle *b, struct arena *arena, int width, int height, int player, unsigned int seed) {
+    size_t cells = (size_t)width * height;
+
+    if (battle_arena_size(width, height) == 0) {
+        return -1;
+    }
+    memset(b, 0, sizeof(*b));
+    b->width = width;
+    b->height = height;
+    b->bands = (height + BATTLE_BAND_ROWS - 1) / BATTLE_BAND_ROWS;
+    b->snake_count = (int)(cells / BATTLE_CELLS_PER_SNAKE);
+    b->player = player;
+    b->cells = arena_alloc(arena, cells);
+    b->claims = arena_array(arena, cells, sizeof(uint32_t));
+    b->snakes = arena_array(arena, (size_t)b->snake_count, sizeof(struct battle_snake));
+    b->order = arena_array(arena, (size_t)b->snake_count, sizeof(int));
+    b->band_start = arena_array(arena, (size_t)b->bands + 1, sizeof(int));
+    b->band_counts = arena_alloc_aligned(arena, (size_t)b->bands * sizeof(struct battle_band),
+                                         sizeof(struct battle_band));
+    if (b->cells == NULL || b->claims == NULL || b->snakes == NULL || b->order == NULL
+        || b->band_start == NULL || b->band_counts == NULL) {
+        return -1;
+    }
+
+    // Every snake draws from its own sequence, so that its moves do not
+    // depend on how many others drew before it
+    b->random = mix(seed);
+    for (int i = 0; i < b->snake_count; i++) {
+        b->snakes[i].random = mix(((uint64_t)seed << 32) ^ (uint64_t)i);
+        spawn(b, &b->snakes[i]);
+    }
+    b->player_dir = b->snakes[0].dir;
+    add_food(b);
+    return 0;
+}
+
+// Function to bump the claimants of a cell for this tick, stopping at two
+static void claim(struct battle *b, int cell) {
+    uint32_t stamp = CLAIM_STAMP(b->tick);
+    uint32_t old = atomic_load_explicit(&b->claims[cell], memory_order_relaxed);
+    uint32_t claimed;
+
+    // Claims of earlier ticks count as none, so the counters never need clearing
+    do {
+        claimed = (old & ~3u) != stamp ? stamp | 1 : (old & 3) < 2 ? old + 1 : old;
+    } while (claimed != old
+             && !atomic_compare_exchange_weak_explicit(&b->claims[cell], &old, claimed, memory_order_relaxed,
+                                                       memory_order_relaxed));
+}
+
+// Function to pick where a bot goes: food next to its head first, otherwise
+// on straight ahead with the odd turn on a whim, around what is in the way
+static int choose(const struct battle *b, struct battle_snake *s) {
+    int ways[3] = { s->dir, (s->dir + 1) & 3, (s->dir + 3) & 3 };
+
+    for (int i = 0; i < 3; i++) {
+        if (look(b, s, ways[i]) == BATTLE_FOOD) {
+            return ways[i];
+        }
+    }
+    uint64_t r = next_random(&s->random);
+    if (r % 8 == 0) {
+        int turn = 1 + (int)((r >> 3) & 1);
+        ways[0] = ways[turn];
+        ways[turn] = s->dir;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (look(b, s, ways[i]) == BATTLE_EMPTY) {
+            return ways[i];
+        }
+    }
+    return ways[0];  // Boxed in
+}
+
+// Function to run the first pass over a band: every snake in it picks a cell
+// and claims it. Reads the board only, as it was when the tick began.
+static void decide_band(void *ctx, int band) {
+    struct battle *b = ctx;
+
+    for (int i = b->band_start[band]; i < b->band_start[band + 1]; i++) {
+        int id = b->order[i];
+        struct battle_snake *s = &b->snakes[id];
+        int dir = b->player && id == 0 ? b->player_dir : choose(b, s);
+        int what = look(b, s, dir);
+
+        s->dir = (unsigned char)dir;
+        s->eats = what == BATTLE_FOOD;
+        s->target = -1;
+        if (what == BATTLE_EMPTY || what == BATTLE_FOOD) {
+            s->target = (s->head_y + snake_dy[dir]) * b->width + s->head_x + snake_dx[dir];
+            claim(b, s->target);
+        }
+    }
+}
+
+// Function to move a snake onto the cell it claimed alone
+static void advance(struct battle *b, struct battle_snake *s) {
+    uint32_t end = (s->first + s->length - 1) % BATTLE_MAX_LENGTH;
+
+    b->cells[s->head_y * b->width + s->head_x] = BATTLE_BODY;
+    b->cells[s->target] = BATTLE_HEAD;
+    set_move(s, end, s->dir);
+    s->head_x = s->target % b->width;
+    s->head_y = s->target / b->width;
+    if (s->eats && s->length < BATTLE_MAX_LENGTH) {
+        s->length++;
+        return;
+    }
+
+    // The tail follows, unless the snake ate and grew
+    int tail = move_at(s, s->first);
+    b->cells[s->tail_y * b->width + s->tail_x] = BATTLE_EMPTY;
+    s->tail_x += snake_dx[tail];
+    s->tail_y += snake_dy[tail];
+    s->first = (s->first + 1) % BATTLE_MAX_LENGTH;
+}
+
+// Function to kill a snake and turn its body into food, returns the food cells it left
+static int kill(struct battle *b, struct battle_snake *s) {
+    int x = s->tail_x, y = s->tail_y;
+    int food = (int)s->length;
+
+    b->cells[y * b->width + x] = BATTLE_FOOD;
+    for (uint32_t n = 0; n + 1 < s->length; n++) {
+        int dir = move_at(s, (s->first + n) % BATTLE_MAX_LENGTH);
+        x += snake_dx[dir];
+        y += snake_dy[dir];
+        b->cells[y * b->width + x] = BATTLE_FOOD;
+    }
+    s->length = 0;
+    s->respawn = b->tick + BATTLE_RESPAWN_TICKS;
+    return food;
+}
+
+// Function to run the second pass over a band: move the snakes that claimed a
+// cell alone and kill the others. Every cell written belongs to one snake, its
+// own body or the cell only it claimed, so the bands never write the same one.
+static void resolve_band(void *ctx, int band) {
+    struct battle *b = ctx;
+    int food = 0, deaths = 0;
+
+    for (int i = b->band_start[band]; i < b->band_start[band + 1]; i++) {
+        struct battle_snake *s = &b->snakes[b->order[i]];
+        if (s->target >= 0 && (atomic_load_explicit(&b->claims[s->target], memory_order_relaxed) & 3) == 1) {
+            advance(b, s);
+            food -= s->eats;
+        } else {
+            food += kill(b, s);
+            deaths++;
+        }
+    }
+    b->band_counts[band].food = food;
+    b->band_counts[band].deaths = deaths;
+}
+
+// Function to sort the living snakes by the band their head is in, in the order of their numbers
+static void sort_by_band(struct battle *b) {
+    int *start = b->band_start;
+
+    memset(start, 0, ((size_t)b->bands + 1) * sizeof(int));
+    for (int i = 0; i < b->snake_count; i++) {
+        if (b->snakes[i].length > 0) {
+            start[b->snakes[i].head_y / BATTLE_BAND_ROWS + 1]++;
+        }
+    }
+    for (int band = 0; band < b->bands; band++) {
+        start[band + 1] += start[band];
+    }
+    for (int i = 0; i < b->snake_count; i++) {
+        if (b->snakes[i].length > 0) {
+            b->order[start[b->snakes[i].head_y / BATTLE_BAND_ROWS]++] = i;
+        }
+    }
+    // Filling in moved every start to the next band's, shift them back
+    memmove(start + 1, start, (size_t)b->bands * sizeof(int));
+    start[0] = 0;
+}
+
+// Function to advance every snake by one cell on the pool's threads
+void battle_tick(struct battle *b, struct pool *pool) {
+    b->tick++;
+    sort_by_band(b);
+    pool_run(pool, b->bands, decide_band, b);
+    pool_run(pool, b->bands, resolve_band, b);
+
+    for (int band = 0; band < b->bands; band++) {
+        b->food += b->band_counts[band].food;
+        b->deaths += b->band_counts[band].deaths;
+    }
+
+    // Dead bots come back in the order of their numbers; the player does not
+    for (int i = b->player ? 1 : 0; i < b->snake_count; i++) {
+        struct battle_snake *s = &b->snakes[i];
+        if (s->length == 0 && s->respawn <= b->tick) {
+            spawn(b, s);
+        }
+    }
+    add_food(b);
+}
+
+// Function to steer the player's snake, turning back into its body is ignored
+void battle_steer(struct battle *b, int dir) {
+    const struct battle_snake *s = &b->snakes[0];
+
+    if (s->length <= 1 || dir != ((s->dir + 2) & 3)) {
+        b->player_dir = dir;
+    }
+}
+
+// Function to mix bytes into an FNV-1a hash
+static uint64_t fnv(uint64_t hash, const void *data, size_t len) {
+    const unsigned char *p = data;
+
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ p[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// Function to hash the board and every snake, to compare runs
+uint64_t battle_hash(const struct battle *b) {
+    uint64_t hash = fnv(0xcbf29ce484222325ULL, b->cells, (size_t)b->width * b->height);
+
+    for (int i = 0; i < b->snake_count; i++) {
+        const struct battle_snake *s = &b->snakes[i];
+        int fields[6] = { s->head_x, s->head_y, s->tail_x, s->tail_y, (int)s->length, s->dir };
+        hash = fnv(hash, fields, sizeof(fields));
+    }
+    long counts[2] = { b->food, b->deaths };
+    return fnv(hash, counts, sizeof(counts));
+}
@@ -0,0 +1,95 @@
+#ifndef BATTLE_H
+#define BATTLE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "pool.h"
+
+#define BATTLE_MIN_SIDE 16
+#define BATTLE_MAX_SIDE 4096        // Largest side, so cell numbers and claims stay small
+#define BATTLE_BAND_ROWS 8          // Rows of a band, the region ticked as one task
+#define BATTLE_CELLS_PER_SNAKE 64   // Board area per snake
+#define BATTLE_MAX_LENGTH 64        // Segments a snake grows to at most
+#define BATTLE_RESPAWN_TICKS 20     // Ticks a dead bot waits before it enters again
+#define BATTLE_FOOD_SHARE 32        // One cell in this many holds food when the board is topped up
+
+// What a cell of the board holds
+enum battle_cell {
+    BATTLE_EMPTY,
+    BATTLE_BODY,
+    BATTLE_HEAD,
+    BATTLE_FOOD,
+};
+
+// One snake of a battle. The body is a ring of 2-bit moves from the tail to
+// the head, like struct snake's, but small and fixed so that thousands fit in
+// one array. Cells are numbered y * width + x.
+struct battle_snake {
+    int head_x, head_y;
+    int tail_x, tail_y;
+    uint32_t length;      // Segments, head included; 0 while dead
+    uint32_t first;       // Ring index of the move that leaves the tail
+    unsigned char moves[BATTLE_MAX_LENGTH / 4];
+    unsigned char dir;    // enum snake_dir it last moved in
+    unsigned char eats;   // Set when the cell it heads for holds food
+    int target;           // Cell it heads for this tick, -1 if it runs into a wall or a body
+    uint32_t respawn;     // Tick it enters again after dying
+    uint64_t random;      // Its own xorshift state, so its choices do not depend on the others'
+};
+
+// Counters one band fills in during a tick, a cache line each so that the
+// threads ticking neighbouring regions do not write to the same line
+struct battle_band {
+    int food;     // Food cells added by deaths less the ones eaten
+    int deaths;
+} __attribute__((aligned(64)));
+
+// Battle of many snakes on one board, ticked in parallel.
+//
+// The board is cut into bands of BATTLE_BAND_ROWS rows and every tick runs in
+// two passes over the bands on a thread pool, each snake handled by the band
+// its head is in. The first pass only reads the board: each snake picks the
+// cell it moves to and claims it by bumping an atomic counter. The second pass
+// moves the snakes whose cell nobody else claimed and kills the rest, so two
+// heads going for one cell die together whichever band or thread they are in.
+// Nothing depends on the order snakes are handled in, so a game plays out the
+// same on any number of threads; what has to happen in order, respawning and
+// adding food, runs after them on the caller's thread.
+struct battle {
+    int width, height;
+    int bands;
+    int snake_count;
+    int player;                   // 1 if snake 0 is steered by battle_steer(), not by the AI
+    int player_dir;               // Where the player's snake heads next
+    uint32_t tick;
+    uint64_t random;              // For placing food and respawning, advanced in order
+    long food;                    // Cells holding food
+    long deaths;                  // Snakes killed so far
+    unsigned char *cells;         // enum battle_cell of every cell
+    _Atomic uint32_t *claims;     // tick << 2 | claimants (at most 2) of every cell
+    struct battle_snake *snakes;
+    int *order;                   // Snake numbers sorted by the band their head is in
+    int *band_start;              // order[band_start[b]..band_start[b + 1]] are in band b
+    struct battle_band *band_counts;
+};
+
+// Bytes of arena a width x height battle needs, 0 if it is too large
+size_t battle_arena_size(int width, int height);
+
+// Carve a width x height battle from an arena and fill it with snakes and
+// food placed from seed; returns 0 on success
+int battle_setup(struct battle *b, struct arena *arena, int width, int height, int player, unsigned int seed);
+
+// Advance every snake by one cell on the pool's threads
+void battle_tick(struct battle *b, struct pool *pool);
+
+// Steer the player's snake, enum snake_dir; turning back is ignored
+void battle_steer(struct battle *b, int dir);
+
+// Hash the board and every snake, to compare runs
+uint64_t battle_hash(const struct battle *b);
+
+#endif
@@ -0,0 +1,534 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <dirent.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "catalog.h"
+#include "game_plugin.h"
+
+#define CATALOG_MAGIC "VGCCAT1"
+#define CATALOG_VERSION 1
+#define STRING_BLOCK 4096
+
+// On-disk layout of the manifest: header, records, then a table of NUL-terminated strings
+struct catalog_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+    int64_t dir_mtime;
+    uint32_t strings_off;
+    uint32_t strings_len;
+};
+
+struct catalog_record {
+    uint32_t name_off;
+    uint32_t title_off;
+    uint32_t description_off;
+    uint32_t plugin;
+    int64_t size;
+    int64_t mtime;
+};
+
+// Function to copy a string into the catalog's string storage
+static const char *store_string(struct catalog *c, const char *s) {
+    size_t len = strlen(s) + 1;
+    struct catalog_strings *b = c->strings;
+
+    if (b == NULL || b->cap - b->used < len) {
+        size_t cap = len > STRING_BLOCK ? len : STRING_BLOCK;
+        b = malloc(sizeof(*b) + cap);
+        if (b == NULL) {
+            return "";
+        }
+        b->next = c->strings;
+        b->used = 0;
+        b->cap = cap;
+        c->strings = b;
+    }
+
+    char *copy = b->data + b->used;
+    memcpy(copy, s, len);
+    b->used += len;
+    return copy;
+}
+
+// Function to append an entry, growing the array as needed
+static struct catalog_entry *push_entry(struct catalog *c) {
+    if (c->count == c->capacity) {
+        int capacity = c->capacity ? c->capacity * 2 : 16;
+        struct catalog_entry *entries = realloc(c->entries, capacity * sizeof(*entries));
+        if (entries == NULL) {
+            return NULL;
+        }
+        c->entries = entries;
+        c->capacity = capacity;
+    }
+    return &c->entries[c->count++];
+}
+
+// Function to drop all entries and strings but keep the entry array
+static void clear_entries(struct catalog *c) {
+    while (c->strings != NULL) {
+        struct catalog_strings *next = c->strings->next;
+        free(c->strings);
+        c->strings = next;
+    }
+    if (c->map != NULL) {
+        munmap(c->map, c->map_len);
+        c->map = NULL;
+    }
+    c->count = 0;
+}
+
+// Function to read a directory's mtime in nanoseconds
+static long long dir_mtime(const char *dir) {
+    struct stat st;
+    if (stat(dir, &st) < 0) {
+        return -1;
+    }
+    return (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+// Function to read the title and description a game stores in its .note.vgc section
+static void read_note(const char *path, char *title, size_t title_len, char *desc, size_t desc_len) {
+    struct stat st;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(Elf64_Ehdr)) {
+        close(fd);
+        return;
+    }
+
+    const unsigned char *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+
+    size_t len = st.st_size;
+    const Elf64_Ehdr *eh = (const Elf64_Ehdr *)map;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_shentsize != sizeof(Elf64_Shdr) || eh->e_shoff > len ||
+        (len - eh->e_shoff) / sizeof(Elf64_Shdr) < eh->e_shnum || eh->e_shstrndx >= eh->e_shnum) {
+        munmap((void *)map, len);
+        return;
+    }
+
+    const Elf64_Shdr *sh = (const Elf64_Shdr *)(map + eh->e_shoff);
+    const Elf64_Shdr *names = &sh[eh->e_shstrndx];
+
+    for (int i = 0; i < eh->e_shnum; i++) {
+        if (sh[i].sh_type != SHT_NOTE || sh[i].sh_offset > len || sh[i].sh_size > len - sh[i].sh_offset ||
+            names->sh_offset + sh[i].sh_name + sizeof(GAME_NOTE_SECTION) > len ||
+            strcmp((const char *)map + names->sh_offset + sh[i].sh_name, GAME_NOTE_SECTION) != 0) {
+            continue;
+        }
+
+        // Walk the notes of the section looking for ours
+        size_t off = sh[i].sh_offset;
+        size_t end = off + sh[i].sh_size;
+        while (end - off >= sizeof(Elf64_Nhdr)) {
+            const Elf64_Nhdr *nh = (const Elf64_Nhdr *)(map + off);
+            size_t name_off = off + sizeof(*nh);
+            size_t desc_off = name_off + ((nh->n_namesz + 3) & ~3u);
+            if (desc_off > end || nh->n_descsz > end - desc_off) {
+                break;
+            }
+
+            if (nh->n_type == GAME_NOTE_TYPE && nh->n_namesz == sizeof(GAME_NOTE_OWNER) &&
+                memcmp(map + name_off, GAME_NOTE_OWNER, sizeof(GAME_NOTE_OWNER)) == 0) {
+                // The descriptor holds "title\0description\0"
+                const char *d = (const char *)map + desc_off;
+                size_t t = strnlen(d, nh->n_descsz);
+                snprintf(title, title_len, "%.*s", (int)t, d);
+                if (t + 1 < nh->n_descsz) {
+                    snprintf(desc, desc_len, "%.*s", (int)strnlen(d + t + 1, nh->n_descsz - t - 1), d + t + 1);
+                }
+                munmap((void *)map, len);
+                return;
+            }
+            off = desc_off + ((nh->n_descsz + 3) & ~3u);
+        }
+    }
+    munmap((void *)map, len);
+}
+
+// Function to compare entries by name
+static int compare_entries(const void *a, const void *b) {
+    return strcmp(((const struct catalog_entry *)a)->name, ((const struct catalog_entry *)b)->name);
+}
+
+// Function to find the index of a game by file name, -1 if absent
+int catalog_find(const struct catalog *c, const char *name) {
+    struct catalog_entry key = { .name = name };
+    const struct catalog_entry *e = bsearch(&key, c->entries, c->count, sizeof(key), compare_entries);
+    return e != NULL ? (int)(e - c->entries) : -1;
+}
+
+// Function to hide game_x when game_x.so is present
+static void drop_shadowed(struct catalog *c) {
+    char plugin_name[512];
+    int kept = 0;
+
+    // Mark first so the lookups see the array still sorted
+    for (int i = 0; i < c->count; i++) {
+        struct catalog_entry *e = &c->entries[i];
+        snprintf(plugin_name, sizeof(plugin_name), "%s.so", e->name);
+        if (!e->plugin && catalog_find(c, plugin_name) >= 0) {
+            e->plugin = -1;
+        }
+    }
+
+    for (int i = 0; i < c->count; i++) {
+        if (c->entries[i].plugin >= 0) {
+            c->entries[kept++] = c->entries[i];
+        }
+    }
+    c->count = kept;
+}
+
+// Function to describe one game file, returns 0 if it exists and is a regular file
+static int read_entry(struct catalog *c, const char *dir, const char *name, struct catalog_entry *e) {
+    char path[4096];
+    struct stat st;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if (stat(path, &st) < 0 || !S_ISREG(st.st_mode)) {
+        return -1;
+    }
+
+    // Games without a note get a title derived from their file name
+    size_t len = strlen(name);
+    int plugin = len > 3 && strcmp(name + len - 3, ".so") == 0;
+    char title[128], desc[256] = "";
+    snprintf(title, sizeof(title), "%.*s", (int)(len - 5 - (plugin ? 3 : 0)), name + 5);
+    read_note(path, title, sizeof(title), desc, sizeof(desc));
+
+    e->name = store_string(c, name);
+    e->title = store_string(c, title);
+    e->description = store_string(c, desc);
+    e->size = st.st_size;
+    e->mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    e->plugin = plugin;
+    return 0;
+}
+
+// Function to scan the directory for game_* files
+int catalog_scan(struct catalog *c, const char *dir) {
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+
+    if (d == NULL) {
+        perror("Failed to open directory");
+        return -1;
+    }
+
+    clear_entries(c);
+    c->dir_mtime = dir_mtime(dir);
+
+    while ((entry = readdir(d)) != NULL) {
+        if (strncmp(entry->d_name, "game_", 5) != 0) {  // Check if file starts with "game_"
+            continue;
+        }
+
+        struct catalog_entry e;
+        if (read_entry(c, dir, entry->d_name, &e) == 0) {
+            struct catalog_entry *slot = push_entry(c);
+            if (slot == NULL) {
+                break;
+            }
+            *slot = e;
+        }
+    }
+    closedir(d);
+
+    qsort(c->entries, c->count, sizeof(*c->entries), compare_entries);
+    drop_shadowed(c);
+    return c->count;
+}
+
+// Function to find where a name would be inserted to keep the array sorted
+static int lower_bound(const struct catalog *c, const char *name) {
+    int lo = 0, hi = c->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (strcmp(c->entries[mid].name, name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Function to remove the entry at index i
+static void remove_entry(struct catalog *c, int i) {
+    memmove(&c->entries[i], &c->entries[i + 1], (c->count - i - 1) * sizeof(*c->entries));
+    c->count--;
+}
+
+// Function to insert an entry at its sorted position, returns its index
+static int insert_entry(struct catalog *c, const struct catalog_entry *e) {
+    int i = lower_bound(c, e->name);
+    if (push_entry(c) == NULL) {
+        return -1;
+    }
+    memmove(&c->entries[i + 1], &c->entries[i], (c->count - i - 1) * sizeof(*c->entries));
+    c->entries[i] = *e;
+    return i;
+}
+
+// Function to bring the entry of one game in line with the directory.
+// A game is shown as game_x.so if that exists, otherwise as game_x.
+int catalog_update(struct catalog *c, const char *dir, const char *name) {
+    char base[512], plugin_name[sizeof(base) + 3];
+    struct catalog_entry want;
+    size_t len = strlen(name);
+
+    if (strncmp(name, "game_", 5) != 0 || len >= sizeof(base)) {
+        return -1;
+    }
+
+    // Both file names of a game map to the same menu row
+    snprintf(base, sizeof(base), "%.*s", (int)(len > 3 && strcmp(name + len - 3, ".so") == 0 ? len - 3 : len), name);
+    snprintf(plugin_name, sizeof(plugin_name), "%s.so", base);
+
+    int have = read_entry(c, dir, plugin_name, &want) == 0 || read_entry(c, dir, base, &want) == 0;
+    int cur = catalog_find(c, plugin_name);
+    if (cur < 0) {
+        cur = catalog_find(c, base);
+    }
+
+    if (cur >= 0 && have && strcmp(c->entries[cur].name, want.name) == 0) {
+        c->entries[cur] = want;  // Replaced in place
+        return cur;
+    }
+
+    int first = -1;
+    if (cur >= 0) {
+        remove_entry(c, cur);
+        first = cur;
+    }
+    if (have) {
+        int i = insert_entry(c, &want);
+        if (i >= 0 && (first < 0 || i < first)) {
+            first = i;
+        }
+    }
+    return first;
+}
+
+// Function to start watching the directory for games being added, replaced or removed
+int catalog_watch(const char *dir) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (inotify_add_watch(fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ATTRIB) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Function to apply every pending event of the watch to the catalog
+int catalog_apply_events(struct catalog *c, const char *dir, int fd) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int first = -1;
+    ssize_t n;
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n; p += sizeof(struct inotify_event) + ((struct inotify_event *)p)->len) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            int row;
+
+            if (ev->mask & IN_Q_OVERFLOW) {
+                // Events were lost, only a rescan can tell what changed
+                catalog_scan(c, dir);
+                first = 0;
+                continue;
+            }
+            if (ev->len == 0) {
+                continue;
+            }
+
+            row = catalog_update(c, dir, ev->name);
+            if (row >= 0 && (first < 0 || row < first)) {
+                first = row;
+            }
+        }
+    }
+    return first;
+}
+
+// Function to map the manifest and use it if it still matches the directory
+static int map_manifest(struct catalog *c, const char *dir, long long mtime) {
+    char path[4096];
+    struct stat st;
+
+    snprintf(path, sizeof(path), "%s/%s", dir, CATALOG_FILE);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct catalog_header)) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    // Validate the header and the bounds of every table before trusting it
+    size_t len = st.st_size;
+    const struct catalog_header *h = map;
+    const struct catalog_record *r = (const struct catalog_record *)(h + 1);
+    const char *strings = (const char *)map + h->strings_off;
+    if (memcmp(h->magic, CATALOG_MAGIC, sizeof(h->magic)) != 0 || h->version != CATALOG_VERSION ||
+        h->dir_mtime != mtime || h->count > (len - sizeof(*h)) / sizeof(*r) ||
+        h->strings_off > len || h->strings_len > len - h->strings_off ||
+        h->strings_len == 0 || strings[h->strings_len - 1] != '\0') {
+        munmap(map, len);
+        return -1;
+    }
+
+    clear_entries(c);
+    for (uint32_t i = 0; i < h->count; i++) {
+        if (r[i].name_off >= h->strings_len || r[i].title_off >= h->strings_len ||
+            r[i].description_off >= h->strings_len) {
+            c->count = 0;
+            munmap(map, len);
+            return -1;
+        }
+
+        // Entries point straight into the mapping, nothing is copied
+        struct catalog_entry *e = push_entry(c);
+        if (e == NULL) {
+            c->count = 0;
+            munmap(map, len);
+            return -1;
+        }
+        e->name = strings + r[i].name_off;
+        e->title = strings + r[i].title_off;
+        e->description = strings + r[i].description_off;
+        e->size = r[i].size;
+        e->mtime = r[i].mtime;
+        e->plugin = r[i].plugin;
+    }
+
+    c->map = map;
+    c->map_len = len;
+    c->dir_mtime = mtime;
+    return c->count;
+}
+
+// Function to load the catalog, preferring the manifest over a directory scan
+int catalog_load(struct catalog *c, const char *dir) {
+    long long mtime = dir_mtime(dir);
+    if (mtime < 0) {
+        perror("Failed to open directory");
+        return -1;
+    }
+
+    int count = map_manifest(c, dir, mtime);
+    if (count >= 0) {
+        return count;
+    }
+
+    // The directory changed since the manifest was built: rescan and refresh it
+    count = catalog_scan(c, dir);
+    if (count >= 0) {
+        catalog_write(c, dir);
+    }
+    return count;
+}
+
+// Function to write the manifest next to the games it describes
+int catalog_write(const struct catalog *c, const char *dir) {
+    char path[4096], tmp[4096];
+    struct catalog_header h;
+    size_t strings_len = 0;
+
+    for (int i = 0; i < c->count; i++) {
+        strings_len += strlen(c->entries[i].name) + strlen(c->entries[i].title) +
+                       strlen(c->entries[i].description) + 3;
+    }
+
+    size_t records_len = c->count * sizeof(struct catalog_record);
+    size_t total = sizeof(h) + records_len + strings_len;
+    char *buf = calloc(1, total);
+    if (buf == NULL) {
+        return -1;
+    }
+
+    struct catalog_record *r = (struct catalog_record *)(buf + sizeof(h));
+    char *strings = buf + sizeof(h) + records_len;
+    uint32_t off = 0;
+
+    for (int i = 0; i < c->count; i++) {
+        const struct catalog_entry *e = &c->entries[i];
+        const char *fields[3] = { e->name, e->title, e->description };
+        uint32_t *offsets[3] = { &r[i].name_off, &r[i].title_off, &r[i].description_off };
+
+        for (int f = 0; f < 3; f++) {
+            size_t len = strlen(fields[f]) + 1;
+            *offsets[f] = off;
+            memcpy(strings + off, fields[f], len);
+            off += len;
+        }
+        r[i].plugin = e->plugin;
+        r[i].size = e->size;
+        r[i].mtime = e->mtime;
+    }
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CATALOG_MAGIC, sizeof(h.magic));
+    h.version = CATALOG_VERSION;
+    h.count = c->count;
+    h.strings_off = sizeof(h) + records_len;
+    h.strings_len = strings_len;
+    memcpy(buf, &h, sizeof(h));
+
+    snprintf(path, sizeof(path), "%s/%s", dir, CATALOG_FILE);
+    snprintf(tmp, sizeof(tmp), "%s/%s.tmp", dir, CATALOG_FILE);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        free(buf);
+        return -1;
+    }
+
+    int ok = write(fd, buf, total) == (ssize_t)total && rename(tmp, path) == 0;
+    free(buf);
+
+    // Creating the manifest touched the directory, so record the mtime it has now
+    if (ok) {
+        int64_t mtime = dir_mtime(dir);
+        ok = pwrite(fd, &mtime, sizeof(mtime), offsetof(struct catalog_header, dir_mtime)) == sizeof(mtime);
+    } else {
+        unlink(tmp);
+    }
+    close(fd);
+    return ok ? 0 : -1;
+}
+
+// Function to release the catalog
+void catalog_free(struct catalog *c) {
+    clear_entries(c);
+    free(c->entries);
+    c->entries = NULL;
+    c->capacity = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <stddef.h>
+
+// Name of the manifest kept inside the mount directory
+#define CATALOG_FILE ".catalog"
+
+// One game known to the launcher
+struct catalog_entry {
+    const char *name;          // File name in the mount directory, e.g. game_snake.so
+    const char *title;         // Title from the game's ELF note, or derived from the name
+    const char *description;   // Description from the ELF note, "" if none
+    long long size;            // File size in bytes
+    long long mtime;           // Modification time in nanoseconds
+    int plugin;                // Set for game_*.so run inside the launcher
+};
+
+// Block of string storage; blocks never move so entry pointers stay valid
+struct catalog_strings {
+    struct catalog_strings *next;
+    size_t used, cap;
+    char data[];
+};
+
+// The list of games plus the manifest it was loaded from
+struct catalog {
+    struct catalog_entry *entries;   // Sorted by name, grows as needed
+    int count, capacity;
+    long long dir_mtime;             // Directory mtime the entries describe
+    struct catalog_strings *strings;
+    void *map;                       // Mapped manifest, NULL after a rescan
+    size_t map_len;
+};
+
+// Load the catalog of dir from its manifest, rescanning (and rewriting the
+// manifest) only when the directory changed. Returns the number of games or -1.
+int catalog_load(struct catalog *c, const char *dir);
+
+// Rebuild the catalog by scanning dir. Returns the number of games or -1.
+int catalog_scan(struct catalog *c, const char *dir);
+
+// Find a game by file name, returns its index or -1
+int catalog_find(const struct catalog *c, const char *name);
+
+// Add, replace or remove the entry for one file of dir after it changed.
+// Returns the first menu row that changed, or -1.
+int catalog_update(struct catalog *c, const char *dir, const char *name);
+
+// Watch dir with inotify, returns a non-blocking fd or -1
+int catalog_watch(const char *dir);
+
+// Apply all pending events of a catalog_watch() fd, same result as catalog_update()
+int catalog_apply_events(struct catalog *c, const char *dir, int fd);
+
+// Write the manifest for dir, returns 0 on success
+int catalog_write(const struct catalog *c, const char *dir);
+
+// Release everything owned by the catalog
+void catalog_free(struct catalog *c);
+
+#endif
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "compositor.h"
+
+// Function to set up the compositor and start from a blank screen
+int compositor_init(struct compositor *c) {
+    int term_rows, term_cols;
+
+    memset(c, 0, sizeof(*c));
+    render_term_size(STDOUT_FILENO, &term_rows, &term_cols);
+
+    // The game gets every line but the last, which holds the overlay
+    c->rows = term_rows > 1 ? term_rows - 1 : term_rows;
+    if (c->rows > GAME_CANVAS_ROWS) {
+        c->rows = GAME_CANVAS_ROWS;
+    }
+    c->cols = term_cols < GAME_CANVAS_COLS ? term_cols : GAME_CANVAS_COLS;
+    c->overlay_row = term_rows > 1 ? term_rows - 1 : 0;
+
+    if (render_init(&c->screen, STDOUT_FILENO, c->overlay_row > c->rows ? c->overlay_row + 1 : c->rows,
+                    term_cols) != 0) {
+        return -1;
+    }
+    render_flush(&c->screen);  // Clear screen
+    c->bytes = c->screen.bytes;
+    return 0;
+}
+
+// Function to copy the visible part of a frame into the next screen
+static struct game_canvas *compose(struct compositor *c, const struct game_shm_frame *f) {
+    struct game_canvas *screen = render_begin(&c->screen);
+
+    for (int i = 0; i < c->rows; i++) {
+        memcpy(&screen->cells[i * screen->cols], &f->cells[i * GAME_CANVAS_COLS],
+               c->cols * sizeof(struct game_cell));
+    }
+    return screen;
+}
+
+// Function to bring the terminal up to date with a frame
+void compositor_draw(struct compositor *c, const struct game_shm_frame *f, const char *overlay) {
+    struct game_canvas *screen = compose(c, f);
+
+    if (c->overlay_row > 0) {
+        screen->row = c->overlay_row;
+        screen->col = 0;
+        canvas_style(screen, GAME_STYLE_BAR);
+        canvas_puts(screen, overlay);
+    }
+
+    // Put the cursor back where the game left it
+    screen->row = f->cursor_row < c->rows ? f->cursor_row : c->rows - 1;
+    screen->col = f->cursor_col < c->cols ? f->cursor_col : c->cols - 1;
+    render_flush(&c->screen);
+    c->bytes = c->screen.bytes;
+}
+
+// Function to hand the terminal back after the game exited
+void compositor_finish(struct compositor *c, const struct game_shm_frame *f) {
+    struct game_canvas *screen = compose(c, f);
+    int last_row = -1;
+
+    for (int i = 0; i < c->rows * GAME_CANVAS_COLS; i++) {
+        if (f->cells[i].ch != ' ') {
+            last_row = i / GAME_CANVAS_COLS;
+        }
+    }
+
+    // Same frame without the overlay, cursor on the line below it
+    screen->row = last_row + 1 < screen->rows ? last_row + 1 : screen->rows - 1;
+    screen->col = 0;
+    render_flush(&c->screen);
+    render_sync(&c->screen);  // The launcher writes next
+    c->bytes = c->screen.bytes;
+}
+
+// Function to release the compositor
+void compositor_free(struct compositor *c) {
+    render_free(&c->screen);
+}
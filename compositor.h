@@ -0,0 +1,30 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <stddef.h>
+
+#include "game_shm.h"
+#include "render.h"
+
+// Launcher side of compositor mode: copies each frame a game publishes into
+// a renderer, which sends only the cells that differ from the terminal
+struct compositor {
+    struct render screen;   // Whole terminal: game lines, then the overlay line
+    int rows, cols;         // Part of the game frame that fits on the terminal
+    int overlay_row;        // Terminal line of the overlay, 0 if there is no room
+    long long bytes;        // Bytes written to the terminal so far
+};
+
+// Set up a compositor for the current terminal size and clear the screen
+int compositor_init(struct compositor *c);
+
+// Bring the terminal up to date with a frame and an overlay line in a single write()
+void compositor_draw(struct compositor *c, const struct game_shm_frame *f, const char *overlay);
+
+// Remove the overlay and leave the cursor below the last frame
+void compositor_finish(struct compositor *c, const struct game_shm_frame *f);
+
+// Release the output buffer
+void compositor_free(struct compositor *c);
+
+#endif
@@ -0,0 +1,762 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "catalog.h"
+#include "daemon.h"
+#include "game_runtime.h"
+#include "input.h"
+#include "render.h"
+
+#define DAEMON_MAX_GAMES 9       // Picked with the keys 1 to 9
+#define DAEMON_EVENTS 256        // Events taken per epoll_wait()
+#define DAEMON_READ_MAX 256      // Keys read per wakeup of one session
+#define DAEMON_STATS_MS 10000    // Period of the stats line on stderr
+#define LOADGEN_INTERVAL_MS 100  // Time between two keys of one load generator session
+#define LOADGEN_SAMPLES (1 << 20)
+
+// Memory of one connected terminal, besides the game it plays
+#define SESSION_BYTES (arena_round(sizeof(struct session))                                          \
+                       + arena_round(GAME_CANVAS_ROWS * GAME_CANVAS_COLS * sizeof(struct game_cell)) \
+                       + arena_round(RENDER_OUT_MAX(GAME_CANVAS_ROWS, GAME_CANVAS_COLS)))
+
+#define KEY_CTRL_C 0x03
+#define KEY_CTRL_D 0x04
+
+// What a session is showing
+enum session_mode {
+    SESSION_MENU,
+    SESSION_GAME,
+    SESSION_OVER,   // Final screen of a game, any key returns to the menu
+};
+
+// One connected terminal. Output that the socket did not take right away is
+// kept in pending; frames produced meanwhile only set dirty and are replaced
+// by the latest state once pending drains, so a session never holds more
+// than one frame of output. shown is what the terminal will show once
+// pending is sent; frames are sent as the difference from it. The session,
+// shown and pending are reserved in one block of SESSION_BYTES when the
+// terminal connects; serving it allocates nothing.
+struct session {
+    int fd;
+    int id;
+    int mode;
+    struct game_session game;
+    struct input keys;     // Decodes the escape sequences of arrows and other keys
+    struct game_cell *shown;
+    int repaint;           // Terminal contents unknown, the next frame clears it
+    char *pending;         // Room for one frame, RENDER_OUT_MAX bytes
+    size_t pending_len, pending_off;   // pending[pending_off..pending_len) is still to be sent
+    int dirty;
+    long long next_tick;   // When tick() is due
+    int heap_pos;          // Index in the tick heap, -1 when not ticking
+    struct session *prev, *next;
+};
+
+// State of the daemon
+struct daemon {
+    int epfd, listen_fd, signal_fd;
+    const struct game_plugin *games[DAEMON_MAX_GAMES];
+    void *handles[DAEMON_MAX_GAMES];
+    int game_count;
+
+    // Min-heap of ticking sessions ordered by next_tick
+    struct session **heap;
+    int heap_len, heap_cap;
+
+    // Shared by all sessions: frames are drawn and encoded one at a time
+    struct game_cell cells[GAME_CANVAS_ROWS * GAME_CANVAS_COLS];
+    char frame[RENDER_OUT_MAX(GAME_CANVAS_ROWS, GAME_CANVAS_COLS)];
+
+    struct session *list;   // Every connected session
+    int sessions, next_id;
+    long long frames, bytes, merged;
+};
+
+// Function to read the monotonic clock in nanoseconds
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to allow as many open sockets as the hard limit permits
+static void raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+// Function to swap two heap slots and keep their positions up to date
+static void heap_swap(struct daemon *d, int a, int b) {
+    struct session *t = d->heap[a];
+    d->heap[a] = d->heap[b];
+    d->heap[b] = t;
+    d->heap[a]->heap_pos = a;
+    d->heap[b]->heap_pos = b;
+}
+
+// Function to restore the heap order around slot i
+static void heap_fix(struct daemon *d, int i) {
+    while (i > 0 && d->heap[i]->next_tick < d->heap[(i - 1) / 2]->next_tick) {
+        heap_swap(d, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    for (;;) {
+        int least = i;
+        int l = 2 * i + 1, r = 2 * i + 2;
+        if (l < d->heap_len && d->heap[l]->next_tick < d->heap[least]->next_tick) {
+            least = l;
+        }
+        if (r < d->heap_len && d->heap[r]->next_tick < d->heap[least]->next_tick) {
+            least = r;
+        }
+        if (least == i) {
+            break;
+        }
+        heap_swap(d, i, least);
+        i = least;
+    }
+}
+
+// Function to make room in the tick heap for every connected session, so that
+// starting a game never has to grow it
+static int heap_reserve(struct daemon *d, int sessions) {
+    if (sessions <= d->heap_cap) {
+        return 0;
+    }
+    int cap = d->heap_cap ? d->heap_cap * 2 : 64;
+    struct session **heap = realloc(d->heap, cap * sizeof(*heap));
+    if (heap == NULL) {
+        return -1;
+    }
+    d->heap = heap;
+    d->heap_cap = cap;
+    return 0;
+}
+
+// Function to schedule the ticks of a session's game
+static int heap_push(struct daemon *d, struct session *s) {
+    if (d->heap_len == d->heap_cap) {
+        return -1;
+    }
+    s->heap_pos = d->heap_len;
+    d->heap[d->heap_len++] = s;
+    heap_fix(d, s->heap_pos);
+    return 0;
+}
+
+// Function to stop the ticks of a session
+static void heap_remove(struct daemon *d, struct session *s) {
+    int i = s->heap_pos;
+    if (i < 0) {
+        return;
+    }
+    s->heap_pos = -1;
+    d->heap_len--;
+    if (i != d->heap_len) {
+        d->heap[i] = d->heap[d->heap_len];
+        d->heap[i]->heap_pos = i;
+        heap_fix(d, i);
+    }
+}
+
+// Function to draw the game chooser
+static void draw_menu(const struct daemon *d, const struct session *s, struct game_canvas *c) {
+    canvas_style(c, GAME_STYLE_TITLE);
+    canvas_puts(c, "Video Game Console");
+    canvas_style(c, GAME_STYLE_PLAIN);
+    canvas_printf(c, "  (seat %d)\n\n", s->id);
+    for (int i = 0; i < d->game_count; i++) {
+        canvas_printf(c, "%d) %s\n", i + 1, d->games[i]->title);
+    }
+    canvas_puts(c, "\nPress a number to start a game, or 'q' to disconnect.");
+}
+
+// Function to choose whether a session also waits for its socket to become writable
+static void watch_output(struct daemon *d, struct session *s, int want) {
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP | (want ? EPOLLOUT : 0), .data.ptr = s };
+    epoll_ctl(d->epfd, EPOLL_CTL_MOD, s->fd, &ev);
+}
+
+// Function to send the current state of a session unless output is still queued
+static int session_flush(struct daemon *d, struct session *s) {
+    if (s->pending_len > 0 || !s->dirty) {
+        if (s->pending_len > 0 && s->dirty) {
+            d->merged++;  // Superseded before it was sent
+        }
+        return 0;
+    }
+
+    struct game_canvas c = { d->cells, GAME_CANVAS_ROWS, GAME_CANVAS_COLS, 0, 0, 0 };
+    canvas_clear(&c);
+    if (s->mode == SESSION_MENU) {
+        draw_menu(d, s, &c);
+    } else {
+        s->game.plugin->draw(s->game.state, &c);
+        if (s->mode == SESSION_OVER) {
+            canvas_puts(&c, "\nPress any key to return to the menu.");
+        }
+    }
+    size_t len = render_diff(s->shown, &c, s->repaint, d->frame, sizeof(d->frame));
+    s->repaint = 0;
+    s->dirty = 0;
+    d->frames++;
+
+    ssize_t n = send(s->fd, d->frame, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            return -1;
+        }
+        n = 0;
+    }
+    d->bytes += n;
+    if ((size_t)n == len) {
+        return 0;
+    }
+
+    // Keep the rest until the socket is writable again
+    memcpy(s->pending, d->frame + n, len - n);
+    s->pending_len = len - n;
+    s->pending_off = 0;
+    watch_output(d, s, 1);
+    return 0;
+}
+
+// Function to send queued output after the socket became writable
+static int session_drain(struct daemon *d, struct session *s) {
+    while (s->pending_off < s->pending_len) {
+        ssize_t n = send(s->fd, s->pending + s->pending_off, s->pending_len - s->pending_off,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        s->pending_off += n;
+        d->bytes += n;
+    }
+
+    s->pending_len = s->pending_off = 0;
+    watch_output(d, s, 0);
+    return session_flush(d, s);  // Send the newest frame if one was merged meanwhile
+}
+
+// Function to leave the current game and go back to the menu
+static void session_end_game(struct daemon *d, struct session *s) {
+    heap_remove(d, s);
+    game_session_end(&s->game);
+    s->mode = SESSION_MENU;
+}
+
+// Function to apply what a game returned from handle_input() or tick()
+static void session_status(struct daemon *d, struct session *s, int status) {
+    if (status == GAME_OVER) {
+        heap_remove(d, s);
+        s->mode = SESSION_OVER;
+    } else if (status == GAME_QUIT) {
+        session_end_game(d, s);
+    } else if (status == GAME_IDLE) {
+        heap_remove(d, s);  // Back on the heap with the next key
+    }
+}
+
+// Function to start game i in a session
+static void session_start_game(struct daemon *d, struct session *s, int i) {
+    unsigned int seed = (unsigned int)now_ns() ^ (unsigned int)s->id;
+    const struct game_plugin *p = d->games[i];
+
+    if (game_session_start(&s->game, p, seed) != 0) {
+        return;
+    }
+    s->mode = SESSION_GAME;
+    if (game_tick_ms(p) > 0) {
+        s->next_tick = now_ns() + (long long)game_tick_ms(p) * 1000000LL;
+        heap_push(d, s);
+    }
+}
+
+// Function to handle one key of a session, returns -1 to disconnect
+static int session_key(struct daemon *d, struct session *s, int key) {
+    if (key == KEY_CTRL_D) {
+        return -1;
+    }
+
+    switch (s->mode) {
+    case SESSION_MENU:
+        if (key == 'q') {
+            return -1;
+        }
+        if (key >= '1' && key < '1' + d->game_count) {
+            session_start_game(d, s, key - '1');
+        }
+        break;
+    case SESSION_GAME:
+        if (key == KEY_CTRL_C) {
+            session_end_game(d, s);
+        } else {
+            session_status(d, s, s->game.plugin->handle_input(s->game.state, key));
+        }
+
+        // An idle game ticks again from now on
+        if (s->mode == SESSION_GAME && s->heap_pos < 0 && game_tick_ms(s->game.plugin) > 0) {
+            s->next_tick = now_ns();
+            heap_push(d, s);
+        }
+        break;
+    case SESSION_OVER:
+        session_end_game(d, s);
+        break;
+    }
+    s->dirty = 1;
+    return 0;
+}
+
+// Function to accept every pending connection
+static void accept_sessions(struct daemon *d) {
+    for (;;) {
+        int fd = accept4(d->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                perror("accept");
+            }
+            return;
+        }
+
+        struct arena block;
+        void *mem = calloc(1, SESSION_BYTES);
+        if (mem == NULL || heap_reserve(d, d->sessions + 1) != 0) {
+            free(mem);
+            close(fd);
+            continue;
+        }
+        arena_init(&block, mem, SESSION_BYTES);
+        struct session *s = arena_alloc(&block, sizeof(*s));
+        s->shown = arena_array(&block, GAME_CANVAS_ROWS * GAME_CANVAS_COLS, sizeof(*s->shown));
+        s->pending = arena_alloc(&block, RENDER_OUT_MAX(GAME_CANVAS_ROWS, GAME_CANVAS_COLS));
+        s->fd = fd;
+        input_init(&s->keys, fd);
+        s->repaint = 1;
+        s->id = ++d->next_id;
+        s->mode = SESSION_MENU;
+        s->heap_pos = -1;
+        s->dirty = 1;
+
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLRDHUP, .data.ptr = s };
+        if (epoll_ctl(d->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            free(s);
+            continue;
+        }
+        s->next = d->list;
+        if (d->list != NULL) {
+            d->list->prev = s;
+        }
+        d->list = s;
+        d->sessions++;
+        session_flush(d, s);
+    }
+}
+
+// Function to disconnect a session and free everything it holds
+static void close_session(struct daemon *d, struct session *s) {
+    if (s->mode != SESSION_MENU) {
+        session_end_game(d, s);
+    }
+    epoll_ctl(d->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+    close(s->fd);
+    if (s->prev != NULL) {
+        s->prev->next = s->next;
+    } else {
+        d->list = s->next;
+    }
+    if (s->next != NULL) {
+        s->next->prev = s->prev;
+    }
+    free(s);  // The block that also holds shown and pending
+    d->sessions--;
+}
+
+// Function to read and apply the keys of a session
+static int session_read(struct daemon *d, struct session *s) {
+    unsigned char bytes[DAEMON_READ_MAX];
+
+    ssize_t n = read(s->fd, bytes, sizeof(bytes));
+    if (n == 0) {
+        return -1;  // Terminal went away
+    }
+    if (n < 0) {
+        return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    }
+
+    // A sequence cut short by the end of the read is finished by the next one;
+    // the loop never waits, so a lone ESC is only seen with the key after it
+    input_feed(&s->keys, bytes, n);
+    for (int key = input_next(&s->keys, 0); key != INPUT_NONE; key = input_next(&s->keys, 0)) {
+        if (session_key(d, s, key) < 0) {
+            return -1;
+        }
+    }
+    return session_flush(d, s);
+}
+
+// Function to run every tick that is due
+static void run_ticks(struct daemon *d, long long now) {
+    while (d->heap_len > 0 && d->heap[0]->next_tick <= now) {
+        struct session *s = d->heap[0];
+        long long period = (long long)game_tick_ms(s->game.plugin) * 1000000LL;
+
+        // Ticks missed while the loop was busy are skipped rather than replayed
+        do {
+            s->next_tick += period;
+        } while (s->next_tick <= now);
+        heap_fix(d, 0);
+
+        session_status(d, s, s->game.plugin->tick(s->game.state));
+        s->dirty = 1;
+        if (session_flush(d, s) < 0) {
+            close_session(d, s);
+        }
+    }
+}
+
+// Function to load every plugin of the games directory
+static int load_games(struct daemon *d, const char *games_dir) {
+    struct catalog games = {0};
+    char path[PATH_MAX];
+
+    if (catalog_load(&games, games_dir) < 0) {
+        return -1;
+    }
+    for (int i = 0; i < games.count && d->game_count < DAEMON_MAX_GAMES; i++) {
+        if (!games.entries[i].plugin) {
+            continue;  // Executables need a process of their own
+        }
+        snprintf(path, sizeof(path), "%s/%s", games_dir, games.entries[i].name);
+        void *handle;
+        const struct game_plugin *p = game_plugin_open(path, &handle);
+        if (p != NULL && (p->flags & GAME_FLAG_OWN_PROCESS)) {
+            dlclose(handle);  // Hosting it would cost every other session its share of the loop
+            continue;
+        }
+        if (p != NULL) {
+            d->games[d->game_count] = p;
+            d->handles[d->game_count] = handle;
+            d->game_count++;
+        }
+    }
+    catalog_free(&games);
+    return d->game_count;
+}
+
+// Function to create the listening socket
+static int listen_on(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        perror("Failed to listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Function to print how the daemon is doing
+static void print_stats(const struct daemon *d) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    fprintf(stderr, "daemon: %d sessions, %lld frames, %lld KB sent, %lld merged, "
+                    "cpu %.2f s, peak rss %ld KB\n",
+            d->sessions, d->frames, d->bytes / 1024, d->merged,
+            ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6,
+            ru.ru_maxrss);
+}
+
+// Function to serve sessions until SIGINT or SIGTERM
+int daemon_run(const char *path, const char *games_dir) {
+    struct daemon *d = calloc(1, sizeof(*d));
+    struct epoll_event events[DAEMON_EVENTS];
+    sigset_t mask;
+
+    if (d == NULL) {
+        return 1;
+    }
+    raise_fd_limit();
+    if (load_games(d, games_dir) <= 0) {
+        fprintf(stderr, "No game plugins in %s\n", games_dir);
+        free(d);
+        return 1;
+    }
+
+    d->listen_fd = listen_on(path);
+    if (d->listen_fd < 0) {
+        free(d);
+        return 1;
+    }
+
+    // Signals arrive as events of the loop like everything else
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    d->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    d->epfd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &d->listen_fd };
+    epoll_ctl(d->epfd, EPOLL_CTL_ADD, d->listen_fd, &ev);
+    ev.data.ptr = &d->signal_fd;
+    epoll_ctl(d->epfd, EPOLL_CTL_ADD, d->signal_fd, &ev);
+
+    fprintf(stderr, "daemon: serving %d games on %s, %zu KB per terminal plus its game\n", d->game_count, path,
+            SESSION_BYTES / 1024);
+    long long next_stats = now_ns() + DAEMON_STATS_MS * 1000000LL;
+    int running = 1;
+    while (running) {
+        long long now = now_ns();
+        long long wake = next_stats;
+        if (d->heap_len > 0 && d->heap[0]->next_tick < wake) {
+            wake = d->heap[0]->next_tick;
+        }
+        int timeout = wake > now ? (int)((wake - now + 999999) / 1000000) : 0;
+
+        int n = epoll_wait(d->epfd, events, DAEMON_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &d->listen_fd) {
+                accept_sessions(d);
+                continue;
+            }
+            if (ptr == &d->signal_fd) {
+                running = 0;
+                continue;
+            }
+
+            struct session *s = ptr;
+            int failed = 0;
+            if (events[i].events & EPOLLOUT) {
+                failed = session_drain(d, s) < 0;
+            }
+            if (!failed && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                failed = session_read(d, s) < 0;
+            }
+            if (failed) {
+                close_session(d, s);
+            }
+        }
+
+        now = now_ns();
+        run_ticks(d, now);
+        if (now >= next_stats) {
+            print_stats(d);
+            next_stats = now + DAEMON_STATS_MS * 1000000LL;
+        }
+    }
+
+    print_stats(d);
+
+    // Disconnect everyone
+    close(d->listen_fd);
+    unlink(path);
+    while (d->list != NULL) {
+        close_session(d, d->list);
+    }
+
+    close(d->signal_fd);
+    close(d->epfd);
+    for (int i = 0; i < d->game_count; i++) {
+        dlclose(d->handles[i]);
+    }
+    free(d->heap);
+    free(d);
+    return 0;
+}
+
+// Load generator connection
+struct load_client {
+    int fd;
+    int waiting;           // A key was sent and no frame came back yet
+    long long sent_ns;     // When the key was sent, or when the next one is due
+    struct load_client *next_due;
+};
+
+// Function to compare two latencies for qsort()
+static int compare_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+// Function to connect one load generator session, retrying while the backlog is full
+static int load_connect(const char *path) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    for (int tries = 0; tries < 1000; tries++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            return fd;
+        }
+        int err = errno;
+        close(fd);
+        if (err != EAGAIN) {
+            errno = err;
+            return -1;
+        }
+        usleep(1000);
+    }
+    return -1;
+}
+
+// Function to drive many sessions against a running daemon and report latency
+int daemon_loadgen(const char *path, int sessions, int seconds) {
+    struct epoll_event events[DAEMON_EVENTS];
+    char buf[4096];
+    const char keys[] = "1wasd";
+
+    raise_fd_limit();
+    struct load_client *clients = calloc(sessions, sizeof(*clients));
+    long long *samples = malloc(LOADGEN_SAMPLES * sizeof(*samples));
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (clients == NULL || samples == NULL || epfd < 0) {
+        free(clients);
+        free(samples);
+        return 1;
+    }
+
+    // Sessions whose next key is due are kept in a FIFO: every session waits
+    // the same interval, so the queue stays ordered by due time
+    struct load_client *due_head = NULL, *due_tail = NULL;
+    int connected = 0;
+    for (int i = 0; i < sessions; i++) {
+        clients[i].fd = load_connect(path);
+        if (clients[i].fd < 0) {
+            perror("connect");
+            break;
+        }
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &clients[i] };
+        epoll_ctl(epfd, EPOLL_CTL_ADD, clients[i].fd, &ev);
+        clients[i].waiting = 1;  // The menu comes first
+        clients[i].sent_ns = now_ns();
+        connected++;
+    }
+    fprintf(stderr, "loadgen: %d of %d sessions connected\n", connected, sessions);
+
+    long long interval = LOADGEN_INTERVAL_MS * 1000000LL;
+    long long start = now_ns();
+    long long end = start + (long long)seconds * 1000000000LL;
+    long long sent = 0, answered = 0, received = 0;
+    int nsamples = 0;
+    int outstanding = connected;   // Keys (and initial menus) not answered yet
+    unsigned int rng = 1;
+
+    // Stop pressing keys at the end, then give the answers in flight a second to arrive
+    for (;;) {
+        int n = epoll_wait(epfd, events, DAEMON_EVENTS, 1);
+        long long now = now_ns();
+        if (now >= end + 1000000000LL || (now >= end && outstanding == 0)) {
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            struct load_client *c = events[i].data.ptr;
+            ssize_t got;
+            while ((got = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+                received += got;
+            }
+            if (got == 0) {
+                fprintf(stderr, "loadgen: daemon closed a session\n");
+                epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+                continue;
+            }
+            if (c->waiting) {
+                outstanding--;
+                if (nsamples < LOADGEN_SAMPLES) {
+                    samples[nsamples++] = now - c->sent_ns;
+                }
+                answered++;
+                c->waiting = 0;
+                c->sent_ns = now + interval;
+                c->next_due = NULL;
+                if (due_tail != NULL) {
+                    due_tail->next_due = c;
+                } else {
+                    due_head = c;
+                }
+                due_tail = c;
+            }
+        }
+
+        // Press the next key of every session that is due
+        while (now < end && due_head != NULL && due_head->sent_ns <= now) {
+            struct load_client *c = due_head;
+            due_head = c->next_due;
+            if (due_head == NULL) {
+                due_tail = NULL;
+            }
+
+            rng = rng * 1103515245u + 12345u;
+            char key = keys[(rng >> 16) % (sizeof(keys) - 1)];
+            if (send(c->fd, &key, 1, MSG_NOSIGNAL) == 1) {
+                c->waiting = 1;
+                c->sent_ns = now_ns();
+                outstanding++;
+                sent++;
+            }
+        }
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+    if (elapsed > seconds) {
+        elapsed = seconds;  // Keys were only sent until the end
+    }
+
+    qsort(samples, nsamples, sizeof(*samples), compare_ll);
+    printf("loadgen: %d sessions for %.1f s, %lld keys sent, %lld frames answered, %.0f KB/s received\n",
+           connected, elapsed, sent, answered - connected, received / 1024.0 / elapsed);
+    if (nsamples > 0) {
+        printf("key-to-frame latency: p50 %.1f us, p99 %.1f us, max %.1f us\n",
+               samples[nsamples / 2] / 1e3, samples[(int)(nsamples * 0.99)] / 1e3,
+               samples[nsamples - 1] / 1e3);
+    }
+
+    int unanswered = 0;
+    for (int i = 0; i < connected; i++) {
+        unanswered += clients[i].waiting;
+        close(clients[i].fd);
+    }
+    close(epfd);
+    free(clients);
+    free(samples);
+    return connected == sessions && unanswered == 0 ? 0 : 1;
+}
@@ -0,0 +1,19 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+// Default socket the console daemon listens on
+#define DAEMON_SOCKET "vgc-console.sock"
+
+// Serve terminals connecting to the Unix socket at path from one epoll loop.
+// Every game_*.so plugin in games_dir is loaded once and its sessions run
+// inside the loop; a client is any raw terminal, e.g.
+//   socat -,raw,echo=0 UNIX-CONNECT:vgc-console.sock
+// Returns 0 after SIGINT or SIGTERM, 1 if the daemon could not start.
+int daemon_run(const char *path, const char *games_dir);
+
+// Open sessions connections to the daemon at path and have each one press a
+// key every 100 ms for seconds seconds, then report the key-to-frame latency.
+// Returns 0 if every session got an answer to every key.
+int daemon_loadgen(const char *path, int sessions, int seconds);
+
+#endif
@@ -1,44 +1,157 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <dirent.h>
 #include <string.h>
+#include <poll.h>
 #include <signal.h>
-#include <termios.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 
-#define MAX_GAMES 10
-#define MAX_GAME_NAME_LEN 100
+#include "autopilot.h"
+#include "catalog.h"
+#include "daemon.h"
+#include "input.h"
+#include "launch.h"
+#include "menu.h"
+#include "render.h"
 
-int selected_game = 0;  // Keeps track of the selected game index
+#define GAMES_DIR "mount"
+#define MAX_GAME_NAME_LEN 256
+#define METRICS_FILE "launch_metrics.csv"
+#define STATS_DIR "stats"  // Per-game resource usage logs
+#define SNAPSHOT_DIR GAMES_DIR "/.snapshots"  // Suspended games, kept across launcher restarts
+#define MAX_SUSPENDED 8
+#define ATTRACT_ENV "VGC_ATTRACT_MS"  // Milliseconds without a key before the menu shows a demo, 0 for never
+#define ATTRACT_MS 60000
+#define ATTRACT_GAME "Snake Game"     // Title of the game that plays itself in the demo
+#define ATTRACT_STRATEGY "shortcut"   // and how it steers, see autopilot.h
+#define MENU_IDLE -2                  // Returned by get_menu_input() once the menu was left alone long enough
+
+// A game put aside with Ctrl-Z, resumed when it is selected again
+struct suspended_game {
+    char name[MAX_GAME_NAME_LEN];
+    struct launch_job job;
+};
+
+struct menu menu;  // Keeps track of the search and the selected game
+struct render screen;  // Launcher screen; only cells that change are redrawn
+int compositor_mode = 0;  // Set by --compositor: games draw into shared memory, the launcher owns the terminal
+struct suspended_game suspended[MAX_SUSPENDED];
+int suspended_count = 0;
+int attract_ms = ATTRACT_MS;
 
 // Function to get user input
-char get_input() {
-    struct termios oldt, newt;
-    char ch;
-    
-    tcgetattr(STDIN_FILENO, &oldt);  // Get current terminal settings
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);  
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);  // Apply the new settings
-
-    ch = getchar();  // Read one character of input
-
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);  // Restore terminal settings
-    return ch;
+int get_input() {
+    int key;
+
+    fflush(stdout);
+    do {
+        key = input_read(input_stdin(), -1);  // The terminal stays in key mode the whole time
+    } while (key == INPUT_NONE);
+    return key;
 }
 
-// Function to display the list of games
-void display_games(char *games[], int game_count) {
-    printf("\033[H\033[J");  // Clear screen 
-    printf("WELCOME TO ATARI\n");
-    printf("Use 'w' and 's' to select a game, 'Enter' to start, and 'q' to exit.\n\n");
+// Function to draw the launcher screen and send what changed since the last redraw
+void draw_games() {
+    struct game_canvas *c = render_begin(&screen);
+
+    canvas_puts(c, "WELCOME TO ATARI\n");
+    canvas_puts(c, "Use 'w' and 's' to select a game, '/' to search, 'Enter' to start, and 'q' to exit.\n");
 
     // Display the list of games
-    for (int i = 0; i < game_count; i++) {
-        if (i == selected_game) {
-            printf("-> %s\n", games[i]);  
-        } else {
-            printf("   %s\n", games[i]);
+    menu_render(&menu, c);
+    fflush(stdout);  // Text printed before goes out ahead of the frame
+    render_flush(&screen);
+}
+
+// Function to display the list of games
+void display_games() {
+    render_invalidate(&screen);  // Clear screen
+    draw_games();
+}
+
+// Function to get the number of menu rows that fit on the terminal
+int visible_rows() {
+    int rows, cols;
+    render_term_size(STDOUT_FILENO, &rows, &cols);
+    return rows > MENU_TOP ? rows - MENU_TOP + 1 : 1;
+}
+
+// Function to apply changes to the games directory and redraw the rows they touched
+void refresh_games(struct catalog *games, int watch_fd) {
+    char selected_name[MAX_GAME_NAME_LEN] = "";
+    int selected = menu_selected(&menu);
+
+    if (selected >= 0) {
+        snprintf(selected_name, sizeof(selected_name), "%s", games->entries[selected].name);
+    }
+
+    if (catalog_apply_events(games, GAMES_DIR, watch_fd) < 0) {
+        return;
+    }
+
+    // Keep the cursor on the same game; only rows whose content changed are redrawn
+    menu_reindex(&menu, selected_name);
+    draw_games();
+}
+
+// Function to wait for a key while keeping the list in sync with the games directory,
+// MENU_IDLE if none came for attract_ms
+int get_menu_input(struct catalog *games, int watch_fd) {
+    struct input *in = input_stdin();
+    long long idle_since = launch_now_ns();
+
+    fflush(stdout);
+    while (1) {
+        // Keys that came in the same read as the last one go first
+        int key = input_next(in, 0);
+        if (key != INPUT_NONE) {
+            return key;
+        }
+
+        // With the start of an escape sequence pending, wait only briefly for its end
+        struct pollfd fds[2] = {
+            { .fd = STDIN_FILENO, .events = POLLIN },
+            { .fd = watch_fd, .events = POLLIN },
+        };
+        int partial = in->pos < in->len;
+        int timeout = partial ? INPUT_ESC_MS : -1;
+
+        // Left alone long enough, the menu hands over to the demo
+        if (attract_ms > 0 && !partial) {
+            long long left = attract_ms - (launch_now_ns() - idle_since) / 1000000;
+            if (left <= 0) {
+                return MENU_IDLE;
+            }
+            timeout = (int)left;
+        }
+
+        // A frame held back for a slow terminal is sent once the link had time to drain
+        int held = render_wait_ms(&screen);
+        if (held >= 0 && (timeout < 0 || held < timeout)) {
+            timeout = held;
+        }
+        int ready = poll(fds, 2, timeout);
+        if (held >= 0) {
+            render_flush(&screen);
+        }
+        if (ready == 0) {
+            if (partial && timeout == INPUT_ESC_MS) {
+                return input_next(in, 1);  // A lone ESC
+            }
+            continue;
+        }
+        if (ready < 0) {
+            continue;  // Interrupted by a signal
+        }
+        if (fds[1].revents & POLLIN) {
+            refresh_games(games, watch_fd);
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP)) {
+            key = input_read(in, 0);
+            if (key != INPUT_NONE) {
+                return key == INPUT_EOF ? -1 : key;  // End of input leaves the launcher
+            }
         }
     }
 }
@@ -51,82 +164,265 @@ void handle_signal(int sig) {
     }
 }
 
-// Function to load games from the mount directory
-int load_games(char *games[]) {
-    DIR *dir;
-    struct dirent *entry;
-    int game_count = 0;
-
-    dir = opendir("mount");
-    if (dir == NULL) {
-        perror("Failed to open directory");
-        return -1;
-    }
-
-    while ((entry = readdir(dir)) != NULL) {
-        if (strncmp(entry->d_name, "game_", 5) == 0) {  // Check if file starts with "game_"
-            games[game_count] = strdup(entry->d_name);  // Store game name
-            game_count++;
+// Function to find a suspended game by file name, returns its slot or -1
+int find_suspended(const char *name) {
+    for (int i = 0; i < suspended_count; i++) {
+        if (strcmp(suspended[i].name, name) == 0) {
+            return i;
         }
     }
-
-    closedir(dir);
-    return game_count;
+    return -1;
 }
 
 // Function to execute the selected game
-void execute_game(const char *game_name) {
-    printf("\033[H\033[J");  // Clear screen before launching the game
-    printf("Starting game: %s\n", game_name);
+void execute_game(const struct catalog_entry *game, long long keypress_ns) {
+    char path[MAX_GAME_NAME_LEN + 20];
+    char snapshot[MAX_GAME_NAME_LEN + 32];
+    struct launch_result res;
+    struct launch_job job;
+    int started;
+
+    snprintf(path, sizeof(path), "./%s/%s", GAMES_DIR, game->name);
+    snprintf(snapshot, sizeof(snapshot), "%s/%s.snap", SNAPSHOT_DIR, game->name);
 
-    char command[MAX_GAME_NAME_LEN + 20];
+    render_sync(&screen);  // The menu is on the terminal before the game writes to it
+    printf("\033[H\033[J");  // Clear screen before launching the game
+    int slot = find_suspended(game->name);
+    if (slot >= 0) {
+        // Carry on with the stopped process or the session kept in memory
+        printf("Resuming game: %s\n", game->title);
+        started = launch_resume(&suspended[slot].job, keypress_ns, &res);
+        if (!res.suspended) {
+            suspended[slot] = suspended[--suspended_count];
+        }
+    } else {
+        printf("Starting game: %s (Ctrl-Z to suspend)\n", game->title);
+        if (game->plugin) {
+            started = launch_plugin(&job, path, snapshot, keypress_ns, &res);  // Run the game inside this process
+        } else if (compositor_mode) {
+            started = launch_composited(&job, path, snapshot, keypress_ns, &res);  // Composite the game's frames ourselves
+        } else {
+            started = launch_game(&job, path, snapshot, keypress_ns, &res);  // Run the game directly, without a shell
+        }
 
-    sprintf(command, "./mount/%s", game_name);
-    system(command);  // Execute the game
+        // Keep a suspended game around; without room its snapshot still brings it back later
+        if (started == 0 && res.suspended) {
+            if (suspended_count < MAX_SUSPENDED) {
+                snprintf(suspended[suspended_count].name, MAX_GAME_NAME_LEN, "%s", game->name);
+                suspended[suspended_count++].job = job;
+            } else {
+                launch_discard(&job);
+            }
+        }
+    }
+    if (started == 0) {
+        launch_log_metrics(METRICS_FILE, game->name, &res);
+        if (!res.suspended) {
+            launch_log_usage(STATS_DIR, game->name, &res);
+        }
+    }
 
     // Added line to display the score
-    
+    if (WIFSIGNALED(res.status)) {
+        printf("\nGame terminated by signal %d.\n", WTERMSIG(res.status));
+    }
+    if (started == 0 && res.suspended) {
+        printf("\nGame suspended. Select it again to resume.\n");
+        printf("Press any key to continue...\n");
+        get_input();
+        return;
+    }
+    if (started == 0) {
+        launch_print_usage(&res);
+    }
 
     printf("\nGame exited. Returning to the main menu...\n");
     printf("Press any key to continue...\n");
     get_input();  // Wait for user input before returning to the menu
 }
 
-int main() {
+// Function to let the snake play itself until a key is pressed
+void attract_mode(const struct catalog *games) {
+    const struct catalog_entry *game = NULL;
+    char path[MAX_GAME_NAME_LEN + 20];
+    struct launch_result res;
+    struct launch_job job;
+    int started;
+
+    // The plugin if there is one, it starts quickest
+    for (int i = 0; i < games->count; i++) {
+        if (strcmp(games->entries[i].title, ATTRACT_GAME) == 0 && (game == NULL || games->entries[i].plugin)) {
+            game = &games->entries[i];
+        }
+    }
+    if (game == NULL) {
+        return;
+    }
+    snprintf(path, sizeof(path), "./%s/%s", GAMES_DIR, game->name);
+
+    render_sync(&screen);
+    printf("\033[H\033[J");
+    setenv(AUTOPILOT_ENV, ATTRACT_STRATEGY, 1);  // Games run in-process or spawned both find it here
+    if (game->plugin) {
+        started = launch_plugin(&job, path, NULL, launch_now_ns(), &res);
+    } else if (compositor_mode) {
+        started = launch_composited(&job, path, NULL, launch_now_ns(), &res);
+    } else {
+        started = launch_game(&job, path, NULL, launch_now_ns(), &res);
+    }
+    unsetenv(AUTOPILOT_ENV);
+    if (started == 0 && res.suspended) {
+        launch_discard(&job);
+    }
+}
+
+// Function to check the given plugins, or those in the games directory, for allocations while they run
+int bench_alloc(int count, char **paths) {
+    struct catalog catalog = {0};
+    char names[64][MAX_GAME_NAME_LEN + 20];
+    const char *list[64];
+
+    if (count > 0) {
+        return game_alloc_bench((const char *const *)paths, count);
+    }
+    catalog_load(&catalog, GAMES_DIR);
+    for (int i = 0; i < catalog.count && count < 64; i++) {
+        if (catalog.entries[i].plugin) {
+            snprintf(names[count], sizeof(names[count]), "./%s/%s", GAMES_DIR, catalog.entries[i].name);
+            list[count] = names[count];
+            count++;
+        }
+    }
+    catalog_free(&catalog);
+    return game_alloc_bench(list, count);
+}
+
+int main(int argc, char *argv[]) {
+    // Board size of the games started from here, e.g. --board 60x20; they find it in the environment
+    if (argc >= 3 && strcmp(argv[1], "--board") == 0) {
+        struct game_board board;
+        if (game_board_parse(argv[2], &board) != 0) {
+            fprintf(stderr, "Invalid board size '%s', expected WIDTHxHEIGHT\n", argv[2]);
+            return 1;
+        }
+        setenv(GAME_BOARD_ENV, argv[2], 1);
+        argv[2] = argv[0];
+        argc -= 2;
+        argv += 2;
+    }
+
+    // Build the catalog manifest when the image is created
+    if (argc == 3 && strcmp(argv[1], "--build-catalog") == 0) {
+        struct catalog catalog = {0};
+        int ok = catalog_scan(&catalog, argv[2]) >= 0 && catalog_write(&catalog, argv[2]) == 0;
+        catalog_free(&catalog);
+        return ok ? 0 : 1;
+    }
+
+    // Measure search and redraw time over a large synthetic catalog
+    if (argc >= 2 && strcmp(argv[1], "--bench-menu") == 0) {
+        return menu_bench(argc >= 3 ? atoi(argv[2]) : 10000);
+    }
+
+    // Check the key decoder against bursts of pasted and repeated keys
+    if (argc >= 2 && strcmp(argv[1], "--bench-input") == 0) {
+        return input_bench();
+    }
+
+    // Measure the game loop's tick timing, catch-up and idle cost
+    if (argc >= 2 && strcmp(argv[1], "--bench-loop") == 0) {
+        return game_loop_bench();
+    }
+
+    // Compare frame dropping against sending every frame over a throttled pseudo-terminal
+    if (argc >= 2 && strcmp(argv[1], "--bench-render") == 0) {
+        return render_bench(argc >= 3 ? atoi(argv[2]) : 8000);
+    }
+
+    // Compare missed ticks with and without the render thread on a terminal that blocks
+    if (argc >= 2 && strcmp(argv[1], "--bench-threads") == 0) {
+        return game_thread_bench(argc >= 3 ? atoi(argv[2]) : 64000);
+    }
+
+    // Check that the game plugins allocate nothing after their first frame
+    if (argc >= 2 && strcmp(argv[1], "--bench-alloc") == 0) {
+        return bench_alloc(argc - 2, argv + 2);
+    }
+
+    // Serve many terminals from one process over a Unix socket
+    if (argc >= 2 && strcmp(argv[1], "--daemon") == 0) {
+        return daemon_run(argc >= 3 ? argv[2] : DAEMON_SOCKET, GAMES_DIR);
+    }
+
+    // Measure a running daemon with many simulated terminals
+    if (argc >= 2 && strcmp(argv[1], "--loadgen") == 0) {
+        return daemon_loadgen(argc >= 5 ? argv[4] : DAEMON_SOCKET,
+                              argc >= 3 ? atoi(argv[2]) : 1000, argc >= 4 ? atoi(argv[3]) : 10);
+    }
+
+    compositor_mode = argc >= 2 && strcmp(argv[1], "--compositor") == 0;
+    if (getenv(ATTRACT_ENV) != NULL) {
+        attract_ms = atoi(getenv(ATTRACT_ENV));
+    }
+    input_mode(INPUT_KEYS);  // Held until exit, which restores the terminal even after a crash
+
     signal(SIGINT, handle_signal);
     signal(SIGTERM, handle_signal);
 
-    char *games[MAX_GAMES];
-    int game_count = load_games(games);
+    struct catalog games = {0};
+    int game_count = catalog_load(&games, GAMES_DIR);
+    int watch_fd = catalog_watch(GAMES_DIR);  // Picks up games pushed while the launcher runs
 
     if (game_count <= 0) {
         printf("No games found in the 'bin' directory.\n");
         return 1;
     }
 
-    char input;
-    while (1) {
-        display_games(games, game_count);
+    mkdir(SNAPSHOT_DIR, 0755);  // Fails harmlessly if it exists or the disk is read-only
 
-        input = get_input(); //get user input
+    int rows, cols;
+    render_term_size(STDOUT_FILENO, &rows, &cols);
+    menu_init(&menu, &games, visible_rows());
+    render_init(&screen, STDOUT_FILENO, MENU_TOP - 1 + menu.rows, cols);
+    display_games();
 
-        // Handle user navigation and game start
-        if (input == 'w' && selected_game > 0) {
-            selected_game--;  // Move up
-        } else if (input == 's' && selected_game < game_count - 1) {
-            selected_game++;  // Move down
-        } else if (input == 'q') {
+    while (1) {
+        int input = get_menu_input(&games, watch_fd); //get user input
+        if (input == MENU_IDLE) {
+            attract_mode(&games);
+            display_games();
+            continue;
+        }
+        if (input < 0) {
+            break;  // Input closed
+        }
+
+        // Handle user navigation, search and game start
+        int action = menu_handle_key(&menu, input);
+        if (action == MENU_QUIT) {
             break;  // Exit program
-        } else if (input == '\n') {
+        } else if (action == MENU_LAUNCH) {
             // Start the selected game
-            execute_game(games[selected_game]);
+            execute_game(&games.entries[menu_selected(&menu)], launch_now_ns());
+            display_games();
+        } else {
+            draw_games();  // Only what the key changed is sent
         }
     }
 
-    // Free dynamically allocated memory for game names
-    for (int i = 0; i < game_count; i++) {
-        free(games[i]);
+    // End suspended games; their snapshots bring them back next time
+    for (int i = 0; i < suspended_count; i++) {
+        launch_discard(&suspended[i].job);
+    }
+
+    // Free the catalog
+    if (watch_fd >= 0) {
+        close(watch_fd);
     }
+    menu_free(&menu);
+    render_sync(&screen);
+    render_free(&screen);
+    catalog_free(&games);
 
     return 0;
 }
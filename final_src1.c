@@ -1,240 +1,568 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
-#include <termios.h>
-#include <signal.h>
+#include <string.h>
 #include <time.h>
 
-#define WIDTH 30
-#define HEIGHT 10
+#include "autopilot.h"
+#include "game_plugin.h"
+#include "snake.h"
+#ifndef GAME_PLUGIN_BUILD
+#include "game_runtime.h"
+#endif
 
-// Snake structure
-typedef struct Snake {
-    int *x,*y,length,capacity;
-} Snake;
+#define WIDTH 30      // Board played when no size is asked for
+#define HEIGHT 10
+#define MIN_SIDE 4
+#define MAX_WIDTH GAME_CANVAS_COLS
+#define MAX_HEIGHT (GAME_CANVAS_ROWS - 6)  // Room left for the title, the score and the messages
+#define SPEED_MS 150  // Time per step, VGC_TICK_MS overrides it
+#define TURNS 3       // Turns remembered for the next steps
+
+// What is drawn in a cell of the board
+#define CELL_EMPTY '.'
+#define CELL_HEAD 'O'
+#define CELL_BODY '#'
+#define CELL_FOOD 'X'
 
 // Game variables
-int food_x, food_y, score=0;
-char **board;
-struct termios oldt, newt;
-Snake snake;
-
-// Function to restore terminal settings
-void restore_terminal() {
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+typedef struct SnakeGame {
+    struct snake snake;         // Body and board, sized by snake_configure()
+    int food_x, food_y;         // -1 once the snake fills the board
+    int score;
+    int over;     // Set when the game ended
+    int crashed;  // Set when the snake hit the border or itself
+    char direction;     // Where the snake heads, 0 until the first key
+    char turns[TURNS];  // Keys pressed since the last step, taken one per step
+    int turn_count;
+    struct autopilot *autopilot;  // Steers instead of the keys when AUTOPILOT_ENV names a strategy
+    long long decide_ns;          // Time the autopilot took over all its moves
+    long long decide_max_ns;      // and over its slowest one
+    long long decisions;
+} SnakeGame;
+
+// Function to read the monotonic clock in nanoseconds
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
 }
 
-// Signal handler for graceful exit
-void handle_exit(int sig) {
-    restore_terminal();
-    printf("\nExiting...\n");
-    free(snake.x);
-    free(snake.y);
+// Function to draw one cell of the board over what draw_board() put there
+static inline void draw_cell(struct game_canvas *c, int top, int x, int y, int cols, char ch) {
+    if (x >= 0 && x < cols && top + y < c->rows) {
+        c->cells[(top + y) * c->cols + x].ch = ch;
+    }
+}
 
-    //allocating the memory
-    for (int i = 0; i < HEIGHT; i++) {
-        free(board[i]);
+// Function to draw each row of the board from the occupancy bits, clipped to
+// the canvas, then the head and the food over them
+static void draw_board(const SnakeGame *g, struct game_canvas *c) {
+    // Copied to locals: the cells are chars, which the compiler must assume alias everything
+    const struct snake *s = &g->snake;
+    int width = s->width, cols = width < c->cols ? width : c->cols;
+    int top = c->row;
+    int rows = s->height < c->rows - top ? s->height : c->rows - top;
+    unsigned char style = c->style;
+    struct game_cell *out = &c->cells[top * c->cols];
+
+    for (int i = 0; i < rows; i++, out += c->cols) {
+        uint32_t cell = (uint32_t)(i * width);
+        for (int j = 0; j < cols; j++) {
+            out[j] = (struct game_cell){ snake_occupied(s, cell + j) ? CELL_BODY : CELL_EMPTY, style };
+        }
     }
-    free(board);
+    draw_cell(c, top, s->head_x, s->head_y, cols, CELL_HEAD);
+    draw_cell(c, top, g->food_x, g->food_y, cols, CELL_FOOD);
+    c->row = top + s->height;
+    c->col = 0;
+}
 
-    exit(0);
+// Function to print the game board
+void print_board(const SnakeGame *g, struct game_canvas *c) {
+    canvas_style(c, GAME_STYLE_TITLE);
+    canvas_puts(c, "Snake Game");
+    canvas_style(c, GAME_STYLE_PLAIN);
+    canvas_puts(c, "\n\n");
+    canvas_printf(c, "Score: %d", g->score);
+    if (g->autopilot != NULL) {
+        canvas_printf(c, "   Autopilot %s: %lld ns per move, %lld at most", g->autopilot->strategy->name,
+                      g->decisions > 0 ? g->decide_ns / g->decisions : 0, g->decide_max_ns);
+    }
+    canvas_putc(c, '\n');
+    draw_board(g, c);
 }
 
-// Function to clear the screen
-void clear_screen() {
-    printf("\033[H\033[J");
+// Function to generate a random position for food
+void generate_food(SnakeGame *g) {
+    long cell = snake_free_cell(&g->snake, (unsigned long)rand());
+
+    g->food_x = cell < 0 ? -1 : (int)(cell % g->snake.width);
+    g->food_y = cell < 0 ? -1 : (int)(cell / g->snake.width);
 }
 
-// Function to print the game board
-void print_board() {
-    clear_screen();
-    printf("\033[1;34mSnake Game\033[0m\n\n");
-    printf("Score: %d\n", score);
-
-    for (int i = 0; i < HEIGHT; i++) {
-        for (int j = 0; j < WIDTH; j++) {
-            int printed = 0;
-
-            // Print snake head
-            if (snake.x[0] == j && snake.y[0] == i) {
-                printf("O");
-                printed = 1;
-            }
+// Function to move the snake
+int move_snake(SnakeGame *g, char direction) {
+    const char *dir = strchr("wdsa", direction);  // In the order of enum snake_dir
 
-            // Print snake body (tail)
-            for (int k = 1; k < snake.length; k++) {
-                if (snake.x[k] == j && snake.y[k] == i) {
-                    printf("#");
-                    printed = 1;
-                    break;
-                }
-            }
+    if (direction == 0 || dir == NULL) {
+        return 1; // Not a movement key
+    }
 
-            // Print food
-            if (!printed) {
-                if (food_x == j && food_y == i) {
-                    printf("X");
-                    printed = 1;
-                }
-            }
+    // Step the head, growing the snake if it eats the food
+    uint32_t food = g->food_x < 0 ? UINT32_MAX : (uint32_t)(g->food_y * g->snake.width + g->food_x);
+    int step = snake_step(&g->snake, (int)(dir - "wdsa"), food);
+    if (step == SNAKE_CRASHED) {
+        return 0;
+    }
+    if (step == SNAKE_ATE) {
+        g->score++;
+        generate_food(g);
+    }
 
-            // Print empty space
-            if (!printed) {
-                printf(".");
-            }
+    return 1; // Move successful
+}
+
+// Function to settle the board size: the default for what is not asked, clamped to fit the canvas
+static int snake_configure(struct game_board *board, size_t *arena_size) {
+    int *side[2] = { &board->width, &board->height };
+    int fallback[2] = { WIDTH, HEIGHT };
+    int most[2] = { MAX_WIDTH, MAX_HEIGHT };
+
+    for (int i = 0; i < 2; i++) {
+        if (*side[i] <= 0) {
+            *side[i] = fallback[i];
         }
-        printf("\n");
+        *side[i] = *side[i] < MIN_SIDE ? MIN_SIDE : *side[i] > most[i] ? most[i] : *side[i];
+    }
+    *arena_size = snake_arena_size(board->width, board->height);
+    if (autopilot_find(getenv(AUTOPILOT_ENV)) != NULL) {
+        *arena_size += arena_round(sizeof(struct autopilot)) + autopilot_arena_size(board->width, board->height);
     }
+    return 0;
 }
 
-// Function to generate a random position for food 
-void generate_food() {
-    food_x = rand() % WIDTH;
-    food_y = rand() % HEIGHT;
+// Function to take the snake from the arena, and the autopilot
+static int snake_alloc(SnakeGame *g, struct arena *arena, const struct game_board *board) {
+    const struct autopilot_strategy *strategy = autopilot_find(getenv(AUTOPILOT_ENV));
 
-    // Ensure food is not generated on the snake's body
-    for (int i = 0; i < snake.length; i++) {
-        if (snake.x[i] == food_x && snake.y[i] == food_y) {
-            generate_food();
-            return;
+    if (snake_setup(&g->snake, arena, board->width, board->height) != 0) {
+        return -1;
+    }
+    if (strategy != NULL) {
+        g->autopilot = arena_alloc(arena, sizeof(struct autopilot));
+        if (g->autopilot == NULL
+            || autopilot_setup(g->autopilot, arena, strategy, board->width, board->height) != 0) {
+            return -1;
         }
     }
+    return 0;
 }
 
-// Function to move the snake
-int move_snake(char direction) {
-    int new_x = snake.x[0];
-    int new_y = snake.y[0];
-
-    // Determine new head position based on input
-    if (direction == 'w') {
-        new_y--;
-    } else if (direction == 'a') {
-        new_x--;
-    } else if (direction == 's') {
-        new_y++;
-    } else if (direction == 'd') {
-        new_x++;
-    }
-
-    // Check if the snake gets out of the map or hits itself
-    if (new_x < 0 || new_x >= WIDTH || new_y < 0 || new_y >= HEIGHT) {
-        return 1; // Snake hit the border
-    }
-    
-    // Check if the snake hits itself
-    for (int i = 1; i < snake.length; i++) {
-        if (snake.x[i] == new_x && snake.y[i] == new_y) {
-            return 1;
-        }
+// Function to set up a new game
+static int snake_init(void *state, struct arena *arena, const struct game_board *board, unsigned int seed) {
+    SnakeGame *g = state;
+    (void)seed;  // The runtime already seeded rand()
+
+    if (snake_alloc(g, arena, board) != 0) {
+        return -1;
     }
 
-    // Move the snake
-    for (int i = snake.length - 1; i > 0; i--) {
-        snake.x[i] = snake.x[i - 1];
-        snake.y[i] = snake.y[i - 1];
+    // Initialize snake position at the middle of the board
+    snake_start(&g->snake, board->width / 2, board->height / 2);
+
+    // Generate the first food position
+    generate_food(g);
+    return 0;
+}
+
+// Function to check whether two directions point opposite ways
+static int opposite(char a, char b) {
+    return (a == 'w' && b == 's') || (a == 's' && b == 'w') || (a == 'a' && b == 'd') || (a == 'd' && b == 'a');
+}
+
+// Function to handle one key
+static int snake_handle_input(void *state, int key) {
+    SnakeGame *g = state;
+
+    if (g->autopilot != NULL) {
+        return GAME_QUIT;  // Any key ends the demo
+    }
+    if (key == 'q') {  // Exit on 'q'
+        g->over = 1;
+        return GAME_OVER;
     }
 
-    // Set the new head position
-    snake.x[0] = new_x;
-    snake.y[0] = new_y;
+    key = game_key_wasd(key);
+    if (key != 'w' && key != 'a' && key != 's' && key != 'd') {
+        return GAME_CONTINUE;
+    }
+
+    // Ignore turning back into the body and keys that change nothing
+    char last = g->turn_count > 0 ? g->turns[g->turn_count - 1] : g->direction;
+    if (key == last || (g->snake.length > 1 && opposite(key, last))) {
+        return GAME_CONTINUE;
+    }
+    if (g->turn_count < TURNS) {
+        g->turns[g->turn_count++] = key;
+    }
+    return GAME_CONTINUE;
+}
+
+// Function to let the autopilot pick the next move
+static void autopilot_turn(SnakeGame *g) {
+    uint32_t food = (uint32_t)(g->food_y * g->snake.width + g->food_x);
+    long long start = now_ns();
+    int dir = autopilot_next(g->autopilot, &g->snake, food);
+    long long took = now_ns() - start;
+
+    g->decide_ns += took;
+    g->decide_max_ns = took > g->decide_max_ns ? took : g->decide_max_ns;
+    g->decisions++;
+    g->direction = "wdsa"[dir];
+}
+
+// Function to move the snake one step
+static int snake_tick(void *state) {
+    SnakeGame *g = state;
 
-    // If the snake eats food, grow the snake
-    if (new_x == food_x && new_y == food_y) {
-        score++;
-        if (snake.length >= snake.capacity) {
-            snake.capacity *= 2;
-            snake.x = realloc(snake.x, snake.capacity * sizeof(int));
-            snake.y = realloc(snake.y, snake.capacity * sizeof(int));
+    if (g->autopilot != NULL) {
+        if (g->food_x < 0) {
+            g->over = 1;  // The snake fills the board
+            return GAME_OVER;
         }
-        snake.x[snake.length] = snake.x[snake.length - 1];
-        snake.y[snake.length] = snake.y[snake.length - 1];
-        snake.length++;
-        generate_food();
+        autopilot_turn(g);
+    }
+    if (g->turn_count > 0) {
+        g->direction = g->turns[0];
+        memmove(g->turns, g->turns + 1, --g->turn_count);
+    }
+    if (g->direction == 0) {
+        return GAME_IDLE;
     }
 
-    return 1; // Move successful
+    if (move_snake(g, g->direction) == 0) {
+        g->over = g->crashed = 1;
+        return GAME_OVER;
+    }
+    return GAME_CONTINUE;
 }
 
-// Function to get user input 
-char get_input() {
-    char ch;
-    struct termios oldt, newt;
+// Function to draw the board, or the final score once the game is over
+static void snake_draw(const void *state, struct game_canvas *c) {
+    const SnakeGame *g = state;
 
-    tcgetattr(STDIN_FILENO, &oldt);  // Get current terminal settings
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO); 
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);  // Set new terminal settings
+    print_board(g, c);
+    if (g->crashed) {
+        canvas_puts(c, "Game Over. Snake hit the border or itself.\n");
+    }
+    if (g->over) {
+        canvas_printf(c, "\nGame Over! Final Score: %d\n", g->score);
+    }
+}
 
-    ch = getchar();  // Get user input
+// Function to report the score to the launcher
+static int snake_score(const void *state) {
+    const SnakeGame *g = state;
+    return g->score;
+}
+
+// Function to save the score, the food, the heading and the body: where its
+// tail is and the moves from there to the head, four to a byte
+static size_t snake_save(const void *state, void *buf, size_t cap) {
+    const SnakeGame *g = state;
+    int header[7] = { g->score, g->food_x, g->food_y, (int)g->snake.length, g->direction,
+                      g->snake.tail_x, g->snake.tail_y };
+    size_t body = ((size_t)g->snake.length + 2) / 4;
 
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);  // Restore old terminal settings
-    return ch;
+    if (sizeof(header) + body > cap) {
+        return 0;
+    }
+    memcpy(buf, header, sizeof(header));
+    snake_pack(&g->snake, (unsigned char *)buf + sizeof(header));
+    return sizeof(header) + body;
 }
 
-// Main function
-int main() {
-    // Set up terminal
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+// Function to continue a saved game
+static int snake_restore(void *state, struct arena *arena, const struct game_board *board,
+                         const void *buf, size_t len) {
+    SnakeGame *g = state;
+    int header[7];
 
-    // Handle signals for graceful exit
-    signal(SIGINT, handle_exit);
-    signal(SIGTERM, handle_exit);
+    if (len < sizeof(header)) {
+        return -1;
+    }
+    memcpy(header, buf, sizeof(header));
+    if (header[3] < 1 || len != sizeof(header) + ((size_t)header[3] + 2) / 4
+        || (header[4] != 0 && strchr("wasd", header[4]) == NULL)) {
+        return -1;
+    }
 
-    // Seed random number generator
-    srand(time(NULL));
+    // Put the snake back on the board
+    if (snake_alloc(g, arena, board) != 0
+        || snake_unpack(&g->snake, header[5], header[6], (uint32_t)header[3],
+                        (const unsigned char *)buf + sizeof(header)) != 0) {
+        return -1;
+    }
+    g->score = header[0];
+    g->food_x = header[1];
+    g->food_y = header[2];
+    g->direction = (char)header[4];
+
+    // The food lies on a free cell, or nowhere once the body fills the board
+    if (g->food_x < 0 ? g->snake.free_count != 0
+                      : g->food_x >= board->width || g->food_y < 0 || g->food_y >= board->height
+                        || snake_occupied(&g->snake, (uint32_t)(g->food_y * board->width + g->food_x))) {
+        return -1;
+    }
+    return 0;
+}
 
-    // Allocate memory for the snake
-    snake.capacity = 10;
-    snake.x = malloc(snake.capacity * sizeof(int));
-    snake.y = malloc(snake.capacity * sizeof(int));
+// Catalog metadata
+GAME_NOTE("Snake Game", "Eat the food and grow without hitting the walls or yourself.");
+
+// Plugin descriptor
+const struct game_plugin game_plugin = {
+    .abi_version = GAME_ABI_VERSION,
+    .name = "snake",
+    .title = "Snake Game",
+    .state_size = sizeof(SnakeGame),
+    .board = { WIDTH, HEIGHT },
+    .tick_ms = SPEED_MS,
+    .configure = snake_configure,
+    .init = snake_init,
+    .handle_input = snake_handle_input,
+    .tick = snake_tick,
+    .draw = snake_draw,
+    .score = snake_score,
+    .save = snake_save,
+    .restore = snake_restore,
+};
+
+#ifndef GAME_PLUGIN_BUILD
+#define BENCH_ROUNDS 200         // Walks over the whole board per timing
+#define BENCH_SIDE 4096          // Board of the long snake benchmark
+#define BENCH_MOVES 1000000      // Moves timed at each length
+#define BENCH_SPREAD 3           // Most the slowest length may take over the fastest
+#define BENCH_PILOT_MOVES 2000000  // Moves the autopilot makes per strategy and board
+
+// Function to steer along the rows, right on even ones and left on odd ones, never into the body behind
+static int serpentine(const struct snake *s) {
+    if (s->head_y % 2 == 0) {
+        return s->head_x < s->width - 1 ? SNAKE_RIGHT : SNAKE_DOWN;
+    }
+    return s->head_x > 0 ? SNAKE_LEFT : SNAKE_DOWN;
+}
 
-    // Initialize snake position at the middle of the board 
-    snake.x[0] = WIDTH / 2;
-    snake.y[0] = HEIGHT / 2;
-    snake.length = 1;
+// Function to walk a snake over the whole board, growing on every third move,
+// then time drawing it; returns 0 if no move crashed
+static int bench_walk(SnakeGame *g, struct game_canvas *c, long long *step_ns, long long *draw_ns) {
+    struct snake *s = &g->snake;
+    int crashed = 0;
+
+    *step_ns = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        snake_start(s, 0, 0);
+        long long start = now_ns();
+        for (uint32_t n = 1; n < s->capacity; n++) {
+            int dir = serpentine(s);
+            uint32_t next = (uint32_t)((s->head_y + snake_dy[dir]) * s->width + s->head_x + snake_dx[dir]);
+            crashed |= snake_step(s, dir, n % 3 == 0 ? next : UINT32_MAX) == SNAKE_CRASHED;
+        }
+        *step_ns += now_ns() - start;
+    }
+    g->food_x = g->food_y = -1;
 
-    // Allocate memory for the game board
-    board = malloc(HEIGHT * sizeof(char *));
-    for (int i = 0; i < HEIGHT; i++) {
-        board[i] = malloc(WIDTH * sizeof(char));
+    canvas_clear(c);
+    long long start = now_ns();
+    for (int r = 0; r < BENCH_ROUNDS * 10; r++) {
+        c->row = 0;
+        draw_board(g, c);
     }
+    *draw_ns = now_ns() - start;
+    return crashed ? -1 : 0;
+}
 
-    // Generate the first food position
-    generate_food();
+// Function to time moving and drawing on boards of the common widths, returns
+// 0 if the snake never crashed and the canvas shows its body where it is
+static int bench_board(void) {
+    static const int widths[] = { 30, 60, 100 };
+    static struct game_cell cells[GAME_CANVAS_ROWS * GAME_CANVAS_COLS];
+    struct game_canvas c = { cells, GAME_CANVAS_ROWS, GAME_CANVAS_COLS, 0, 0, 0 };
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+        struct game_board board = { widths[i], MAX_HEIGHT };
+        SnakeGame g = { 0 };
+        struct arena arena;
+        size_t size;
+
+        snake_configure(&board, &size);
+        void *mem = malloc(size);
+        if (mem == NULL) {
+            perror("malloc");
+            return -1;
+        }
+        arena_init(&arena, mem, size);
+        snake_alloc(&g, &arena, &board);
+
+        long long step_ns, draw_ns;
+        const struct snake *s = &g.snake;
+        int same = bench_walk(&g, &c, &step_ns, &draw_ns) == 0;
+        for (int y = 0; y < s->height; y++) {
+            for (int x = 0; x < s->width; x++) {
+                char body = snake_occupied(s, (uint32_t)(y * s->width + x)) ? CELL_BODY : CELL_EMPTY;
+                char want = x == s->head_x && y == s->head_y ? CELL_HEAD : body;
+                same &= cells[y * c.cols + x].ch == want;
+            }
+        }
+        long long moves = (long long)BENCH_ROUNDS * (s->capacity - 1);
+
+        printf("%dx%d: moving %.2f ns/move, drawing %.2f us/frame; %s\n", s->width, s->height,
+               (double)step_ns / moves, draw_ns / 10000.0 / BENCH_ROUNDS, same ? "drawn as walked" : "DRAWN WRONG");
+        failed |= !same;
+        free(mem);
+    }
+    return failed ? -1 : 0;
+}
 
-    // Game loop
-    while (1) {
-        
-        print_board();  // Display the board
+// Function to grow a snake along the rows of a BENCH_SIDE x BENCH_SIDE board
+// to lengths up to millions of segments, timing moves and food placement at
+// each; returns 0 if the cost per move stays flat and the board stays consistent
+static int bench_moves(void) {
+    static const uint32_t lengths[] = { 1, 1000, 100000, 1000000, 4000000 };
+    size_t size = snake_arena_size(BENCH_SIDE, BENCH_SIDE);
+    double fastest = 0, slowest = 0;
+    struct snake s;
+    struct arena arena;
+    long checksum = 0;
+    int failed = 0;
+
+    void *mem = malloc(size);
+    if (mem == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    arena_init(&arena, mem, size);
+    snake_setup(&s, &arena, BENCH_SIDE, BENCH_SIDE);
+    snake_start(&s, 0, 0);
+    printf("%dx%d board, %zu KB\n", BENCH_SIDE, BENCH_SIDE, size / 1024);
+
+    srand(1);
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        // Grow by eating the cell ahead each time
+        while (s.length < lengths[i] && !failed) {
+            int dir = serpentine(&s);
+            uint32_t next = (uint32_t)((s.head_y + snake_dy[dir]) * s.width + s.head_x + snake_dx[dir]);
+            failed |= snake_step(&s, dir, next) != SNAKE_ATE;
+        }
 
-        char input = get_input();  // Get user input without requiring 'Enter'
-        if (input == 'q') {  // Exit on 'q'
-            break;
+        long long start = now_ns();
+        for (int n = 0; n < BENCH_MOVES && !failed; n++) {
+            failed |= snake_step(&s, serpentine(&s), UINT32_MAX) != SNAKE_MOVED;
         }
+        double move_ns = (double)(now_ns() - start) / BENCH_MOVES;
 
-        // Try to move the snake
-        int success = move_snake(input);
-        if (success == 0) {
-            printf("Game Over. Press any key to continue...\n");
-            get_input();  // Wait for user input to continue
+        start = now_ns();
+        for (int n = 0; n < BENCH_MOVES; n++) {
+            checksum += snake_free_cell(&s, (unsigned long)rand());
         }
+        double food_ns = (double)(now_ns() - start) / BENCH_MOVES;
+
+        failed |= s.length != lengths[i] || s.length + s.free_count != s.capacity;
+        printf("length %8u: %6.1f ns/move, %6.1f ns/food placement\n", s.length, move_ns, food_ns);
+        fastest = i == 0 || move_ns < fastest ? move_ns : fastest;
+        slowest = move_ns > slowest ? move_ns : slowest;
     }
+    free(mem);
 
-    // End game
-    restore_terminal();
-    printf("\nGame Over! Final Score: %d\n", score);
+    failed |= checksum < 0 || slowest > BENCH_SPREAD * fastest;
+    printf("per-move cost %s: slowest length %.1fx the fastest\n", failed ? "NOT FLAT" : "flat",
+           slowest / fastest);
+    return failed ? -1 : 0;
+}
 
-    // Deallocate dynamic memory
-    free(snake.x);
-    free(snake.y);
-    for (int i = 0; i < HEIGHT; i++) {
-        free(board[i]);
+// Function to let every autopilot strategy play games back to back on
+// boards of a few sizes, timing its decisions and the moves, and counting how
+// games end; returns 0 if the strategy that must never die did not
+static int bench_autopilot(void) {
+    static const struct game_board boards[] = { { WIDTH, HEIGHT }, { MAX_WIDTH, MAX_HEIGHT }, { 256, 256 } };
+    int failed = 0;
+
+    for (size_t b = 0; b < sizeof(boards) / sizeof(boards[0]); b++) {
+        int width = boards[b].width, height = boards[b].height;
+        size_t size = snake_arena_size(width, height) + autopilot_arena_size(width, height);
+
+        for (size_t i = 0; i < AUTOPILOT_STRATEGIES; i++) {
+            const struct autopilot_strategy *strategy = &autopilot_strategies[i];
+            long long decide_ns = 0, decide_max_ns = 0, eaten = 0;
+            int games = 0, deaths = 0, wins = 0;
+            struct autopilot a;
+            struct snake s;
+            struct arena arena;
+            uint32_t food = AUTOPILOT_NO_CELL;
+
+            void *mem = malloc(size);
+            if (mem == NULL) {
+                perror("malloc");
+                return -1;
+            }
+            arena_init(&arena, mem, size);
+            snake_setup(&s, &arena, width, height);
+            autopilot_setup(&a, &arena, strategy, width, height);
+
+            srand(1);
+            long long start = now_ns();
+            for (int n = 0, over = 1; n < BENCH_PILOT_MOVES; n++) {
+                if (over) {
+                    snake_start(&s, width / 2, height / 2);
+                    food = (uint32_t)snake_free_cell(&s, (unsigned long)rand());
+                    games++;
+                    over = 0;
+                }
+
+                long long before = now_ns();
+                int dir = autopilot_next(&a, &s, food);
+                long long took = now_ns() - before;
+                decide_ns += took;
+                decide_max_ns = took > decide_max_ns ? took : decide_max_ns;
+
+                int step = snake_step(&s, dir, food);
+                if (step == SNAKE_CRASHED) {
+                    deaths++;
+                    over = 1;
+                } else if (step == SNAKE_ATE) {
+                    long cell = snake_free_cell(&s, (unsigned long)rand());
+                    food = cell < 0 ? AUTOPILOT_NO_CELL : (uint32_t)cell;
+                    eaten++;
+                    wins += cell < 0;
+                    over = cell < 0;
+                }
+            }
+            double seconds = (double)(now_ns() - start) / 1e9;
+
+            printf("%3dx%-3d %-8s %6.2f M moves/s, deciding %5.0f ns/move (at most %6.1f us), "
+                   "%lld searches, %d games: %d died, %d filled the board, %.1f eaten per game\n",
+                   width, height, a.strategy->name, BENCH_PILOT_MOVES / seconds / 1e6,
+                   (double)decide_ns / BENCH_PILOT_MOVES, decide_max_ns / 1000.0, a.searches, games, deaths,
+                   wins, (double)eaten / games);
+            failed |= strcmp(strategy->name, "cycle") == 0 && deaths > 0;
+            free(mem);
+        }
     }
-    free(board);
+    return failed ? -1 : 0;
+}
 
-    return 0;
+// Main function
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--bench-board") == 0) {
+        return bench_board() == 0 ? 0 : 1;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-moves") == 0) {
+        return bench_moves() == 0 ? 0 : 1;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-autopilot") == 0) {
+        return bench_autopilot() == 0 ? 0 : 1;
+    }
+    return game_main(&game_plugin, argc, argv);
 }
+#endif
@@ -1,185 +1,689 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
-#include <termios.h>
-#include <signal.h>
 #include <string.h>
+
+#include "game_plugin.h"
+#include "sudoku.h"
+#include "sudoku_bank.h"
+#include "sudoku_n.h"
+#ifndef GAME_PLUGIN_BUILD
 #include <time.h>
- 
-#define SIZE 9
 
-// Grid and input system
-int grid[SIZE][SIZE];
+#include "game_runtime.h"
+#endif
+
+#define SIZE 9       // Grid played when no size is asked for
+#define MAX_SIZE 25  // Largest grid, its values are typed as 1-9 and a-p
+
+#define UNDO_DEPTH 128 // Moves that can be taken back
+#define SAVED_GIVEN 0x80 // Marks the cells of the puzzle itself in a snapshot
+
+// Units a cell belongs to
+enum { UNIT_ROW, UNIT_COL, UNIT_BOX, UNITS };
+
+// A move that can be taken back: the cell and what it held before
+struct sudoku_move {
+    uint16_t cell;
+    unsigned char old;
+};
 
-// Function to restore terminal settings
-struct termios oldt, newt;
-void restore_terminal() {
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+// Grid and input system, with masks and counts kept up to date by every move
+typedef struct SudokuGame {
+    int size;                // Cells per row, column and box: 4, 9, 16 or 25
+    int box;                 // Cells per side of a box
+    unsigned char *grid;     // size * size values, row by row, 0 for an empty cell
+    uint32_t all;            // Bits 1 to size, one per value
+    uint32_t used[UNITS][MAX_SIZE];                      // Bit v set while a row, column or box holds v
+    unsigned char count[UNITS][MAX_SIZE][MAX_SIZE + 1];  // Times a row, column or box holds each value
+    uint32_t given[MAX_SIZE];  // Bit col of given[row] set for the cells of the puzzle itself
+    int empty;                 // Empty cells left
+    int conflicts;             // Extra copies of values in rows, columns and boxes
+    struct sudoku_move undo[UNDO_DEPTH];  // Moves to take back, oldest first
+    int undo_count;
+    int pencil;           // Show the candidates of empty cells
+    int entry[3];         // Row, column and number typed so far
+    int entry_count;
+    const char *message;  // Outcome of the last move
+    int message_style;
+    int grade;            // enum sudoku_grade of the puzzle, -1 if it was not graded
+    int over;
+} SudokuGame;
+
+// Function to find the row, column and box of a cell
+static inline void cell_units(const SudokuGame *g, int row, int col, int *units) {
+    units[UNIT_ROW] = row;
+    units[UNIT_COL] = col;
+    units[UNIT_BOX] = row / g->box * g->box + col / g->box;
 }
 
-void generate_random_sudoku() {
-    srand(time(NULL));
-    for(int i = 0; i < 18; i++){
-        int row = rand()%SIZE;
-        int col = rand()%SIZE;
-        int val = rand()%9;
-        grid[row][col] = val;
+// Function to count a value into the units of a cell, or out of them with a negative delta
+static void count_value(SudokuGame *g, int row, int col, int value, int delta) {
+    int units[UNITS];
+
+    cell_units(g, row, col, units);
+    for (int u = 0; u < UNITS; u++) {
+        unsigned char *count = &g->count[u][units[u]][value];
+        if (delta > 0) {
+            g->conflicts += *count > 0;
+            if ((*count)++ == 0) {
+                g->used[u][units[u]] |= 1u << value;
+            }
+        } else {
+            if (--*count == 0) {
+                g->used[u][units[u]] &= ~(1u << value);
+            }
+            g->conflicts -= *count > 0;
+        }
     }
 }
 
-// Function to print the grid
-void print_grid() {
-    system("clear");
-    printf("\033[1;34mSudoku Game\033[0m\n\n");
-
-    for (int i = 0; i < SIZE; i++) {
-        for (int j = 0; j < SIZE; j++) {
-            if (grid[i][j] == 0) {
-                printf(". ");  // Empty cells are represented by "."
-            } else {
-                printf("%d ", grid[i][j]);
-            }
+// Function to change a cell, keeping the masks, counts and empty cells up to date
+static void set_cell(SudokuGame *g, int row, int col, int value) {
+    unsigned char *cell = &g->grid[row * g->size + col];
+
+    if (*cell != 0) {
+        count_value(g, row, col, *cell, -1);
+    } else {
+        g->empty--;
+    }
+    if (value != 0) {
+        count_value(g, row, col, value, 1);
+    } else {
+        g->empty++;
+    }
+    *cell = (unsigned char)value;
+}
 
-            if ((j + 1) % 3 == 0 && j != SIZE - 1) {
-                printf("| ");
+// Function to build the masks and counts of a grid from scratch
+static void track_grid(SudokuGame *g) {
+    memset(g->used, 0, sizeof(g->used));
+    memset(g->count, 0, sizeof(g->count));
+    g->all = ((1u << g->size) - 1) << 1;
+    g->empty = g->size * g->size;
+    g->conflicts = 0;
+    for (int row = 0; row < g->size; row++) {
+        for (int col = 0; col < g->size; col++) {
+            int value = g->grid[row * g->size + col];
+            if (value != 0) {
+                count_value(g, row, col, value, 1);
+                g->empty--;
             }
         }
+    }
+}
 
-        printf("\n");
+// Function to list the values that may still go in an empty cell, as bits 1 to size
+static inline uint32_t cell_candidates(const SudokuGame *g, int row, int col) {
+    int units[UNITS];
 
-        if ((i + 1) % 3 == 0 && i != SIZE - 1) {
-            printf("------|-------|------\n");
+    if (g->grid[row * g->size + col] != 0) {
+        return 0;
+    }
+    cell_units(g, row, col, units);
+    return g->all & ~(g->used[UNIT_ROW][units[UNIT_ROW]] | g->used[UNIT_COL][units[UNIT_COL]]
+                      | g->used[UNIT_BOX][units[UNIT_BOX]]);
+}
+
+// Function to check if the value of a cell repeats in its row, column or box
+static inline int in_conflict(const SudokuGame *g, int row, int col) {
+    int value = g->grid[row * g->size + col];
+    int units[UNITS];
+
+    cell_units(g, row, col, units);
+    for (int u = 0; u < UNITS && value != 0; u++) {
+        if (g->count[u][units[u]][value] > 1) {
+            return 1;
         }
     }
-    printf("\n");
+    return 0;
 }
 
-// Function to check if the current move is valid
-int is_valid_move(int row, int col, int num) {
-    // Check row and column
-    for (int i = 0; i < SIZE; i++) {
-        if (grid[row][i] == num || grid[i][col] == num) {
-            return 0; // Invalid move
+// Function to check if a cell is part of the puzzle itself
+static inline int is_given(const SudokuGame *g, int row, int col) {
+    return g->given[row] >> col & 1;
+}
+
+// Function to check if the pencil marks of every cell fit across the canvas
+static inline int marks_fit(const SudokuGame *g) {
+    return g->size * (g->size + 1) + 2 * (g->box - 1) <= GAME_CANVAS_COLS;
+}
+
+// Function to turn a value into the key that types it: 1-9, then a-p
+static char value_char(int value) {
+    return value <= 9 ? (char)('0' + value) : (char)('a' + value - 10);
+}
+
+// Function to turn a key into a value of a size x size grid, 0 if it is none
+static int key_value(int key, int size) {
+    int value = key >= '1' && key <= '9' ? key - '0' : key >= 'a' && key <= 'p' ? key - 'a' + 10 : 0;
+    return value <= size ? value : 0;
+}
+
+// Function to pick a 9x9 puzzle from the installed bank; returns -1 if there is none
+static int bank_puzzle(SudokuGame *g, unsigned int seed) {
+    const char *path = getenv(SUDOKU_BANK_ENV);
+    const char *name = getenv(SUDOKU_GRADE_ENV);
+    int grade = name != NULL ? sudoku_find_grade(name) : -1;
+    struct sudoku_bank bank;
+    char seen[4096];
+
+    if (sudoku_bank_open(&bank, path != NULL ? path : SUDOKU_BANK_PATH) != 0) {
+        return -1;
+    }
+    if (sudoku_bank_seen_path(seen, sizeof(seen)) == 0) {
+        sudoku_bank_track(&bank, seen);
+    }
+    g->grade = grade >= 0 ? grade : SUDOKU_MEDIUM;
+    long picked = sudoku_bank_pick(&bank, g->grade, seed, g->grid);
+    sudoku_bank_close(&bank);
+    return picked >= 0 ? 0 : -1;
+}
+
+// Function to generate a random puzzle with a unique solution
+void generate_random_sudoku(SudokuGame *g, unsigned int seed) {
+    if (g->size == SUDOKU_SIDE) {
+        if (bank_puzzle(g, seed) != 0) {
+            g->grade = sudoku_generate(seed, g->grid, NULL);
         }
+        return;
     }
+    g->grade = -1;
+    sudoku_n_generate(g->box, seed, g->grid, NULL);
+}
 
-    // Check the 3x3 subgrid
-    int start_row = (row / 3) * 3;
-    int start_col = (col / 3) * 3;
+// Function to draw one cell and the space after it: its value, or with pencil
+// marks its candidates in their places, a value in the middle of its field.
+// A value that repeats in its row, column or box is drawn in red.
+static void draw_cell(const SudokuGame *g, struct game_canvas *c, int row, int col, int marks) {
+    int value = g->grid[row * g->size + col];
 
-    for (int i = start_row; i < start_row + 3; i++) {
-        for (int j = start_col; j < start_col + 3; j++) {
-            if (grid[i][j] == num) {
-                return 0; // Invalid move
+    canvas_style(c, in_conflict(g, row, col) ? GAME_STYLE_BAD : GAME_STYLE_PLAIN);
+    if (!marks) {
+        canvas_putc(c, value != 0 ? value_char(value) : '.');  // Empty cells are represented by "."
+    } else if (value != 0) {
+        for (int v = 1; v <= g->size; v++) {
+            canvas_putc(c, v == (g->size + 1) / 2 ? value_char(value) : ' ');
+        }
+    } else {
+        uint32_t candidates = cell_candidates(g, row, col);
+        for (int v = 1; v <= g->size; v++) {
+            canvas_putc(c, candidates >> v & 1 ? value_char(v) : '.');
+        }
+    }
+    canvas_style(c, GAME_STYLE_PLAIN);
+    canvas_putc(c, ' ');
+}
+
+// Function to print the grid
+void print_grid(const SudokuGame *g, struct game_canvas *c) {
+    int marks = g->pencil && marks_fit(g);
+    int width = marks ? g->size + 1 : 2;  // Columns of a cell and the space after it
+
+    canvas_style(c, GAME_STYLE_TITLE);
+    canvas_puts(c, "Sudoku Game");
+    canvas_style(c, GAME_STYLE_PLAIN);
+    if (g->grade >= 0) {
+        canvas_printf(c, "  (%s)", sudoku_grade_names[g->grade]);
+    }
+    canvas_puts(c, "\n\n");
+
+    for (int i = 0; i < g->size; i++) {
+        for (int j = 0; j < g->size; j++) {
+            draw_cell(g, c, i, j, marks);
+            if ((j + 1) % g->box == 0 && j != g->size - 1) {
+                canvas_puts(c, "| ");
             }
         }
+
+        canvas_putc(c, '\n');
+
+        // A line under each band of boxes, crossing the bars between them
+        if ((i + 1) % g->box == 0 && i != g->size - 1) {
+            for (int b = 0; b < g->box; b++) {
+                int dashes = width * g->box + (b > 0 && b < g->box - 1);
+                if (b > 0) {
+                    canvas_putc(c, '|');
+                }
+                while (dashes-- > 0) {
+                    canvas_putc(c, '-');
+                }
+            }
+            canvas_putc(c, '\n');
+        }
     }
+    canvas_putc(c, '\n');
+}
+
+// Function to check if the current move is valid
+int is_valid_move(const SudokuGame *g, int row, int col, int num) {
+    int units[UNITS];
+
+    cell_units(g, row, col, units);
+    return !((g->used[UNIT_ROW][units[UNIT_ROW]] | g->used[UNIT_COL][units[UNIT_COL]]
+              | g->used[UNIT_BOX][units[UNIT_BOX]]) >> num & 1);
+}
+
+// Function to check if the game is over (i.e., the grid is complete without conflicts)
+int is_game_over(const SudokuGame *g) {
+    return g->empty == 0 && g->conflicts == 0;
+}
+
+// Function to apply a complete row/column/number entry to the grid
+int take_input(SudokuGame *g) {
+    int row = g->entry[0] - 1; // Convert to zero-based index
+    int col = g->entry[1] - 1;
+    int num = g->entry[2];
+
+    g->entry_count = 0;
+
+    // The cells of the puzzle itself stay as they are
+    if (is_given(g, row, col)) {
+        g->message = "That cell is part of the puzzle!";
+        g->message_style = GAME_STYLE_BAD;
+        return GAME_CONTINUE;
+    }
+
+    // Remember the move, forgetting the oldest one once the history is full
+    if (g->undo_count == UNDO_DEPTH) {
+        memmove(g->undo, g->undo + 1, (UNDO_DEPTH - 1) * sizeof(g->undo[0]));
+        g->undo_count--;
+    }
+    g->undo[g->undo_count++] = (struct sudoku_move){ (uint16_t)(row * g->size + col), g->grid[row * g->size + col] };
+
+    // A move that repeats a number is kept, and shown in red until it is fixed
+    set_cell(g, row, col, num);
+    if (in_conflict(g, row, col)) {
+        g->message = "That number repeats! 'u' takes it back";
+        g->message_style = GAME_STYLE_BAD;
+    } else {
+        g->message = "Move accepted!";
+        g->message_style = GAME_STYLE_PLAIN;
+    }
+
+    if (is_game_over(g)) {
+        g->message = "Congratulations! You solved the Sudoku!";
+        g->message_style = GAME_STYLE_GOOD;
+        g->over = 1;
+        return GAME_OVER;
+    } else if (g->empty == 0) {
+        g->message = "The grid is full, but numbers repeat!";
+        g->message_style = GAME_STYLE_BAD;
+    }
+    return GAME_CONTINUE;
+}
+
+// Function to take back the last move
+static void undo_move(SudokuGame *g) {
+    if (g->undo_count == 0) {
+        g->message = "Nothing to take back";
+        g->message_style = GAME_STYLE_PLAIN;
+        return;
+    }
+    struct sudoku_move move = g->undo[--g->undo_count];
+    set_cell(g, move.cell / g->size, move.cell % g->size, move.old);
+    g->message = "Move taken back";
+    g->message_style = GAME_STYLE_PLAIN;
+}
+
+// Function to settle the grid size: the one asked for if it is 4, 9, 16 or 25, else the closest of them
+static int sudoku_configure(struct game_board *board, size_t *arena_size) {
+    int asked = board->width > 0 ? board->width : board->height > 0 ? board->height : SIZE;
+    int size = asked < 7 ? 4 : asked < 13 ? 9 : asked < 21 ? 16 : MAX_SIZE;
+
+    board->width = board->height = size;
+    *arena_size = arena_round((size_t)size * size);
+    return 0;
+}
+
+// Function to take the grid from the arena
+static int sudoku_alloc(SudokuGame *g, struct arena *arena, const struct game_board *board) {
+    g->size = board->width;
+    g->box = g->size == 4 ? 2 : g->size == 9 ? 3 : g->size == 16 ? 4 : 5;
+    g->grid = arena_alloc(arena, (size_t)g->size * g->size);
+    return g->grid != NULL && g->box * g->box == g->size ? 0 : -1;
+}
 
-    return 1; // Valid move
+// Function to set up a new puzzle
+static int sudoku_init(void *state, struct arena *arena, const struct game_board *board, unsigned int seed) {
+    SudokuGame *g = state;
+
+    if (sudoku_alloc(g, arena, board) != 0) {
+        return -1;
+    }
+    generate_random_sudoku(g, seed);  // Generate a random grid
+    for (int i = 0; i < g->size * g->size; i++) {
+        if (g->grid[i] != 0) {
+            g->given[i / g->size] |= 1u << i % g->size;
+        }
+    }
+    track_grid(g);
+    return 0;
 }
 
 // Function to take user input on the fly
-int get_char() {
-    struct termios oldt, newt;
-    char ch;
-    
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);  
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-
-    ch = getchar();
-
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    return ch;
-}
-
-// Function to take input and update the grid
-void take_input() {
-    int row, col, num;
-    char ch;
-
-    printf("Enter row, column , and number to fill or 'q' to quit: ");
-
-    // Read input until 3 characters are provided or user presses 'q'
-    row = col = num = 0;
-    int entry_count = 0;
-
-    while (entry_count < 3) {
-        ch = get_char();
-
-        // Check for 'q' to quit the game
-        if (ch == 'q') {
-            printf("\033[1;31mExiting the game...\033[0m\n");
-            restore_terminal();
-            exit(0);
-        }
-
-        // If it's a number, accumulate the values
-        if (ch >= '1' && ch <= '9') {
-            if (entry_count == 0) {
-                row = ch - '0';  // Convert char to int
-            } else if (entry_count == 1) {
-                col = ch - '0';  
-            } else if (entry_count == 2) {
-                num = ch - '0';  
-            }
-            entry_count++;
+static int sudoku_handle_input(void *state, int key) {
+    SudokuGame *g = state;
+
+    // Check for 'q' to quit the game
+    if (key == 'q') {
+        g->message = "Exiting the game...";
+        g->message_style = GAME_STYLE_BAD;
+        g->over = 1;
+        return GAME_OVER;
+    }
+    if (key == 'u') {
+        undo_move(g);
+        return GAME_CONTINUE;
+    }
+    if (key == 'v') {
+        g->pencil = !g->pencil;
+        return GAME_CONTINUE;
+    }
+
+    // If it's a value of the grid, accumulate the values
+    int value = key_value(key, g->size);
+    if (value != 0) {
+        g->entry[g->entry_count++] = value;
+        if (g->entry_count == 3) {
+            return take_input(g);
         }
     }
+    return GAME_CONTINUE;
+}
 
-    row -= 1; // Convert to zero-based index
-    col -= 1; 
+// Function to start the next line of text
+static void next_line(struct game_canvas *c, int indent) {
+    canvas_putc(c, '\n');
+    c->col = indent;
+}
 
-    // Validate the move
-    if (grid[row][col] != 0) {
-        printf("\033[1;31mCell already filled! You lost!\033[0m\n");
-        restore_terminal();
-        exit(1); // End the game if the cell was already filled
-    } else if (!is_valid_move(row, col, num)) {
-        printf("\033[1;31mInvalid move! You lost!\033[0m\n");
-        restore_terminal();
-        exit(1); // End the game if the move is invalid
+// Function to separate two controls: beside the grid each gets its own line
+static void separate(struct game_canvas *c, int indent) {
+    if (indent > 0) {
+        next_line(c, indent);
     } else {
-        grid[row][col] = num;
-        printf("Move accepted!\n");
+        canvas_putc(c, ' ');
     }
 }
 
-// Function to check if the game is over (i.e., the grid is complete)
-int is_game_over() {
-    for (int i = 0; i < SIZE; i++) {
-        for (int j = 0; j < SIZE; j++) {
-            if (grid[i][j] == 0) {
-                return 0; // Game not over, still empty cells
+// Function to draw the grid and the input prompt
+static void sudoku_draw(const void *state, struct game_canvas *c) {
+    const SudokuGame *g = state;
+    int indent = 0;
+
+    print_grid(g, c);
+    // No room under the grid: write beside it
+    if (c->row + 4 > c->rows) {
+        indent = 2 * g->size + 2 * (g->box - 1) + 2;
+        c->row = 2;
+        c->col = indent;
+    }
+    if (g->message != NULL) {
+        canvas_style(c, g->message_style);
+        canvas_puts(c, g->message);
+        canvas_style(c, GAME_STYLE_PLAIN);
+        next_line(c, indent);
+    }
+    if (!g->over) {
+        canvas_puts(c, "'u' takes back a move,");
+        separate(c, indent);
+        canvas_printf(c, "'v' turns pencil marks %s,", g->pencil ? "off" : "on");
+        separate(c, indent);
+        canvas_puts(c, "'q' quits");
+        next_line(c, indent);
+        if (g->pencil && !marks_fit(g) && g->entry_count == 2) {
+            uint32_t candidates = cell_candidates(g, g->entry[0] - 1, g->entry[1] - 1);
+            canvas_puts(c, "Candidates:");
+            for (int v = 1; v <= g->size; v++) {
+                if (candidates >> v & 1) {
+                    if (c->col + 2 > c->cols) {
+                        next_line(c, indent);
+                    }
+                    canvas_printf(c, " %c", value_char(v));
+                }
             }
+            canvas_puts(c, candidates != 0 ? "" : " none");
+            next_line(c, indent);
+        }
+        if (indent > 0) {
+            c->row = c->rows - 1;
+            c->col = 0;
+        }
+        canvas_puts(c, "Enter row, column , and number to fill: ");
+        for (int i = 0; i < g->entry_count; i++) {
+            canvas_printf(c, "%c ", value_char(g->entry[i]));
         }
     }
-    return 1; // Game over, no empty cells
 }
 
-// Main function
-int main() {
-    // Set up terminal settings
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO); 
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+// Function to report the number of filled cells as the score
+static int sudoku_score(const void *state) {
+    const SudokuGame *g = state;
+    return g->size * g->size - g->empty;
+}
 
-    generate_random_sudoku();  // Generate a random grid
+// Function to save the grid, the entry, the grade, the pencil marks and the moves to take back
+static size_t sudoku_save(const void *state, void *buf, size_t cap) {
+    const SudokuGame *g = state;
+    unsigned char *out = buf;
+    size_t cells = (size_t)g->size * g->size;
+    size_t n = cells;
+
+    if (cap < cells + 7 + 3 * (size_t)g->undo_count) {
+        return 0;
+    }
+    for (size_t i = 0; i < cells; i++) {
+        out[i] = (unsigned char)(g->grid[i] | (is_given(g, (int)i / g->size, (int)i % g->size) ? SAVED_GIVEN : 0));
+    }
+    for (int i = 0; i < 3; i++) {
+        out[n++] = (unsigned char)g->entry[i];
+    }
+    out[n++] = (unsigned char)g->entry_count;
+    out[n++] = (unsigned char)(g->grade + 1);
+    out[n++] = (unsigned char)g->pencil;
+    out[n++] = (unsigned char)g->undo_count;
+    for (int i = 0; i < g->undo_count; i++) {
+        out[n++] = (unsigned char)(g->undo[i].cell & 0xff);
+        out[n++] = (unsigned char)(g->undo[i].cell >> 8);
+        out[n++] = g->undo[i].old;
+    }
+    return n;
+}
 
-    // Main game loop
-    while (1) {
-        print_grid();
+// Function to continue a saved puzzle
+static int sudoku_restore(void *state, struct arena *arena, const struct game_board *board,
+                          const void *buf, size_t len) {
+    SudokuGame *g = state;
+    const unsigned char *in = buf;
+    size_t cells = (size_t)board->width * board->height;
 
-        if (is_game_over()) {
-            printf("\033[1;32mCongratulations! You solved the Sudoku!\033[0m\n");
-            break;
+    if (len < cells + 7 || in[cells + 3] > 2 || in[cells + 4] > SUDOKU_GRADES || in[cells + 5] > 1
+        || in[cells + 6] > UNDO_DEPTH || len != cells + 7 + 3 * (size_t)in[cells + 6]) {
+        return -1;
+    }
+    if (sudoku_alloc(g, arena, board) != 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < cells; i++) {
+        int value = in[i] & ~SAVED_GIVEN;
+        if (value > g->size || in[i] == SAVED_GIVEN) {
+            return -1;
+        }
+        g->grid[i] = (unsigned char)value;
+        if (in[i] & SAVED_GIVEN) {
+            g->given[i / g->size] |= 1u << i % g->size;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        if (in[cells + i] > g->size || (i < in[cells + 3] && in[cells + i] == 0)) {
+            return -1;
+        }
+        g->entry[i] = in[cells + i];
+    }
+    g->entry_count = in[cells + 3];
+    g->grade = in[cells + 4] - 1;
+    g->pencil = in[cells + 5];
+    g->undo_count = in[cells + 6];
+    for (int i = 0; i < g->undo_count; i++) {
+        const unsigned char *saved = &in[cells + 7 + 3 * i];
+        struct sudoku_move move = { (uint16_t)(saved[0] | saved[1] << 8), saved[2] };
+        if (move.cell >= cells || move.old > g->size || is_given(g, move.cell / g->size, move.cell % g->size)) {
+            return -1;
         }
+        g->undo[i] = move;
+    }
+    track_grid(g);
+    return 0;
+}
+
+// Catalog metadata
+GAME_NOTE("Sudoku Game", "Fill the grid so every row, column and box holds 1 to 9.");
 
-        take_input();  // Get input from the user
+// Plugin descriptor
+const struct game_plugin game_plugin = {
+    .abi_version = GAME_ABI_VERSION,
+    .name = "sudoku",
+    .title = "Sudoku Game",
+    .state_size = sizeof(SudokuGame),
+    .board = { SIZE, SIZE },
+    .configure = sudoku_configure,
+    .init = sudoku_init,
+    .handle_input = sudoku_handle_input,
+    .draw = sudoku_draw,
+    .score = sudoku_score,
+    .save = sudoku_save,
+    .restore = sudoku_restore,
+};
+
+#ifndef GAME_PLUGIN_BUILD
+#define BENCH_ROUNDS 200   // Passes over every move of the grid per timing
+
+// Function to fill the grid with a solution: the pattern that shifts each row
+// by a box, and each band of boxes by one
+static void fill_pattern(SudokuGame *g) {
+    for (int i = 0; i < g->size; i++) {
+        for (int j = 0; j < g->size; j++) {
+            g->grid[i * g->size + j] = (unsigned char)((g->box * (i % g->box) + i / g->box + j) % g->size + 1);
+        }
     }
+}
 
-    restore_terminal();
-    return 0;
+// Function to read the monotonic clock in nanoseconds
+static long long bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to check a move by scanning its row, column and box
+static int valid_scan(const SudokuGame *g, int row, int col, int num) {
+    int start_row = (row / g->box) * g->box;
+    int start_col = (col / g->box) * g->box;
+
+    for (int i = 0; i < g->size; i++) {
+        if (g->grid[row * g->size + i] == num || g->grid[i * g->size + col] == num) {
+            return 0;
+        }
+    }
+    for (int i = start_row; i < start_row + g->box; i++) {
+        for (int j = start_col; j < start_col + g->box; j++) {
+            if (g->grid[i * g->size + j] == num) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// Function to time checking every number on every cell with the given check, returns the valid moves
+static long long bench_checks(const SudokuGame *g, int (*valid)(const SudokuGame *, int, int, int), long long *ns) {
+    long long valid_moves = 0;
+    long long start = bench_ns();
+
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int row = 0; row < g->size; row++) {
+            for (int col = 0; col < g->size; col++) {
+                for (int num = 1; num <= g->size; num++) {
+                    valid_moves += valid(g, row, col, num);
+                }
+            }
+        }
+    }
+    *ns = bench_ns() - start;
+    return valid_moves;
+}
+
+// Function to time playing every number on every empty cell and taking it
+// back, returns 0 if the grid is tracked as it was afterwards
+static int bench_moves(SudokuGame *g, long long *ns, long long *moves) {
+    int empty = g->empty, conflicts = g->conflicts;
+    long long start = bench_ns();
+
+    *moves = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int row = 0; row < g->size; row++) {
+            for (int col = 0; col < g->size; col++) {
+                if (g->grid[row * g->size + col] != 0) {
+                    continue;
+                }
+                for (int num = 1; num <= g->size; num++) {
+                    set_cell(g, row, col, num);
+                    *moves += in_conflict(g, row, col) + is_game_over(g) + 1;
+                    set_cell(g, row, col, 0);
+                }
+            }
+        }
+    }
+    *ns = bench_ns() - start;
+    return g->empty == empty && g->conflicts == conflicts ? 0 : -1;
+}
+
+// Function to compare the masks with scanning on half-filled grids of every
+// size, returns 0 if both agree on every move
+static int bench_board(void) {
+    static const int sizes[] = { 4, 9, 16, MAX_SIZE };
+    int failed = 0;
+
+    srand(1);
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        _Alignas(ARENA_ALIGN) unsigned char mem[MAX_SIZE * MAX_SIZE + ARENA_ALIGN];
+        struct game_board board = { sizes[s], sizes[s] };
+        SudokuGame g = { 0 };
+        struct arena arena;
+
+        arena_init(&arena, mem, sizeof(mem));
+        if (sudoku_alloc(&g, &arena, &board) != 0) {
+            return -1;
+        }
+        fill_pattern(&g);
+        for (int i = 0; i < g.size * g.size; i++) {
+            if (rand() % 2) {
+                g.grid[i] = 0;
+            }
+        }
+        track_grid(&g);
+
+        long long mask_ns, scan_ns, move_ns, moves;
+        long long masks = bench_checks(&g, is_valid_move, &mask_ns);
+        long long scans = bench_checks(&g, valid_scan, &scan_ns);
+        long long checks = (long long)BENCH_ROUNDS * g.size * g.size * g.size;
+        int tracked = bench_moves(&g, &move_ns, &moves);
+        long long played = (long long)BENCH_ROUNDS * g.empty * g.size;
+
+        printf("%dx%d: validity check %.2f ns with masks, %.2f scanning; move and take back %.2f ns; %s\n", g.size,
+               g.size, (double)mask_ns / checks, (double)scan_ns / checks, (double)move_ns / played,
+               masks == scans && tracked == 0 && moves > 0 ? "same results" : "RESULTS DIFFER");
+        failed |= masks != scans || tracked != 0;
+    }
+    return failed ? -1 : 0;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--bench-board") == 0) {
+        return bench_board() == 0 ? 0 : 1;
+    }
+    return game_main(&game_plugin, argc, argv);
 }
+#endif
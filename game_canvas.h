@@ -0,0 +1,105 @@
+#ifndef GAME_CANVAS_H
+#define GAME_CANVAS_H
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Size of the screen a game can draw on
+#define GAME_CANVAS_ROWS 32
+#define GAME_CANVAS_COLS 100
+
+// Colours a game can draw with; the renderer turns them into terminal escapes
+enum game_style {
+    GAME_STYLE_PLAIN = 0,
+    GAME_STYLE_TITLE,   // Bold blue, used for game titles
+    GAME_STYLE_BAD,     // Bold red, used for losing messages
+    GAME_STYLE_GOOD,    // Bold green, used for winning messages
+    GAME_STYLE_BAR,     // Reverse video, used for status bars
+    GAME_STYLE_COUNT,
+};
+
+// One character cell of the screen
+struct game_cell {
+    char ch;
+    unsigned char style;
+};
+
+// Cell grid a game draws its frame into, with a text cursor like a terminal's
+struct game_canvas {
+    struct game_cell *cells;   // rows * cols cells, row by row
+    int rows, cols;
+    int row, col;              // Where the next character goes; also where the cursor is shown
+    unsigned char style;       // Style of the next character
+};
+
+// Function to blank the canvas and move the cursor to the top left corner
+static inline void canvas_clear(struct game_canvas *c) {
+    for (int i = 0; i < c->rows * c->cols; i++) {
+        c->cells[i].ch = ' ';
+        c->cells[i].style = GAME_STYLE_PLAIN;
+    }
+    c->row = c->col = 0;
+    c->style = GAME_STYLE_PLAIN;
+}
+
+// Function to choose the style of the following characters
+static inline void canvas_style(struct game_canvas *c, int style) {
+    c->style = (unsigned char)style;
+}
+
+// Function to draw one character; '\n' starts a new line and text past the edges is dropped
+static inline void canvas_putc(struct game_canvas *c, char ch) {
+    if (ch == '\n') {
+        c->row++;
+        c->col = 0;
+        return;
+    }
+    if (c->row < c->rows && c->col < c->cols) {
+        struct game_cell *cell = &c->cells[c->row * c->cols + c->col];
+        cell->ch = ch;
+        cell->style = c->style;
+    }
+    c->col++;
+}
+
+// Function to draw a string
+static inline void canvas_puts(struct game_canvas *c, const char *s) {
+    while (*s != '\0') {
+        canvas_putc(c, *s++);
+    }
+}
+
+// Function to copy a block of text onto the canvas at its cursor, in the current
+// style: rows lines of cols characters, each stride characters after the last in
+// text. cols must not exceed the canvas width; lines past the bottom are dropped.
+// The cursor ends up at the start of the line below the block. Called with
+// constant sizes, it compiles to code specialised for them.
+static inline void canvas_blit(struct game_canvas *c, const char *text, int stride, int rows, int cols) {
+    // Copied to locals: the cells are chars, which the compiler must assume alias everything
+    int shown = rows < c->rows - c->row ? rows : c->rows - c->row;
+    unsigned char style = c->style;
+    struct game_cell *out = &c->cells[c->row * c->cols];
+
+    for (int i = 0; i < shown; i++, out += c->cols) {
+        const char *in = &text[i * stride];
+        for (int j = 0; j < cols; j++) {
+            out[j] = (struct game_cell){ in[j], style };
+        }
+    }
+    c->row += rows;
+    c->col = 0;
+}
+
+// Function to draw formatted text, like printf()
+__attribute__((format(printf, 2, 3)))
+static inline void canvas_printf(struct game_canvas *c, const char *fmt, ...) {
+    char buf[256];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    canvas_puts(c, buf);
+}
+
+#endif
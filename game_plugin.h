@@ -0,0 +1,123 @@
+#ifndef GAME_PLUGIN_H
+#define GAME_PLUGIN_H
+
+#include <stddef.h>
+
+#include "arena.h"
+#include "game_canvas.h"
+
+// Version of the plugin interface below; bumped on every incompatible change
+#define GAME_ABI_VERSION 7
+
+// Name of the descriptor every game_*.so exports
+#define GAME_PLUGIN_SYMBOL "game_plugin"
+
+// ELF note carrying a game's catalog metadata, read by the launcher without running the game
+#define GAME_NOTE_SECTION ".note.vgc"
+#define GAME_NOTE_OWNER "VGC"
+#define GAME_NOTE_TYPE 1
+
+// Embed the title and description of a game in its binary as a GAME_NOTE_SECTION note
+#define GAME_NOTE(title, description)                                              \
+    __attribute__((section(GAME_NOTE_SECTION), used, aligned(4)))                 \
+    static const struct {                                                         \
+        unsigned int namesz, descsz, type;                                        \
+        char name[sizeof(GAME_NOTE_OWNER)];                                       \
+        char desc[sizeof(title "\0" description)];                                \
+    } game_note = { sizeof(GAME_NOTE_OWNER), sizeof(title "\0" description),      \
+                    GAME_NOTE_TYPE, GAME_NOTE_OWNER, title "\0" description }
+
+// Values returned by handle_input() and tick()
+enum game_status {
+    GAME_CONTINUE = 0,  // Keep running
+    GAME_OVER = 1,      // Game finished, draw() shows the final screen once more
+    GAME_QUIT = 2,      // Leave right away without a final screen
+    GAME_SUSPENDED = 3, // Returned by the runtime only: the session was put aside and can run again
+    GAME_IDLE = 4,      // Returned by tick() only: nothing moves until the next key, stop ticking till then
+};
+
+// Keys handed to handle_input() besides plain bytes, decoded by the runtime
+// from the terminal's escape sequences
+enum game_key {
+    GAME_KEY_UP = 0x100,
+    GAME_KEY_DOWN,
+    GAME_KEY_RIGHT,
+    GAME_KEY_LEFT,
+    GAME_KEY_HOME,
+    GAME_KEY_END,
+    GAME_KEY_INSERT,
+    GAME_KEY_DELETE,
+    GAME_KEY_PAGE_UP,
+    GAME_KEY_PAGE_DOWN,
+};
+
+// Function to let the arrow keys steer like 'w', 'a', 's' and 'd'
+static inline int game_key_wasd(int key) {
+    switch (key) {
+    case GAME_KEY_UP:
+        return 'w';
+    case GAME_KEY_LEFT:
+        return 'a';
+    case GAME_KEY_DOWN:
+        return 's';
+    case GAME_KEY_RIGHT:
+        return 'd';
+    }
+    return key;
+}
+
+// Flags of a game_plugin
+enum game_flag {
+    GAME_FLAG_OWN_PROCESS = 1 << 0,  // Too heavy to share the daemon's loop: threads of its own, big ticks
+};
+
+// Size of a game's board in cells; a 0 leaves that dimension to the game
+struct game_board {
+    int width, height;
+};
+
+// Interface between a game and the runtime that drives it.
+// The runtime owns the terminal, the RNG seed and the event loop; a game only
+// reacts to keys and ticks and draws its current state onto a canvas, which the
+// runtime shows on the terminal or hands to the launcher's compositor.
+//
+// All memory of an instance is reserved in one block when it starts: the state
+// followed by an arena of arena_size bytes. init() and restore() carve the
+// game's buffers from the arena; nothing is allocated while the game runs.
+//
+// The board size is picked when an instance starts. configure() settles the
+// size asked for and says how large the arena must be for it; init() and
+// restore() then get the settled board.
+struct game_plugin {
+    unsigned int abi_version;   // Must be GAME_ABI_VERSION
+    const char *name;           // Short name, e.g. "snake"
+    const char *title;          // Title shown by the launcher
+    size_t state_size;          // Bytes of per-instance state allocated by the runtime
+    size_t arena_size;          // Bytes of the instance's arena without configure(), 0 if the state is all it needs
+    struct game_board board;    // Board played when no size is asked for
+    unsigned int tick_ms;       // Period of tick() in milliseconds, 0 for turn-based games.
+                                // Keys reach a timed game in order just before its next tick.
+    unsigned int flags;         // GAME_FLAG_* bits
+
+    // Settle the board asked for: fill in the defaults and keep it within what
+    // the game can play and show, then set *arena_size to the bytes it needs.
+    // Returns 0 on success. NULL for games with a fixed board.
+    int (*configure)(struct game_board *board, size_t *arena_size);
+
+    // Set up a new game on a settled board, 0 on success
+    int (*init)(void *state, struct arena *arena, const struct game_board *board, unsigned int seed);
+    int (*handle_input)(void *state, int key);       // React to one key
+    int (*tick)(void *state);                        // Advance time, may be NULL
+    void (*draw)(const void *state, struct game_canvas *c);  // Draw the current state on a cleared canvas
+    int (*score)(const void *state);                 // Score shown by the launcher, may be NULL
+    void (*shutdown)(void *state);                   // Release what init() acquired, may be NULL
+
+    // Snapshot support, both may be NULL. save() writes the state as a
+    // self-contained blob of at most cap bytes and returns its size, 0 on error;
+    // restore() rebuilds a zeroed state and a fresh arena from such a blob
+    // instead of init(), on the board it was saved with, returning 0 on success.
+    size_t (*save)(const void *state, void *buf, size_t cap);
+    int (*restore)(void *state, struct arena *arena, const struct game_board *board, const void *buf, size_t len);
+};
+
+#endif
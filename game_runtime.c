@@ -0,0 +1,1325 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dlfcn.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+
+#include "game_runtime.h"
+#include "game_shm.h"
+#include "input.h"
+#include "render.h"
+
+static volatile sig_atomic_t quit_requested = 0;
+static volatile sig_atomic_t suspend_requested = 0;
+
+// Terminal the game draws on when it is not run by the compositor
+static struct render screen;
+
+// Segment shared with the launcher's compositor, NULL when drawing on the terminal
+static struct game_shm *shared = NULL;
+static unsigned int shared_back = 0;   // Frame of the triple buffer the game draws into
+
+// Frames handed from the simulation to the render thread, a triple buffer like
+// the compositor's: each side swaps the frame it holds with ready and neither
+// ever waits for the other
+static struct {
+    pthread_t thread;
+    _Atomic unsigned int ready;       // Frame last published, with GAME_SHM_FRESH until taken
+    _Atomic unsigned int published;   // Frames published; the futex the render thread sleeps on
+    _Atomic int stop;
+    unsigned int back;                // Frame the simulation draws into
+    long long consumed;               // Frames taken by the render thread, read after it is joined
+    struct game_shm_frame frames[3];
+} painter;
+static int painting = 0;              // The render thread owns screen
+static int screen_throttle = 1;       // render.throttle of screen, off only in the benchmark
+
+// Function to read the monotonic clock in nanoseconds
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Signal handler asking the running session to stop
+static void handle_quit(int sig) {
+    (void)sig;
+    quit_requested = 1;
+}
+
+// Function to take the next key from the compositor's input ring, INPUT_NONE if it is empty
+static int take_shared_key(void) {
+    unsigned int tail = atomic_load_explicit(&shared->key_tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&shared->key_head, memory_order_acquire);
+
+    if (head == tail) {
+        return INPUT_NONE;
+    }
+    int key = shared->keys[tail % GAME_SHM_KEYS];
+    atomic_store_explicit(&shared->key_tail, tail + 1, memory_order_release);
+    return key;
+}
+
+// Signal handler asking the running session to step aside (Ctrl-Z)
+static void handle_suspend(int sig) {
+    (void)sig;
+    suspend_requested = 1;
+}
+
+// Function to set up the terminal screen on first use, returns 0 on success
+static int open_screen(void) {
+    int rows, cols;
+
+    if (screen.out != NULL) {
+        return 0;
+    }
+
+    // Lines of the canvas the terminal cannot show are left out rather than scrolled
+    render_term_size(STDOUT_FILENO, &rows, &cols);
+    if (render_init(&screen, STDOUT_FILENO, rows < GAME_CANVAS_ROWS ? rows : GAME_CANVAS_ROWS,
+                    cols < GAME_CANVAS_COLS ? cols : GAME_CANVAS_COLS) != 0) {
+        return -1;
+    }
+    screen.throttle = screen_throttle;
+    return 0;
+}
+
+// Function to draw the frame in the screen's back buffer and send what changed
+static void show_screen(struct game_session *s) {
+    if (open_screen() != 0) {
+        return;
+    }
+    s->plugin->draw(s->state, render_begin(&screen));
+    fflush(stdout);  // Anything printed before goes out ahead of the frame
+    render_flush(&screen);
+}
+
+// Function to draw one frame into the back frame of a triple buffer and swap it
+// with the ready one, returns the frame to draw into next time
+static unsigned int swap_frame(struct game_session *s, struct game_shm_frame *frames, unsigned int back,
+                               _Atomic unsigned int *ready) {
+    struct game_shm_frame *f = &frames[back];
+    struct game_canvas c = { f->cells, GAME_CANVAS_ROWS, GAME_CANVAS_COLS, 0, 0, 0 };
+
+    canvas_clear(&c);
+    s->plugin->draw(s->state, &c);
+    f->cursor_row = c.row;
+    f->cursor_col = c.col;
+    return atomic_exchange_explicit(ready, back | GAME_SHM_FRESH, memory_order_acq_rel) & ~GAME_SHM_FRESH;
+}
+
+// Function to draw one frame into the shared segment and hand it to the compositor
+static void publish_frame(struct game_session *s) {
+    long long start = now_ns();
+    unsigned int back = shared_back;
+
+    // Plain stores into the segment; the compositor reads them when it composites
+    shared_back = swap_frame(s, shared->frames, back, &shared->ready);
+    atomic_store_explicit(&shared->frame_ns, now_ns() - start, memory_order_relaxed);
+    if (s->plugin->score != NULL) {
+        atomic_store_explicit(&shared->score, s->plugin->score(s->state), memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&shared->frame_count, 1, memory_order_relaxed);
+}
+
+// Function to draw one frame for the render thread and wake it
+static void hand_frame(struct game_session *s) {
+    painter.back = swap_frame(s, painter.frames, painter.back, &painter.ready);
+    atomic_fetch_add_explicit(&painter.published, 1, memory_order_release);
+    syscall(SYS_futex, (unsigned int *)&painter.published, FUTEX_WAKE, 1, NULL, NULL, 0);
+    s->published++;
+}
+
+// Function to copy a frame into the screen's back buffer, leaving out what does not fit
+static void show_frame(const struct game_shm_frame *f) {
+    struct game_canvas *c = render_begin(&screen);
+
+    for (int i = 0; i < c->rows; i++) {
+        memcpy(&c->cells[i * c->cols], &f->cells[i * GAME_CANVAS_COLS], c->cols * sizeof(struct game_cell));
+    }
+    c->row = f->cursor_row < c->rows ? f->cursor_row : c->rows - 1;
+    c->col = f->cursor_col < c->cols ? f->cursor_col : c->cols - 1;
+    fflush(stdout);
+    render_flush(&screen);
+}
+
+// Render thread: send the newest frame whenever the terminal can take it. Frames
+// published while a write is under way are replaced by later ones, never queued.
+static void *paint_frames(void *arg) {
+    unsigned int front = 2;  // The simulation starts with frame 0 and ready names frame 1
+
+    (void)arg;
+    for (;;) {
+        unsigned int seen = atomic_load_explicit(&painter.published, memory_order_acquire);
+        if (atomic_load_explicit(&painter.ready, memory_order_relaxed) & GAME_SHM_FRESH) {
+            front = atomic_exchange_explicit(&painter.ready, front, memory_order_acq_rel) & ~GAME_SHM_FRESH;
+            show_frame(&painter.frames[front]);
+            painter.consumed++;
+            continue;
+        }
+        if (atomic_load_explicit(&painter.stop, memory_order_acquire)) {
+            break;
+        }
+
+        // Sleep until the next publish, or until a frame held back for a slow link is due
+        int held = render_wait_ms(&screen);
+        struct timespec ts = { held / 1000, (long)(held % 1000) * 1000000L };
+        syscall(SYS_futex, (unsigned int *)&painter.published, FUTEX_WAIT, seen, held >= 0 ? &ts : NULL,
+                NULL, 0);
+        if (held >= 0) {
+            render_flush(&screen);
+        }
+    }
+    render_sync(&screen);
+    return NULL;
+}
+
+// Function to start the render thread, returns 0 on success
+static int start_painter(void) {
+    sigset_t all, old;
+
+    if (open_screen() != 0) {
+        return -1;
+    }
+    atomic_store(&painter.ready, 1);
+    atomic_store(&painter.stop, 0);
+    painter.back = 0;
+    painter.consumed = 0;
+
+    // Signals stay with the simulation thread, whose waits they have to interrupt
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    int err = pthread_create(&painter.thread, NULL, paint_frames, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (err != 0) {
+        errno = err;
+        perror("pthread_create");
+        return -1;
+    }
+    painting = 1;
+    return 0;
+}
+
+// Function to let the render thread show the last frame and wait for it to finish
+static void stop_painter(struct game_session *s) {
+    atomic_store_explicit(&painter.stop, 1, memory_order_release);
+    atomic_fetch_add_explicit(&painter.published, 1, memory_order_release);
+    syscall(SYS_futex, (unsigned int *)&painter.published, FUTEX_WAKE, 1, NULL, NULL, 0);
+    pthread_join(painter.thread, NULL);
+    s->consumed += painter.consumed;
+    painting = 0;
+}
+
+// Function to draw one frame and flush it to the terminal or the compositor
+static void draw(struct game_session *s) {
+    if (shared != NULL) {
+        publish_frame(s);
+    } else if (painting) {
+        hand_frame(s);
+    } else {
+        show_screen(s);
+    }
+    if (s->first_frame_ns == 0) {
+        s->first_frame_ns = now_ns();
+    }
+}
+
+// Function to map the segment of the launcher's compositor, returns 0 on success
+static int attach_shared(int fd) {
+    struct game_shm *shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED) {
+        return -1;
+    }
+    if (shm->magic != GAME_SHM_MAGIC || shm->rows != GAME_CANVAS_ROWS || shm->cols != GAME_CANVAS_COLS) {
+        munmap(shm, sizeof(*shm));
+        return -1;
+    }
+
+    // The game starts with frame 0; the launcher holds frame 2 and ready names frame 1
+    shared = shm;
+    shared_back = 0;
+
+    // Nobody reads the ring once the launcher is gone
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    return 0;
+}
+
+#ifdef VGC_ALLOC_TRACE
+// Debug builds count every heap allocation in the process, so that benchmarks
+// can check that none happens while a game runs. The counting versions replace
+// the C library's and hand the work to its internal entry points.
+extern void *__libc_malloc(size_t n);
+extern void *__libc_calloc(size_t count, size_t n);
+extern void *__libc_realloc(void *p, size_t n);
+extern void *__libc_memalign(size_t align, size_t n);
+extern void __libc_free(void *p);
+
+static _Atomic long long alloc_count = 0;
+
+// Function to count and perform a malloc()
+void *malloc(size_t n) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_malloc(n);
+}
+
+// Function to count and perform a calloc()
+void *calloc(size_t count, size_t n) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_calloc(count, n);
+}
+
+// Function to count and perform a realloc()
+void *realloc(void *p, size_t n) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_realloc(p, n);
+}
+
+// Function to count and perform an aligned_alloc()
+void *aligned_alloc(size_t align, size_t n) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __libc_memalign(align, n);
+}
+
+// Function to release memory from any of the above
+void free(void *p) {
+    __libc_free(p);
+}
+
+// Function to get the number of allocations so far
+long long game_alloc_count(void) {
+    return atomic_load_explicit(&alloc_count, memory_order_relaxed);
+}
+#else
+// Function to get the number of allocations so far, not counted in this build
+long long game_alloc_count(void) {
+    return -1;
+}
+#endif
+
+// Function to reserve the memory of an instance in one block, the state and then its arena,
+// on the board asked for, or the one in GAME_BOARD_ENV if board is NULL
+static int reserve_session(struct game_session *s, const struct game_plugin *plugin,
+                           const struct game_board *board) {
+    size_t state_size = arena_round(plugin->state_size);
+    size_t arena_size = plugin->arena_size;
+    const char *env = getenv(GAME_BOARD_ENV);
+
+    s->plugin = plugin;
+    s->board = plugin->board;
+    if (plugin->configure != NULL) {
+        struct game_board asked = { 0, 0 };
+        if (board != NULL) {
+            asked = *board;
+        } else if (env != NULL && game_board_parse(env, &asked) != 0) {
+            fprintf(stderr, "%s: invalid board size '%s'\n", GAME_BOARD_ENV, env);
+        }
+        if (plugin->configure(&asked, &arena_size) != 0) {
+            fprintf(stderr, "%s: cannot play on a %dx%d board\n", plugin->name, asked.width, asked.height);
+            return -1;
+        }
+        s->board = asked;
+    }
+
+    s->state = calloc(1, state_size + arena_size);
+    if (s->state == NULL) {
+        perror("calloc");
+        return -1;
+    }
+    arena_init(&s->arena, (unsigned char *)s->state + state_size, arena_size);
+    return 0;
+}
+
+// Function to read a board size written as WIDTHxHEIGHT, or one number for a square board
+int game_board_parse(const char *text, struct game_board *board) {
+    char *end;
+    long width = strtol(text, &end, 10);
+    long height = width;
+
+    if (end == text || width <= 0 || width > GAME_BOARD_MAX) {
+        return -1;
+    }
+    if (*end == 'x' || *end == 'X') {
+        const char *rest = end + 1;
+        height = strtol(rest, &end, 10);
+        if (end == rest || height <= 0 || height > GAME_BOARD_MAX) {
+            return -1;
+        }
+    }
+    if (*end != '\0') {
+        return -1;
+    }
+    board->width = (int)width;
+    board->height = (int)height;
+    return 0;
+}
+
+// Function to create a new instance of a game
+int game_session_start(struct game_session *s, const struct game_plugin *plugin, unsigned int seed) {
+    memset(s, 0, sizeof(*s));
+    if (plugin->abi_version != GAME_ABI_VERSION) {
+        fprintf(stderr, "%s: unsupported plugin ABI %u\n", plugin->name, plugin->abi_version);
+        return -1;
+    }
+
+    if (reserve_session(s, plugin, NULL) != 0) {
+        return -1;
+    }
+
+    // The runtime seeds the RNG once for every game it drives
+    srand(seed);
+    if (plugin->init(s->state, &s->arena, &s->board, seed) != 0) {
+        free(s->state);
+        s->state = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Function to get the tick period of a plugin, which GAME_TICK_ENV can change
+unsigned int game_tick_ms(const struct game_plugin *plugin) {
+    const char *env = getenv(GAME_TICK_ENV);
+
+    if (plugin->tick == NULL || plugin->tick_ms == 0) {
+        return 0;
+    }
+    if (env != NULL && atoi(env) > 0) {
+        return (unsigned int)atoi(env);
+    }
+    return plugin->tick_ms;
+}
+
+// Timer and waiting keys of one game_session_run()
+struct game_loop {
+    struct input *in;        // Keys from the terminal, unused in compositor mode
+    int epfd;                // Waits for the keys and the timer, -1 in compositor mode
+    int timer_fd;            // Expires every period while the game is ticking, -1 if turn-based
+    long long period_ns;     // 0 for turn-based games
+    long long next_ns;       // When the timer expires next
+    int ticking;             // Timer armed; it is off while the game is idle
+    int keys[GAME_KEY_QUEUE];  // Keys held for the next tick
+    int queued;
+    int flush;               // Escape sequences cut short are keys of their own
+    int eof;                 // The input was closed
+};
+
+// Function to set up the loop of a session, returns 0 on success
+static int loop_open(struct game_loop *l, struct game_session *s) {
+    struct epoll_event ev = { .events = EPOLLIN };
+
+    memset(l, 0, sizeof(*l));
+    l->in = s->input != NULL ? s->input : input_stdin();
+    l->epfd = l->timer_fd = -1;
+    l->period_ns = (long long)game_tick_ms(s->plugin) * 1000000LL;
+
+    if (l->period_ns > 0) {
+        l->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (l->timer_fd < 0) {
+            perror("timerfd_create");
+            return -1;
+        }
+    }
+    if (shared != NULL) {
+        return 0;  // Keys come through the compositor's ring instead
+    }
+
+    l->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (l->epfd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+    ev.data.fd = l->in->fd;
+    if (epoll_ctl(l->epfd, EPOLL_CTL_ADD, l->in->fd, &ev) < 0) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    ev.data.fd = l->timer_fd;
+    if (l->timer_fd >= 0 && epoll_ctl(l->epfd, EPOLL_CTL_ADD, l->timer_fd, &ev) < 0) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    return 0;
+}
+
+// Function to release the loop's descriptors
+static void loop_close(struct game_loop *l) {
+    if (l->epfd >= 0) {
+        close(l->epfd);
+    }
+    if (l->timer_fd >= 0) {
+        close(l->timer_fd);
+    }
+}
+
+// Function to start ticking: the first tick after first_ns, then one every period
+static void loop_arm(struct game_loop *l, long long first_ns) {
+    struct itimerspec its;
+
+    if (l->timer_fd < 0) {
+        return;
+    }
+    if (first_ns < 1) {
+        first_ns = 1;  // Zero would disarm the timer
+    }
+    its.it_value.tv_sec = first_ns / 1000000000LL;
+    its.it_value.tv_nsec = first_ns % 1000000000LL;
+    its.it_interval.tv_sec = l->period_ns / 1000000000LL;
+    its.it_interval.tv_nsec = l->period_ns % 1000000000LL;
+    l->next_ns = now_ns() + first_ns;
+    timerfd_settime(l->timer_fd, 0, &its, NULL);
+    l->ticking = 1;
+}
+
+// Function to stop ticking until the next key
+static void loop_disarm(struct game_loop *l) {
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    timerfd_settime(l->timer_fd, 0, &its, NULL);
+    l->ticking = 0;
+}
+
+// Function to take how many periods have passed since the timer was last read, 0 if none
+static unsigned long long loop_expired(struct game_loop *l) {
+    unsigned long long expired = 0;
+
+    if (!l->ticking || read(l->timer_fd, &expired, sizeof(expired)) != sizeof(expired)) {
+        return 0;
+    }
+    return expired;
+}
+
+// Function to take the next key that arrived, INPUT_NONE if there is none.
+// Keys are taken one at a time so that those after a game's last key stay
+// buffered for the launcher.
+static int loop_key(struct game_loop *l) {
+    if (shared != NULL) {
+        return take_shared_key();
+    }
+    return input_next(l->in, l->flush);
+}
+
+// Function to sleep until keys arrive or the timer expires; without either the
+// wait has no timeout at all. Sets *expired to the periods that passed.
+static void loop_wait(struct game_loop *l, unsigned long long *expired) {
+    struct epoll_event ev[2];
+
+    *expired = 0;
+    l->flush = 0;
+    if (shared != NULL) {
+        unsigned int head = atomic_load_explicit(&shared->key_head, memory_order_acquire);
+        unsigned int tail = atomic_load_explicit(&shared->key_tail, memory_order_relaxed);
+
+        // The compositor wakes the ring's futex; sleep on it until the next expiry
+        struct timespec ts = { 0, 0 };
+        if (l->ticking && l->next_ns > now_ns()) {
+            long long left = l->next_ns - now_ns();
+            ts.tv_sec = left / 1000000000LL;
+            ts.tv_nsec = left % 1000000000LL;
+        }
+        if (head == tail && (!l->ticking || ts.tv_sec > 0 || ts.tv_nsec > 0)) {
+            syscall(SYS_futex, (unsigned int *)&shared->key_head, FUTEX_WAIT, head,
+                    l->ticking ? &ts : NULL, NULL, 0);
+        }
+        *expired = loop_expired(l);
+        return;
+    }
+
+    // A lone ESC is only told apart from the start of a sequence by the pause after it
+    int partial = l->in->pos < l->in->len;
+    int timeout = partial ? INPUT_ESC_MS : -1;
+
+    // A frame held back for a slow terminal is retried once the link had time to drain
+    int held = painting ? -1 : render_wait_ms(&screen);
+    if (held >= 0 && (timeout < 0 || held < timeout)) {
+        timeout = held;
+    }
+    int ready = epoll_wait(l->epfd, ev, 2, timeout);
+    if (held >= 0) {
+        render_flush(&screen);
+    }
+    if (ready == 0 && partial) {
+        l->flush = 1;
+    }
+    for (int i = 0; i < ready; i++) {
+        if (ev[i].data.fd == l->timer_fd) {
+            *expired = loop_expired(l);
+        } else if (input_fill(l->in) == 0) {
+            l->eof = l->flush = 1;  // What is still buffered goes out first
+        }
+    }
+}
+
+// Function to count how late the timer was seen expiring
+static void record_late(struct game_session *s, long long late_ns) {
+    int bucket = 0;
+
+    if (late_ns < 0) {
+        late_ns = 0;
+    }
+    while (bucket < GAME_LATE_BUCKETS - 1 && late_ns >= (1000LL << bucket)) {
+        bucket++;
+    }
+    s->late_hist[bucket]++;
+    s->late_total_ns += late_ns;
+    if (late_ns > s->late_max_ns) {
+        s->late_max_ns = late_ns;
+    }
+    s->wakeups++;
+}
+
+// Function to run the ticks of the periods that passed. After a stall up to
+// GAME_CATCHUP_MAX ticks run back to back so the game keeps its pace; the keys
+// queued since the last tick are handed over first, in the order they came.
+static void loop_ticks(struct game_session *s, struct game_loop *l, unsigned long long expired) {
+    const struct game_plugin *p = s->plugin;
+    long long due = l->next_ns + (long long)(expired - 1) * l->period_ns;
+
+    record_late(s, now_ns() - due);
+    l->next_ns = due + l->period_ns;
+    s->missed_ticks += expired - 1;
+    if (expired > GAME_CATCHUP_MAX) {
+        s->dropped_ticks += expired - GAME_CATCHUP_MAX;
+        expired = GAME_CATCHUP_MAX;
+    }
+
+    for (int i = 0; i < l->queued && s->status == GAME_CONTINUE; i++) {
+        s->status = p->handle_input(s->state, l->keys[i]);
+    }
+    l->queued = 0;
+
+    while (expired-- > 0 && s->status == GAME_CONTINUE) {
+        int status = p->tick(s->state);
+        s->ticks++;
+        if (status == GAME_IDLE) {
+            loop_disarm(l);  // Nothing to do until a key comes
+            break;
+        }
+        s->status = status;
+    }
+}
+
+// Function to run the input/tick/render loop of a session
+int game_session_run(struct game_session *s) {
+    const struct game_plugin *p = s->plugin;
+    struct sigaction sa, old_int, old_term, old_tstp;
+    struct game_loop l;
+
+    if (loop_open(&l, s) != 0) {
+        loop_close(&l);
+        return s->status = GAME_QUIT;
+    }
+
+    // Configure the terminal once for the whole session; the compositor owns it otherwise
+    int previous_mode = shared == NULL ? input_mode(INPUT_KEYS) : INPUT_COOKED;
+
+    // No SA_RESTART so a pending wait is interrupted and the loop can leave cleanly
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = handle_quit;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+    sa.sa_handler = handle_suspend;
+    sigaction(SIGTSTP, &sa, &old_tstp);
+    quit_requested = 0;
+    suspend_requested = 0;
+    render_invalidate(&screen);  // The launcher drew on the terminal since the last run
+
+    // Terminal writes move to a thread of their own, away from the tick schedule
+    if (shared == NULL && getenv(GAME_RENDER_THREAD_ENV) != NULL) {
+        start_painter();
+    }
+
+    s->status = GAME_CONTINUE;
+    loop_arm(&l, l.period_ns);
+    draw(s);
+
+    // Everything is set up by the first frame; from here on nothing may be allocated
+    long long allocs = game_alloc_count();
+    unsigned long long expired = 0;
+    for (;;) {
+        int changed = 0, key;
+
+        // Keys typed ahead may already be buffered, so they are taken before the first wait
+        while (s->status == GAME_CONTINUE && (key = loop_key(&l)) != INPUT_NONE) {
+            if (l.period_ns == 0) {
+                s->status = p->handle_input(s->state, key);  // Turn-based games react at once
+                changed = 1;
+            } else if (l.queued < GAME_KEY_QUEUE) {
+                l.keys[l.queued++] = key;
+            }
+        }
+        if (l.eof) {
+            s->status = GAME_QUIT;
+        }
+
+        // An idle game wakes up with a tick right away, which starts a new schedule
+        if (l.queued > 0 && !l.ticking) {
+            loop_arm(&l, l.period_ns);
+            l.next_ns -= l.period_ns;  // This tick is due now, the timer fires for the next one
+            expired = 1;
+        }
+        if (expired > 0 && s->status == GAME_CONTINUE) {
+            loop_ticks(s, &l, expired);
+            changed = 1;
+        }
+        if (s->status != GAME_CONTINUE) {
+            break;
+        }
+        if (changed) {
+            draw(s);
+        }
+
+        loop_wait(&l, &expired);
+        if (quit_requested) {
+            s->status = GAME_QUIT;
+            break;
+        }
+        if (suspend_requested) {
+            s->status = GAME_SUSPENDED;  // The caller decides how to put the session aside
+            break;
+        }
+    }
+
+    if (s->status == GAME_OVER) {
+        draw(s);  // Show the final screen
+    }
+    if (allocs >= 0) {
+        s->loop_allocs += game_alloc_count() - allocs;
+    }
+
+    // Whatever follows sees the latest state on the terminal
+    if (painting) {
+        stop_painter(s);
+    } else if (shared == NULL) {
+        render_sync(&screen);
+    }
+
+    if (shared != NULL) {
+        atomic_store_explicit(&shared->status, s->status, memory_order_release);
+    }
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    sigaction(SIGTSTP, &old_tstp, NULL);
+    if (shared == NULL) {
+        input_mode(previous_mode);
+    }
+    loop_close(&l);
+    return s->status;
+}
+
+// Function to get the lateness under which pct percent of the timer expiries were seen, in microseconds
+static long long late_percentile(const struct game_session *s, int pct) {
+    long long seen = 0;
+
+    for (int i = 0; i < GAME_LATE_BUCKETS; i++) {
+        seen += s->late_hist[i];
+        if (seen * 100 >= s->wakeups * pct) {
+            return 1LL << i;
+        }
+    }
+    return 1LL << (GAME_LATE_BUCKETS - 1);
+}
+
+// Function to print the tick timing of a session
+void game_session_report(const struct game_session *s, FILE *f) {
+    fprintf(f, "%s: %lld ticks, %lld missed (%lld dropped)", s->plugin->name, s->ticks,
+            s->missed_ticks, s->dropped_ticks);
+    if (s->wakeups > 0) {
+        fprintf(f, ", timer late by %lld us on average, p50 < %lld us, p99 < %lld us, max %lld us",
+                s->late_total_ns / s->wakeups / 1000, late_percentile(s, 50), late_percentile(s, 99),
+                s->late_max_ns / 1000);
+    }
+    fputc('\n', f);
+    fprintf(f, "%s: %dx%d board, %zu bytes reserved (state %zu, arena %zu of which %zu used)", s->plugin->name,
+            s->board.width, s->board.height, arena_round(s->plugin->state_size) + s->arena.size,
+            s->plugin->state_size, s->arena.size, s->arena.used);
+    if (game_alloc_count() >= 0) {
+        fprintf(f, ", %lld allocations while running", s->loop_allocs);
+    }
+    fputc('\n', f);
+    if (s->published > 0) {
+        fprintf(f, "%s: %lld frames published by the simulation, %lld consumed by the render thread\n",
+                s->plugin->name, s->published, s->consumed);
+    }
+    if (screen.frames > 0) {
+        fprintf(f, "%s: ", s->plugin->name);
+        render_report(&screen, f);
+    }
+}
+
+// Function to release an instance
+void game_session_end(struct game_session *s) {
+    if (s->state == NULL) {
+        return;
+    }
+    if (s->plugin->shutdown != NULL) {
+        s->plugin->shutdown(s->state);
+    }
+    free(s->state);
+    s->state = NULL;
+}
+
+// Function to write a snapshot of a session, replacing the previous one atomically
+int game_session_save(const struct game_session *s, const char *path) {
+    struct game_snapshot_header h;
+    static unsigned char blob[GAME_SNAPSHOT_MAX];
+    char tmp[PATH_MAX];
+
+    if (s->plugin->save == NULL) {
+        return -1;
+    }
+    size_t len = s->plugin->save(s->state, blob, sizeof(blob));
+    if (len == 0) {
+        return -1;
+    }
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, GAME_SNAPSHOT_MAGIC, sizeof(h.magic));
+    h.abi_version = GAME_ABI_VERSION;
+    h.length = len;
+    h.board = s->board;
+    snprintf(h.name, sizeof(h.name), "%s", s->plugin->name);
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(blob, len, 1, f) == 1;
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(tmp, path) < 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to recreate a session from a snapshot written by game_session_save()
+int game_session_restore(struct game_session *s, const struct game_plugin *plugin, unsigned int seed,
+                         const char *path) {
+    struct game_snapshot_header h;
+    static unsigned char blob[GAME_SNAPSHOT_MAX];
+
+    memset(s, 0, sizeof(*s));
+    if (plugin->restore == NULL) {
+        return -1;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = fread(&h, sizeof(h), 1, f) == 1
+             && memcmp(h.magic, GAME_SNAPSHOT_MAGIC, sizeof(h.magic)) == 0
+             && h.abi_version == GAME_ABI_VERSION
+             && strncmp(h.name, plugin->name, sizeof(h.name)) == 0
+             && h.length <= sizeof(blob)
+             && fread(blob, h.length, 1, f) == 1;
+    fclose(f);
+    if (!ok) {
+        return -1;
+    }
+
+    if (reserve_session(s, plugin, &h.board) != 0) {
+        return -1;
+    }
+    srand(seed);
+    if (plugin->restore(s->state, &s->arena, &s->board, blob, h.length) != 0) {
+        free(s->state);
+        s->state = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Function to load a game_*.so and check that it speaks our ABI
+const struct game_plugin *game_plugin_open(const char *path, void **handle) {
+    *handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (*handle == NULL) {
+        fprintf(stderr, "Failed to load plugin: %s\n", dlerror());
+        return NULL;
+    }
+
+    const struct game_plugin *plugin = dlsym(*handle, GAME_PLUGIN_SYMBOL);
+    if (plugin == NULL || plugin->abi_version != GAME_ABI_VERSION) {
+        fprintf(stderr, "%s: not a compatible game plugin\n", path);
+        dlclose(*handle);
+        *handle = NULL;
+        return NULL;
+    }
+    return plugin;
+}
+
+// Function used as main() by the standalone game executables
+int game_main(const struct game_plugin *plugin, int argc, char *argv[]) {
+    struct game_session s;
+    struct game_board board;
+    unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
+
+    // --board WxH picks the board size; passed on through the environment like the launcher does
+    if (argc >= 3 && strcmp(argv[1], "--board") == 0) {
+        if (game_board_parse(argv[2], &board) != 0) {
+            fprintf(stderr, "usage: %s [--board WIDTHxHEIGHT]\n", argv[0]);
+            return 1;
+        }
+        setenv(GAME_BOARD_ENV, argv[2], 1);
+    }
+
+    // Started by the launcher in compositor mode: draw into its segment instead of the terminal
+    if (getenv(GAME_SHM_ENV) != NULL && attach_shared(atoi(getenv(GAME_SHM_ENV))) != 0) {
+        fprintf(stderr, "%s: invalid compositor segment\n", plugin->title);
+        return 1;
+    }
+
+    // Pick up where a suspended run of this game left off
+    const char *snapshot = getenv(GAME_SNAPSHOT_ENV);
+    if ((snapshot == NULL || game_session_restore(&s, plugin, seed, snapshot) != 0)
+        && game_session_start(&s, plugin, seed) != 0) {
+        fprintf(stderr, "Failed to start %s\n", plugin->title);
+        return 1;
+    }
+
+    // Ctrl-Z saves a snapshot and stops the process; SIGCONT carries on from the same state
+    int status;
+    while ((status = game_session_run(&s)) == GAME_SUSPENDED) {
+        if (snapshot != NULL) {
+            game_session_save(&s, snapshot);
+        }
+        raise(SIGSTOP);
+    }
+    if (getenv(GAME_LOOP_STATS_ENV) != NULL) {
+        game_session_report(&s, stderr);
+    }
+    game_session_end(&s);
+
+    // A finished game starts afresh next time
+    if (snapshot != NULL) {
+        unlink(snapshot);
+    }
+
+    if (status == GAME_QUIT) {
+        printf("\nExiting...\n");
+    }
+    return 0;
+}
+
+#define BENCH_TICK_MS 10
+#define BENCH_TICKS 300
+#define BENCH_STALL_TICK 150   // This tick takes BENCH_STALL_MS, so the ones after it are late
+#define BENCH_STALL_MS 100
+
+// State of the synthetic game driven by game_loop_bench()
+struct bench_game {
+    int ticks;
+    char keys[8];             // Keys seen, in order
+    int key_count;
+    long long idle_ns;        // CLOCK_MONOTONIC time the game went idle, then how long it stayed idle
+    struct rusage idle_usage;
+};
+
+// Function to start the synthetic game
+static int bench_init(void *state, struct arena *arena, const struct game_board *board, unsigned int seed) {
+    (void)state;
+    (void)arena;
+    (void)board;
+    (void)seed;
+    return 0;
+}
+
+// Function to record a key of the synthetic game; 'q' ends it
+static int bench_handle_input(void *state, int key) {
+    struct bench_game *g = state;
+
+    if (g->key_count < (int)sizeof(g->keys)) {
+        g->keys[g->key_count++] = (char)key;
+    }
+    if (key != 'q') {
+        return GAME_CONTINUE;
+    }
+
+    // Leaving idle: keep what the idle period cost
+    struct rusage now;
+    getrusage(RUSAGE_SELF, &now);
+    g->idle_ns = now_ns() - g->idle_ns;
+    g->idle_usage.ru_utime.tv_sec = now.ru_utime.tv_sec - g->idle_usage.ru_utime.tv_sec;
+    g->idle_usage.ru_utime.tv_usec = now.ru_utime.tv_usec - g->idle_usage.ru_utime.tv_usec;
+    g->idle_usage.ru_stime.tv_sec = now.ru_stime.tv_sec - g->idle_usage.ru_stime.tv_sec;
+    g->idle_usage.ru_stime.tv_usec = now.ru_stime.tv_usec - g->idle_usage.ru_stime.tv_usec;
+    g->idle_usage.ru_nvcsw = now.ru_nvcsw - g->idle_usage.ru_nvcsw;
+    return GAME_QUIT;
+}
+
+// Function to advance the synthetic game, stalling once and going idle at the end
+static int bench_tick(void *state) {
+    struct bench_game *g = state;
+
+    if (++g->ticks == BENCH_STALL_TICK) {
+        struct timespec ts = { 0, BENCH_STALL_MS * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+    if (g->ticks < BENCH_TICKS) {
+        return GAME_CONTINUE;
+    }
+    g->idle_ns = now_ns();
+    getrusage(RUSAGE_SELF, &g->idle_usage);
+    return GAME_IDLE;
+}
+
+// Function to draw nothing for the synthetic game
+static void bench_draw(const void *state, struct game_canvas *c) {
+    (void)state;
+    (void)c;
+}
+
+// Game that ticks at 100 Hz, stalls once, takes a few keys and then idles until 'q'
+static const struct game_plugin bench_plugin = {
+    .abi_version = GAME_ABI_VERSION,
+    .name = "loop-bench",
+    .title = "Loop benchmark",
+    .state_size = sizeof(struct bench_game),
+    .tick_ms = BENCH_TICK_MS,
+    .init = bench_init,
+    .handle_input = bench_handle_input,
+    .tick = bench_tick,
+    .draw = bench_draw,
+};
+
+// Function to run the synthetic game with keys from a child process and check its timing
+int game_loop_bench(void) {
+    struct game_session s;
+    struct input in;
+    int fds[2];
+    int failures = 0;
+
+    unsetenv(GAME_TICK_ENV);
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        return 1;
+    }
+
+    // The keys: three while the game ticks, 'q' once it has been idle for a while
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (child == 0) {
+        struct timespec ts = { 0, 500000000L };
+        close(fds[0]);
+        nanosleep(&ts, NULL);
+        if (write(fds[1], "abc", 3) != 3) {
+            _exit(1);
+        }
+        ts.tv_sec = (BENCH_TICKS * BENCH_TICK_MS + BENCH_STALL_MS) / 1000 + 1;
+        ts.tv_nsec = 0;
+        nanosleep(&ts, NULL);
+        _exit(write(fds[1], "q", 1) == 1 ? 0 : 1);
+    }
+    close(fds[1]);
+
+    if (game_session_start(&s, &bench_plugin, 1) != 0) {
+        return 1;
+    }
+    input_init(&in, fds[0]);
+    s.input = &in;
+
+    // Frames go nowhere; the game draws nothing anyway
+    int out = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    if (out < 0 || null < 0) {
+        perror("open");
+        return 1;
+    }
+    fflush(stdout);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    int status = game_session_run(&s);
+    dup2(out, STDOUT_FILENO);
+    close(out);
+    waitpid(child, NULL, 0);
+    close(fds[0]);
+
+    const struct bench_game *g = s.state;
+    game_session_report(&s, stdout);
+
+    // A stall of BENCH_STALL_MS misses that many periods; GAME_CATCHUP_MAX of them run late
+    int stall_ok = s.missed_ticks >= BENCH_STALL_MS / BENCH_TICK_MS - 1 && s.dropped_ticks > 0
+                   && s.dropped_ticks <= s.missed_ticks - (GAME_CATCHUP_MAX - 1);
+    printf("%-10s %lld periods missed, %lld caught up, %lld dropped: %s\n", "stall", s.missed_ticks,
+           s.missed_ticks - s.dropped_ticks, s.dropped_ticks, stall_ok ? "ok" : "FAILED");
+    failures += !stall_ok;
+
+    int keys_ok = status == GAME_QUIT && g->key_count == 4 && memcmp(g->keys, "abcq", 4) == 0;
+    printf("%-10s %d keys delivered in order: %s\n", "keys", g->key_count, keys_ok ? "ok" : "FAILED");
+    failures += !keys_ok;
+
+    // Idle means asleep: no CPU and no wakeups besides the one for the key
+    long long idle_cpu_us = (g->idle_usage.ru_utime.tv_sec + g->idle_usage.ru_stime.tv_sec) * 1000000LL
+                            + g->idle_usage.ru_utime.tv_usec + g->idle_usage.ru_stime.tv_usec;
+    int idle_ok = idle_cpu_us < 1000 && g->idle_usage.ru_nvcsw <= 2;
+    printf("%-10s %.1f s idle cost %lld us CPU and %ld wakeups: %s\n", "idle", g->idle_ns / 1e9, idle_cpu_us,
+           g->idle_usage.ru_nvcsw, idle_ok ? "ok" : "FAILED");
+    failures += !idle_ok;
+
+    game_session_end(&s);
+    return failures == 0 ? 0 : 1;
+}
+
+#define PAINT_BENCH_MS 1000   // How long the game of game_thread_bench() runs
+
+// State of the synthetic game driven by game_thread_bench()
+struct paint_game {
+    long long end_ns;   // When the game is over
+    int ticks;
+};
+
+// Function to ignore the keys of the synthetic game
+static int paint_handle_input(void *state, int key) {
+    (void)state;
+    (void)key;
+    return GAME_CONTINUE;
+}
+
+// Function to advance the synthetic game, which is over after PAINT_BENCH_MS
+static int paint_tick(void *state) {
+    struct paint_game *g = state;
+
+    if (g->end_ns == 0) {
+        g->end_ns = now_ns() + PAINT_BENCH_MS * 1000000LL;
+    }
+    g->ticks++;
+    return now_ns() < g->end_ns ? GAME_CONTINUE : GAME_OVER;
+}
+
+// Function to draw the synthetic game: every cell changes on every tick
+static void paint_draw(const void *state, struct game_canvas *c) {
+    const struct paint_game *g = state;
+
+    for (int i = 0; i < c->rows * c->cols; i++) {
+        c->cells[i].ch = 'a' + (i / c->cols + i % c->cols + g->ticks) % 26;
+    }
+}
+
+static const struct game_plugin paint_plugin = {
+    .abi_version = GAME_ABI_VERSION,
+    .name = "paint-bench",
+    .title = "Render thread benchmark",
+    .state_size = sizeof(struct paint_game),
+    .tick_ms = BENCH_TICK_MS,
+    .init = bench_init,
+    .handle_input = paint_handle_input,
+    .tick = paint_tick,
+    .draw = paint_draw,
+};
+
+// Function to open a pseudo-terminal whose far end a child reads at bytes_per_sec,
+// returns the child's pid and the near end in *slave, -1 on error
+static pid_t slow_pty(int bytes_per_sec, int *slave) {
+    struct termios tio;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        perror("posix_openpt");
+        return -1;
+    }
+    *slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (*slave < 0) {
+        perror("open");
+        return -1;
+    }
+    tcgetattr(*slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(*slave, TCSANOW, &tio);
+
+    pid_t reader = fork();
+    if (reader < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (reader == 0) {
+        char buf[4096];
+        size_t chunk = bytes_per_sec / 100 < (int)sizeof(buf) ? (size_t)(bytes_per_sec / 100) : sizeof(buf);
+        struct timespec ts = { 0, 10000000L };
+
+        close(*slave);
+        do {
+            nanosleep(&ts, NULL);
+        } while (read(master, buf, chunk) > 0);
+        _exit(0);
+    }
+    close(master);
+    return reader;
+}
+
+// Function to run the synthetic game on a slow terminal that blocks its writer,
+// with and without the render thread, and check that ticks keep their schedule
+int game_thread_bench(int bytes_per_sec) {
+    struct game_session s[2];
+    int keys[2];
+
+    printf("link of %d bytes/s, %d ms of ticks every %d ms with every cell changing\n", bytes_per_sec,
+           PAINT_BENCH_MS, BENCH_TICK_MS);
+    unsetenv(GAME_TICK_ENV);
+    screen_throttle = 0;  // Writes wait for the terminal, as without frame dropping
+    for (int threaded = 0; threaded < 2; threaded++) {
+        int slave;
+        pid_t reader = slow_pty(bytes_per_sec, &slave);
+        if (reader < 0 || pipe(keys) < 0) {
+            return 1;
+        }
+        if (threaded) {
+            setenv(GAME_RENDER_THREAD_ENV, "1", 1);
+        } else {
+            unsetenv(GAME_RENDER_THREAD_ENV);
+        }
+
+        // No keys come; the game ends on its own
+        struct input in;
+        input_init(&in, keys[0]);
+        if (game_session_start(&s[threaded], &paint_plugin, 1) != 0) {
+            return 1;
+        }
+        s[threaded].input = &in;
+
+        int out = dup(STDOUT_FILENO);
+        fflush(stdout);
+        dup2(slave, STDOUT_FILENO);
+        long long start = now_ns();
+        game_session_run(&s[threaded]);
+        long long took = now_ns() - start;
+        dup2(out, STDOUT_FILENO);
+        close(out);
+        render_free(&screen);
+        memset(&screen, 0, sizeof(screen));
+
+        close(slave);
+        close(keys[0]);
+        close(keys[1]);
+        kill(reader, SIGTERM);
+        waitpid(reader, NULL, 0);
+
+        printf("%-14s ran %.1f s: ", threaded ? "render thread" : "one thread", took / 1e9);
+        game_session_report(&s[threaded], stdout);
+    }
+    unsetenv(GAME_RENDER_THREAD_ENV);
+    screen_throttle = 1;
+
+    // With the writes on their own thread a tick is at most a little late, and the
+    // render thread skips the frames it could not send in time
+    int on_time = s[1].missed_ticks * 10 <= s[1].ticks + s[1].dropped_ticks
+                  && s[1].missed_ticks < s[0].missed_ticks;
+    int skipped = s[1].consumed < s[1].published;
+    printf("%-14s %lld of %lld ticks missed with one thread, %lld of %lld with the render thread: %s\n",
+           "ticks", s[0].missed_ticks, s[0].ticks + s[0].dropped_ticks, s[1].missed_ticks,
+           s[1].ticks + s[1].dropped_ticks, on_time ? "ok" : "FAILED");
+    printf("%-14s %lld of %lld frames superseded before they were sent: %s\n", "frames",
+           s[1].published - s[1].consumed, s[1].published, skipped ? "ok" : "FAILED");
+    game_session_end(&s[0]);
+    game_session_end(&s[1]);
+    return on_time && skipped ? 0 : 1;
+}
+
+#define ALLOC_BENCH_KEYS "dddwwwaaasss\033[A\033[C\033[B\033[D1 3 4\r5 5 9\rhjklq\r"
+#define ALLOC_BENCH_KEY_MS 5   // Time between two scripted keys
+#define ALLOC_BENCH_TICK_MS "2"
+
+// Function to run one plugin on the scripted keys with its output thrown away,
+// returns the allocations it made after its first frame or -1 on error
+static long long alloc_run(const struct game_plugin *plugin, struct game_session *s) {
+    int fds[2];
+
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        return -1;
+    }
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (child == 0) {
+        struct timespec ts = { 0, ALLOC_BENCH_KEY_MS * 1000000L };
+        close(fds[0]);
+        for (const char *k = ALLOC_BENCH_KEYS; *k; k++) {
+            nanosleep(&ts, NULL);
+            if (write(fds[1], k, 1) != 1) {
+                _exit(1);
+            }
+        }
+        _exit(0);  // The end of the input ends the game if the keys did not
+    }
+    close(fds[1]);
+
+    struct input in;
+    if (game_session_start(s, plugin, 1) != 0) {
+        return -1;
+    }
+    input_init(&in, fds[0]);
+    s->input = &in;
+
+    int out = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    if (out < 0 || null < 0) {
+        perror("open");
+        return -1;
+    }
+    fflush(stdout);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    game_session_run(s);
+    dup2(out, STDOUT_FILENO);
+    close(out);
+    render_free(&screen);
+    memset(&screen, 0, sizeof(screen));
+    waitpid(child, NULL, 0);
+    close(fds[0]);
+    return s->loop_allocs;
+}
+
+// Function to check that the given plugins allocate nothing while they run
+int game_alloc_bench(const char *const *paths, int count) {
+    int failures = 0;
+
+    if (game_alloc_count() < 0) {
+        printf("allocations are not counted in this build; build with -DVGC_ALLOC_TRACE: not checked\n");
+        return 1;  // Not a pass: nothing was checked
+    }
+    setenv(GAME_TICK_ENV, ALLOC_BENCH_TICK_MS, 1);
+    for (int i = 0; i < count; i++) {
+        struct game_session s;
+        void *handle;
+        const struct game_plugin *plugin = game_plugin_open(paths[i], &handle);
+        if (plugin == NULL) {
+            failures++;
+            continue;
+        }
+
+        long long allocs = alloc_run(plugin, &s);
+        game_session_report(&s, stdout);
+        printf("%-10s %lld allocations after the first frame: %s\n", plugin->name, allocs,
+               allocs == 0 ? "ok" : "FAILED");
+        failures += allocs != 0;
+        game_session_end(&s);
+        dlclose(handle);
+    }
+    unsetenv(GAME_TICK_ENV);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#ifndef GAME_RUNTIME_H
+#define GAME_RUNTIME_H
+
+#include <stdio.h>
+
+#include "game_plugin.h"
+#include "input.h"
+
+// Environment variable naming the snapshot file of a standalone game
+#define GAME_SNAPSHOT_ENV "VGC_SNAPSHOT"
+
+// Environment variable choosing the board size of the games started, WIDTHxHEIGHT
+#define GAME_BOARD_ENV "VGC_BOARD"
+#define GAME_BOARD_MAX 65536    // Largest width or height accepted
+
+// Environment variable overriding the tick period of timed games, in milliseconds
+#define GAME_TICK_ENV "VGC_TICK_MS"
+
+// Environment variable asking a standalone game to print its tick timing on exit
+#define GAME_LOOP_STATS_ENV "VGC_LOOP_STATS"
+
+// Environment variable moving terminal output of a game to a render thread, so
+// that a slow terminal cannot hold up its ticks
+#define GAME_RENDER_THREAD_ENV "VGC_RENDER_THREAD"
+
+#define GAME_CATCHUP_MAX 5      // Ticks run back to back after a stall; older missed ones are dropped
+#define GAME_KEY_QUEUE 64       // Keys held for the next tick of a timed game
+#define GAME_LATE_BUCKETS 20    // Histogram of tick lateness, bucket i counts delays under 2^i us
+
+#define GAME_SNAPSHOT_MAGIC "VGCSNAP1"
+#define GAME_SNAPSHOT_MAX 65536   // Largest blob a game may save
+
+// Header of a snapshot file, followed by length bytes from the game's save()
+struct game_snapshot_header {
+    char magic[8];              // GAME_SNAPSHOT_MAGIC without the terminator
+    unsigned int abi_version;
+    unsigned int length;
+    char name[32];              // game_plugin.name of the game that wrote it
+    struct game_board board;    // Board the game was played on
+};
+
+// One running instance of a game
+struct game_session {
+    const struct game_plugin *plugin;
+    void *state;                // Start of the block holding the state and then the arena
+    struct arena arena;         // What is left of the block for the game's buffers
+    struct game_board board;    // Board the game plays on, settled by its configure()
+    int status;                 // Last value returned by the game
+    long long first_frame_ns;   // CLOCK_MONOTONIC time the first frame was drawn
+    struct input *input;        // Where keys come from, standard input when NULL
+
+    // Timing of the ticks of a timed game, summed over every run
+    long long ticks;            // tick() calls
+    long long missed_ticks;     // Periods whose tick did not run on time
+    long long dropped_ticks;    // Missed ticks skipped instead of caught up
+    long long late_total_ns;    // How long after its schedule each timer expiry was seen
+    long long late_max_ns;
+    long long wakeups;          // Timer expiries seen
+    unsigned int late_hist[GAME_LATE_BUCKETS];
+
+    // Frames handed to the render thread and the ones it sent; the rest were superseded
+    long long published;
+    long long consumed;
+
+    // Heap allocations made between the first frame and the end of a run, which
+    // should be none; only counted in builds with VGC_ALLOC_TRACE
+    long long loop_allocs;
+};
+
+// Allocate and initialise a new instance on the board named by GAME_BOARD_ENV,
+// or the game's own board, returns 0 on success
+int game_session_start(struct game_session *s, const struct game_plugin *plugin, unsigned int seed);
+
+// Drive the instance from the terminal until it is over, returns its final status.
+// Timed games tick from a timerfd at a fixed rate; keys are queued for the next
+// tick and the timer is off while the game is idle, so the loop sleeps in
+// epoll_wait() until something happens. With GAME_RENDER_THREAD_ENV set, frames
+// go through a triple buffer to a render thread that writes them to the terminal.
+// Returns GAME_SUSPENDED on Ctrl-Z (SIGTSTP); the session can then be saved, put
+// aside and run again later.
+int game_session_run(struct game_session *s);
+
+// Print the tick timing of a session
+void game_session_report(const struct game_session *s, FILE *f);
+
+// Write a snapshot of the instance to path, returns 0 on success
+int game_session_save(const struct game_session *s, const char *path);
+
+// Create an instance from the snapshot at path instead of a new game, returns 0 on success
+int game_session_restore(struct game_session *s, const struct game_plugin *plugin, unsigned int seed,
+                         const char *path);
+
+// Shut the instance down and free its state
+void game_session_end(struct game_session *s);
+
+// Tick period of a plugin in milliseconds after GAME_TICK_ENV, 0 for turn-based games
+unsigned int game_tick_ms(const struct game_plugin *plugin);
+
+// Measure tick jitter, catch-up after a stall and CPU use while idle, returns 0 if all pass
+int game_loop_bench(void);
+
+// Run a timed game on a slow pseudo-terminal with and without the render thread
+// and compare missed ticks, returns 0 if the render thread keeps them on time
+int game_thread_bench(int bytes_per_sec);
+
+// Number of heap allocations made by the process so far, -1 unless built with
+// -DVGC_ALLOC_TRACE, which counts them
+long long game_alloc_count(void);
+
+// Run each plugin on scripted keys and check that none allocates memory after its
+// first frame, returns 0 if all pass; builds that do not count allocations
+// cannot check and return 1
+int game_alloc_bench(const char *const *paths, int count);
+
+// Read a board size written as WIDTHxHEIGHT, or as one number for a square board;
+// returns 0 on success
+int game_board_parse(const char *text, struct game_board *board);
+
+// Load a plugin from a shared object, returns NULL on error
+const struct game_plugin *game_plugin_open(const char *path, void **handle);
+
+// main() of the standalone game executables; takes --board WIDTHxHEIGHT
+int game_main(const struct game_plugin *plugin, int argc, char *argv[]);
+
+#endif
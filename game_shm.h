@@ -0,0 +1,52 @@
+#ifndef GAME_SHM_H
+#define GAME_SHM_H
+
+#include <stdatomic.h>
+
+#include "game_canvas.h"
+
+// Shared segment between the launcher's compositor and one game process.
+// The launcher creates it with memfd_create(), passes the fd to the game as
+// GAME_SHM_FD and names it in the GAME_SHM_ENV environment variable.
+#define GAME_SHM_ENV "VGC_SHM_FD"
+#define GAME_SHM_FD 3
+#define GAME_SHM_MAGIC 0x32434756u   // "VGC2", keys in the ring are ints since version 2
+
+// Size of the input ring, a power of two
+#define GAME_SHM_KEYS 256
+
+// Set in game_shm.ready while the frame it names has not been picked up yet
+#define GAME_SHM_FRESH 4u
+
+// One frame drawn by the game
+struct game_shm_frame {
+    int cursor_row, cursor_col;   // Where the game left its text cursor
+    struct game_cell cells[GAME_CANVAS_ROWS * GAME_CANVAS_COLS];
+};
+
+struct game_shm {
+    unsigned int magic;
+    unsigned int rows, cols;      // GAME_CANVAS_ROWS and GAME_CANVAS_COLS of the game build
+
+    // Triple buffer: the game draws into a frame it owns, then swaps it with
+    // ready; the launcher swaps its own frame with ready when FRESH is set.
+    // Neither side ever waits for the other.
+    _Atomic unsigned int ready;
+    struct game_shm_frame frames[3];
+
+    // Keys from the launcher to the game, already decoded into bytes and
+    // game_keys. The launcher only moves key_head, the game only moves
+    // key_tail; key_head doubles as the futex the game sleeps on while it has
+    // nothing to do.
+    _Atomic unsigned int key_head;
+    _Atomic unsigned int key_tail;
+    int keys[GAME_SHM_KEYS];
+
+    // Figures the launcher shows in its overlay, updated with every frame
+    _Atomic long long frame_count;
+    _Atomic long long frame_ns;   // Time the game spent in draw() for the last frame
+    _Atomic int score;
+    _Atomic int status;           // enum game_status, set when the game leaves its loop
+};
+
+#endif
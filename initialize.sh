@@ -27,10 +27,37 @@ sudo mkdir -p bin
 
 # Compile the source files into executables and place them in the bin directory
 echo "Compiling source files into executables..."
-sudo gcc -o bin/game_snake src/src1.c
-sudo gcc -o bin/game_sudoku src/src2.c
-sudo gcc -o bin/game_save_the_princess src/src3.c
-sudo gcc -o bin/main-screen src/main-screen.c
+sudo gcc -o bin/game_snake src/src1.c src/game_runtime.c src/render.c src/input.c -ldl -pthread
+sudo gcc -o bin/game_sudoku src/src2.c src/sudoku.c src/sudoku_bank.c src/sudoku_n.c src/game_runtime.c src/render.c src/input.c -ldl -pthread
+sudo gcc -o bin/game_save_the_princess src/src3.c src/maze.c src/game_runtime.c src/render.c src/input.c -ldl -pthread
+sudo gcc -o bin/game_snake_arena src/src4.c src/battle.c src/pool.c src/game_runtime.c src/render.c src/input.c -ldl -pthread
+sudo gcc -o bin/main-screen src/main-screen.c src/launch.c src/game_runtime.c src/catalog.c src/menu.c src/compositor.c src/daemon.c src/render.c src/input.c -ldl -pthread
+
+# Build the same games as plugins the launcher can run in-process
+echo "Compiling game plugins..."
+sudo gcc -shared -fPIC -DGAME_PLUGIN_BUILD -o bin/game_snake.so src/src1.c
+sudo gcc -shared -fPIC -DGAME_PLUGIN_BUILD -o bin/game_sudoku.so src/src2.c src/sudoku.c src/sudoku_bank.c src/sudoku_n.c
+sudo gcc -shared -fPIC -DGAME_PLUGIN_BUILD -o bin/game_save_the_princess.so src/src3.c src/maze.c
+sudo gcc -shared -fPIC -DGAME_PLUGIN_BUILD -o bin/game_snake_arena.so src/src4.c src/battle.c src/pool.c -pthread
+
+# Check that no game allocates memory while it runs, with a launcher built to count allocations
+echo "Checking the game plugins for allocations while they run..."
+sudo gcc -DVGC_ALLOC_TRACE -o bin/main-screen-alloc src/main-screen.c src/launch.c src/game_runtime.c src/catalog.c src/menu.c src/compositor.c src/daemon.c src/render.c src/input.c -ldl -pthread
+if ! sudo ./bin/main-screen-alloc --bench-alloc bin/game_snake.so bin/game_sudoku.so bin/game_save_the_princess.so bin/game_snake_arena.so; then
+    echo "A game plugin allocates memory while it runs, or could not be checked."
+    sudo rm -f bin/main-screen-alloc
+    exit 1
+fi
+sudo rm -f bin/main-screen-alloc
+
+# Build the command-line tools, optimised since they are run for throughput
+echo "Compiling tools..."
+sudo gcc -O2 -o bin/sudoku-tool src/sudoku_tool.c src/sudoku.c src/sudoku_bank.c src/sudoku_n.c src/pool.c -pthread
+
+# Generate the sudoku puzzle bank offline, 24 bytes a puzzle, for startup.sh to install
+echo "Building the sudoku puzzle bank..."
+sudo mkdir -p data
+sudo ./bin/sudoku-tool --build-bank data/sudoku.bank 100000
 
 # Create a symbolic link for the device file
 echo "Creating a symbolic link for the virtual device file..."
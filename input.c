@@ -0,0 +1,395 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "input.h"
+
+#define KEY_ESCAPE 0x1b
+#define ESCAPE_MAX 16   // Longest escape sequence decoded; longer ones are taken as plain bytes
+
+static struct termios original_termios;
+static int have_original = 0;
+static int current_mode = INPUT_COOKED;
+
+// Fatal signals after which the terminal is put back before the process dies
+static const int fatal_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGQUIT, SIGHUP };
+
+// Function to read the monotonic clock in milliseconds
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// Function to put the terminal back as it was found
+static void restore_terminal(void) {
+    if (have_original && current_mode != INPUT_COOKED) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &original_termios);
+        current_mode = INPUT_COOKED;
+    }
+}
+
+// Signal handler restoring the terminal before the default action of a fatal signal
+static void handle_fatal(int sig) {
+    if (have_original) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &original_termios);  // Async-signal-safe
+    }
+    raise(sig);  // SA_RESETHAND brought back the default action
+}
+
+// Function to switch the terminal to an input_mode
+int input_mode(int mode) {
+    int previous = current_mode;
+    struct termios t;
+
+    if (mode == current_mode) {
+        return previous;
+    }
+    if (!have_original) {
+        if (tcgetattr(STDIN_FILENO, &original_termios) < 0) {
+            return previous;  // Not a terminal, nothing to switch
+        }
+        have_original = 1;
+        atexit(restore_terminal);
+
+        // Leave signals the program handles itself alone
+        for (size_t i = 0; i < sizeof(fatal_signals) / sizeof(fatal_signals[0]); i++) {
+            struct sigaction sa, old;
+            if (sigaction(fatal_signals[i], NULL, &old) == 0 && old.sa_handler == SIG_DFL) {
+                memset(&sa, 0, sizeof(sa));
+                sa.sa_handler = handle_fatal;
+                sa.sa_flags = SA_RESETHAND | SA_NODEFER;
+                sigemptyset(&sa.sa_mask);
+                sigaction(fatal_signals[i], &sa, NULL);
+            }
+        }
+    }
+
+    t = original_termios;
+    if (mode == INPUT_KEYS) {
+        t.c_lflag &= ~(ICANON | ECHO);  // Disable canonical mode and echo
+        t.c_cc[VMIN] = 1;
+        t.c_cc[VTIME] = 0;
+    } else if (mode == INPUT_RELAY) {
+        cfmakeraw(&t);
+    }
+
+    // TCSANOW rather than TCSAFLUSH: keys typed ahead must survive the switch
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &t) == 0) {
+        current_mode = mode;
+    }
+    return previous;
+}
+
+// Function to set up a decoder
+void input_init(struct input *in, int fd) {
+    memset(in, 0, sizeof(*in));
+    in->fd = fd;
+}
+
+// Function to get the decoder of standard input
+struct input *input_stdin(void) {
+    static struct input in;
+    static int ready = 0;
+
+    if (!ready) {
+        input_init(&in, STDIN_FILENO);
+        ready = 1;
+    }
+    return &in;
+}
+
+// Function to move the undecoded bytes to the start of the buffer
+static void compact(struct input *in) {
+    if (in->pos > 0) {
+        memmove(in->buf, in->buf + in->pos, in->len - in->pos);
+        in->len -= in->pos;
+        in->pos = 0;
+    }
+}
+
+// Function to append bytes to the buffer; what does not fit is dropped
+void input_feed(struct input *in, const void *bytes, size_t n) {
+    compact(in);
+    if (n > (size_t)(INPUT_BUF - in->len)) {
+        n = INPUT_BUF - in->len;
+    }
+    memcpy(in->buf + in->len, bytes, n);
+    in->len += n;
+}
+
+// Function to map a CSI sequence (ESC [ params final) to a key, INPUT_NONE if it means nothing here
+static int csi_key(const unsigned char *params, int len, unsigned char final) {
+    int number = 0;
+
+    // Only the first parameter matters; modifiers such as ";5" for Ctrl are ignored
+    for (int i = 0; i < len && params[i] >= '0' && params[i] <= '9'; i++) {
+        number = number * 10 + (params[i] - '0');
+    }
+
+    switch (final) {
+    case 'A':
+        return GAME_KEY_UP;
+    case 'B':
+        return GAME_KEY_DOWN;
+    case 'C':
+        return GAME_KEY_RIGHT;
+    case 'D':
+        return GAME_KEY_LEFT;
+    case 'H':
+        return GAME_KEY_HOME;
+    case 'F':
+        return GAME_KEY_END;
+    case '~':
+        switch (number) {
+        case 1:
+        case 7:
+            return GAME_KEY_HOME;
+        case 2:
+            return GAME_KEY_INSERT;
+        case 3:
+            return GAME_KEY_DELETE;
+        case 4:
+        case 8:
+            return GAME_KEY_END;
+        case 5:
+            return GAME_KEY_PAGE_UP;
+        case 6:
+            return GAME_KEY_PAGE_DOWN;
+        }
+    }
+    return INPUT_NONE;
+}
+
+// Function to decode the escape sequence starting at p[0] (ESC).
+// Returns its length with the key in *key, 0 if it is cut short, -1 if it is not one.
+static int decode_escape(const unsigned char *p, int n, int *key) {
+    if (n < 2) {
+        return 0;
+    }
+
+    // SS3, sent for the arrows and Home/End in application cursor mode
+    if (p[1] == 'O') {
+        if (n < 3) {
+            return 0;
+        }
+        *key = p[2] >= 'A' && p[2] <= 'H' ? csi_key(NULL, 0, p[2]) : INPUT_NONE;
+        return 3;
+    }
+    if (p[1] != '[') {
+        return -1;  // ESC before a plain key, e.g. Alt held down
+    }
+
+    // CSI: parameter and intermediate bytes, then a final byte
+    for (int i = 2; i < n; i++) {
+        if (p[i] >= 0x40 && p[i] <= 0x7e) {
+            *key = csi_key(p + 2, i - 2, p[i]);
+            return i + 1;
+        }
+        if (p[i] < 0x20 || p[i] > 0x3f || i >= ESCAPE_MAX) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to decode the next buffered key
+int input_next(struct input *in, int flush) {
+    while (in->pos < in->len) {
+        const unsigned char *p = in->buf + in->pos;
+        int key = INPUT_NONE;
+
+        if (p[0] != KEY_ESCAPE) {
+            in->pos++;
+            return p[0];
+        }
+
+        int used = decode_escape(p, in->len - in->pos, &key);
+        if (used == 0 && !flush) {
+            return INPUT_NONE;  // Wait for the rest of the sequence
+        }
+        if (used <= 0) {
+            in->pos++;
+            return KEY_ESCAPE;  // A key of its own
+        }
+        in->pos += used;
+        if (key != INPUT_NONE) {
+            return key;
+        }
+        // Sequences for keys nobody uses are dropped
+    }
+    return INPUT_NONE;
+}
+
+// Function to read whatever is available on the fd into the buffer
+ssize_t input_fill(struct input *in) {
+    compact(in);
+    ssize_t n = read(in->fd, in->buf + in->len, INPUT_BUF - in->len);
+    in->reads++;
+    if (n > 0) {
+        in->len += n;
+    }
+    return n;
+}
+
+// Function to wait for the next key from the fd
+int input_read(struct input *in, int timeout_ms) {
+    long long deadline = timeout_ms >= 0 ? now_ms() + timeout_ms : -1;
+
+    for (;;) {
+        int key = input_next(in, 0);
+        if (key != INPUT_NONE) {
+            return key;
+        }
+
+        // A lone ESC is only told apart from the start of a sequence by the pause after it
+        int partial = in->pos < in->len;
+        int wait = -1;
+        if (deadline >= 0) {
+            long long left = deadline - now_ms();
+            wait = left > 0 ? (int)left : 0;
+        }
+        if (partial) {
+            wait = INPUT_ESC_MS;
+        }
+
+        struct pollfd pfd = { .fd = in->fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, wait);
+        if (ready < 0) {
+            return INPUT_NONE;  // Interrupted by a signal
+        }
+        if (ready == 0) {
+            return partial ? input_next(in, 1) : INPUT_NONE;
+        }
+
+        // Take everything that arrived, not just one key
+        ssize_t n = input_fill(in);
+        if (n > 0) {
+            continue;
+        }
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+            return INPUT_NONE;
+        }
+
+        // End of input: what is still buffered goes out first
+        key = input_next(in, 1);
+        return key != INPUT_NONE ? key : INPUT_EOF;
+    }
+}
+
+// Function to take the raw bytes that were read but not decoded
+size_t input_take(struct input *in, void *buf, size_t cap) {
+    size_t n = in->len - in->pos;
+
+    if (n > cap) {
+        n = cap;
+    }
+    memcpy(buf, in->buf + in->pos, n);
+    in->pos += n;
+    return n;
+}
+
+// Function to read the monotonic clock in nanoseconds
+static long long bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to write a burst into the pipe and decode it, returns the number of mismatches
+static int check_burst(struct input *in, int fd, const char *name, const char *bytes, size_t len,
+                       const int *want, int count, int repeat) {
+    long long reads = in->reads;
+    int failures = 0;
+
+    for (int r = 0; r < repeat; r++) {
+        if (write(fd, bytes, len) != (ssize_t)len) {
+            return 1;
+        }
+    }
+
+    long long start = bench_now();
+    for (int r = 0; r < repeat; r++) {
+        for (int i = 0; i < count; i++) {
+            int key = input_read(in, 100);
+            if (key != want[i]) {
+                if (failures++ == 0) {
+                    fprintf(stderr, "%s: key %d is %d, expected %d\n", name, r * count + i, key, want[i]);
+                }
+            }
+        }
+    }
+    long long elapsed = bench_now() - start;
+
+    printf("%-12s %6d keys from %6zu bytes in %4lld reads, %.1f ns per key: %s\n", name, count * repeat,
+           len * repeat, in->reads - reads, (double)elapsed / (count * repeat), failures ? "FAILED" : "ok");
+    return failures;
+}
+
+// Function to check the decoder against pasted, auto-repeated and split input
+int input_bench(void) {
+    static int paste_keys[4096];
+    static char paste[4096];
+    int fds[2];
+    struct input in;
+    int failures = 0;
+
+    if (pipe(fds) < 0) {
+        perror("pipe");
+        return 1;
+    }
+    input_init(&in, fds[0]);
+
+    // Pasted text: every byte is a key of its own
+    for (int i = 0; i < (int)sizeof(paste); i++) {
+        paste[i] = "the quick brown fox jumps over the lazy dog\n"[i % 44];
+        paste_keys[i] = (unsigned char)paste[i];
+    }
+    failures += check_burst(&in, fds[1], "paste", paste, sizeof(paste), paste_keys, sizeof(paste), 1);
+
+    // Auto-repeated arrows arrive many to a read
+    static const int up[] = { GAME_KEY_UP };
+    failures += check_burst(&in, fds[1], "auto-repeat", "\033[A", 3, up, 1, 2000);
+
+    // Every form the decoder knows, mixed with plain keys
+    static const char mixed[] = "w\033[B\033OC\033[1;5D\033[5~\033[6~\033[3~\033[2~x\033[H\033[4~\033OF"
+                                "\033[99z" "k\033x";
+    static const int mixed_keys[] = {
+        'w', GAME_KEY_DOWN, GAME_KEY_RIGHT, GAME_KEY_LEFT, GAME_KEY_PAGE_UP, GAME_KEY_PAGE_DOWN,
+        GAME_KEY_DELETE, GAME_KEY_INSERT, 'x', GAME_KEY_HOME, GAME_KEY_END, GAME_KEY_END, 'k', KEY_ESCAPE, 'x',
+    };
+    failures += check_burst(&in, fds[1], "sequences", mixed, sizeof(mixed) - 1, mixed_keys,
+                            sizeof(mixed_keys) / sizeof(mixed_keys[0]), 200);
+
+    // A lone ESC becomes a key once INPUT_ESC_MS pass without the rest of a sequence
+    int split_ok = write(fds[1], "\033", 1) == 1;
+    long long start = bench_now();
+    split_ok &= input_read(&in, 0) == KEY_ESCAPE;
+    long long esc_ns = bench_now() - start;
+
+    // The start of a sequence is kept until the next read brings the rest
+    input_feed(&in, "\033[1;", 4);
+    split_ok &= input_next(&in, 0) == INPUT_NONE;
+    split_ok &= write(fds[1], "5Cz", 3) == 3;
+    split_ok &= input_read(&in, 100) == GAME_KEY_RIGHT && input_read(&in, 100) == 'z';
+    printf("%-12s lone ESC after %.1f ms, sequence split over reads: %s\n", "split", esc_ns / 1e6,
+           split_ok ? "ok" : "FAILED");
+    failures += !split_ok;
+
+    // Keys written before the end of input are still delivered
+    int eof_ok = write(fds[1], "ab", 2) == 2;
+    close(fds[1]);
+    eof_ok &= input_read(&in, 100) == 'a' && input_read(&in, 100) == 'b' && input_read(&in, 100) == INPUT_EOF;
+    printf("%-12s keys before end of input: %s\n", "eof", eof_ok ? "ok" : "FAILED");
+    failures += !eof_ok;
+
+    close(fds[0]);
+    return failures == 0 ? 0 : 1;
+}
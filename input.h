@@ -0,0 +1,64 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "game_plugin.h"
+
+#define INPUT_NONE -1     // No key yet
+#define INPUT_EOF -2      // The input was closed
+#define INPUT_BUF 512     // Bytes taken per read()
+#define INPUT_ESC_MS 25   // How long the rest of an escape sequence may take to arrive
+
+// Terminal settings chosen with input_mode()
+enum input_mode {
+    INPUT_COOKED,   // As the terminal was found
+    INPUT_KEYS,     // Keys arrive one by one without echo; Ctrl-C and Ctrl-Z still raise signals
+    INPUT_RELAY,    // Every byte is passed through, for relaying to a game's own terminal
+};
+
+// Keys read from one fd: bytes are read in batches into buf and decoded from
+// there, so a burst of keys costs one read() rather than one per key
+struct input {
+    int fd;
+    unsigned char buf[INPUT_BUF];
+    int pos, len;        // Bytes buf[pos..len) are not decoded yet
+    long long reads;     // read() calls made so far
+};
+
+// Set up a decoder reading fd
+void input_init(struct input *in, int fd);
+
+// The decoder of standard input, shared by the launcher and the games it runs
+// in-process so that keys typed ahead are never lost between the two
+struct input *input_stdin(void);
+
+// Add bytes that arrived some other way, e.g. on a daemon's socket
+void input_feed(struct input *in, const void *bytes, size_t n);
+
+// Take the next key from the bytes already buffered: a byte, a game_key, or
+// INPUT_NONE. An escape sequence cut short by the end of the buffer is kept
+// for later unless flush is set, in which case its bytes are keys of their own.
+int input_next(struct input *in, int flush);
+
+// Read what has arrived on the fd with one read(), for callers that wait for
+// the fd themselves. Returns the bytes read, 0 at the end of the input, -1 on error.
+ssize_t input_fill(struct input *in);
+
+// Wait up to timeout_ms (-1 forever) for the next key from the fd.
+// Returns INPUT_NONE on timeout or when a signal interrupts the wait.
+int input_read(struct input *in, int timeout_ms);
+
+// Take up to cap raw bytes that are buffered but not decoded yet, returns how many
+size_t input_take(struct input *in, void *buf, size_t cap);
+
+// Switch the terminal on standard input to an input_mode, returns the previous
+// mode. The first switch saves the original settings, which are put back at
+// exit() and on fatal signals as well.
+int input_mode(int mode);
+
+// Check the decoder against bursts of pasted and auto-repeated keys, returns 0 if all pass
+int input_bench(void);
+
+#endif
@@ -0,0 +1,771 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <spawn.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <linux/futex.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "compositor.h"
+#include "game_runtime.h"
+#include "game_shm.h"
+#include "input.h"
+#include "launch.h"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+#define CGROUP_ROOT "/sys/fs/cgroup"
+#define COMPOSITE_MS 16   // Compositor refresh period, about 60 frames per second
+#define KEY_CTRL_C 0x03
+#define KEY_CTRL_Z 0x1a   // Suspends the running game
+#define RELAY_KEYS 64     // Keys passed to a composited game at once
+
+extern char **environ;
+
+// Function to read the monotonic clock in nanoseconds
+long long launch_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to reset a result before a game runs
+static void launch_result_init(struct launch_result *res) {
+    memset(res, 0, sizeof(*res));
+    res->first_output_us = -1;
+}
+
+// Function to write a whole buffer, retrying on short writes
+static void write_all(int fd, const char *buf, ssize_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+// Function to open a pty master and return the path of its slave side
+static int open_pty(char *slave_path, size_t len) {
+    int master = open("/dev/ptmx", O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0) {
+        return -1;
+    }
+    if (grantpt(master) < 0 || unlockpt(master) < 0 || ptsname_r(master, slave_path, len) != 0) {
+        close(master);
+        return -1;
+    }
+
+    // Give the game the same window size as the real terminal
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
+        ioctl(master, TIOCSWINSZ, &ws);
+    }
+    return master;
+}
+
+// Function to spawn the game as a session leader with tty_path as its terminal.
+// shm_fd, if not -1, is handed to the game as its compositor segment, and
+// snapshot, if not NULL, names the file the game suspends into.
+static int spawn_game(const char *path, const char *tty_path, int shm_fd, const char *snapshot, pid_t *pid) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t none, defaults;
+    char *argv[] = { (char *)path, NULL };
+    char **envp;
+    char shm_env[32];
+    char snapshot_env[PATH_MAX + 32];
+
+    sigemptyset(&none);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGTERM);
+    sigaddset(&defaults, SIGPIPE);
+
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+
+    // Opening a pty slave after setsid() makes it the controlling terminal of the game
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, tty_path, O_RDWR, 0);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, STDIN_FILENO, STDERR_FILENO);
+
+    // The environment of the launcher plus where to find the segment and the snapshot
+    int n = 0;
+    while (environ[n] != NULL) {
+        n++;
+    }
+    envp = malloc((n + 3) * sizeof(*envp));
+    if (envp == NULL) {
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attr);
+        return -1;
+    }
+    memcpy(envp, environ, n * sizeof(*envp));
+    if (shm_fd >= 0) {
+        snprintf(shm_env, sizeof(shm_env), "%s=%d", GAME_SHM_ENV, GAME_SHM_FD);
+        envp[n++] = shm_env;
+        posix_spawn_file_actions_adddup2(&actions, shm_fd, GAME_SHM_FD);
+    }
+    if (snapshot != NULL) {
+        snprintf(snapshot_env, sizeof(snapshot_env), "%s=%s", GAME_SNAPSHOT_ENV, snapshot);
+        envp[n++] = snapshot_env;
+    }
+    envp[n] = NULL;
+
+    int err = posix_spawn(pid, path, &actions, &attr, argv, envp);
+
+    free(envp);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+// Function to give the game its own cgroup v2 leaf under the launcher's cgroup.
+// Fails quietly on cgroup v1 hosts or without permission to create cgroups.
+static int cgroup_enter(pid_t pid, char *path, size_t len) {
+    char line[512];
+    char *own = NULL;
+
+    if (access(CGROUP_ROOT "/cgroup.controllers", F_OK) < 0) {
+        return -1;  // Not a unified hierarchy
+    }
+
+    FILE *f = fopen("/proc/self/cgroup", "r");
+    if (f == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, "0::", 3) == 0) {
+            own = line + 3;
+            own[strcspn(own, "\n")] = '\0';
+            break;
+        }
+    }
+    fclose(f);
+    if (own == NULL) {
+        return -1;
+    }
+
+    snprintf(path, len, "%s%s/vgc-game-%d", CGROUP_ROOT, strcmp(own, "/") == 0 ? "" : own, (int)pid);
+    if (mkdir(path, 0755) < 0) {
+        return -1;
+    }
+
+    char procs[PATH_MAX + 32];
+    snprintf(procs, sizeof(procs), "%s/cgroup.procs", path);
+    int fd = open(procs, O_WRONLY | O_CLOEXEC);
+    int n = snprintf(line, sizeof(line), "%d", (int)pid);
+    if (fd < 0 || write(fd, line, n) != n) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        rmdir(path);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+// Function to read the cgroup totals of a finished game and remove its leaf.
+// The game joins the cgroup just after exec, so keep whichever figure is larger.
+static void cgroup_collect(const char *path, struct launch_result *res) {
+    char file[PATH_MAX + 32];
+    char key[64];
+    long long value;
+
+    snprintf(file, sizeof(file), "%s/cpu.stat", path);
+    FILE *f = fopen(file, "r");
+    if (f != NULL) {
+        while (fscanf(f, "%63s %lld", key, &value) == 2) {
+            if (strcmp(key, "user_usec") == 0 && value > res->user_us) {
+                res->user_us = value;
+            } else if (strcmp(key, "system_usec") == 0 && value > res->sys_us) {
+                res->sys_us = value;
+            }
+        }
+        fclose(f);
+    }
+
+    // Only present when the memory controller is enabled for the leaf
+    snprintf(file, sizeof(file), "%s/memory.peak", path);
+    f = fopen(file, "r");
+    if (f != NULL) {
+        if (fscanf(f, "%lld", &value) == 1 && value / 1024 > res->max_rss_kb) {
+            res->max_rss_kb = value / 1024;
+        }
+        fclose(f);
+    }
+
+    res->cgroup = 1;
+    rmdir(path);
+}
+
+// Function to copy the figures of a reaped game into the result
+static void usage_from_rusage(struct launch_result *res, const struct rusage *ru) {
+    res->user_us = (long long)ru->ru_utime.tv_sec * 1000000 + ru->ru_utime.tv_usec;
+    res->sys_us = (long long)ru->ru_stime.tv_sec * 1000000 + ru->ru_stime.tv_usec;
+    res->max_rss_kb = ru->ru_maxrss;
+    res->nvcsw = ru->ru_nvcsw;
+    res->nivcsw = ru->ru_nivcsw;
+}
+
+// Function to finish a game that exited: resource usage, cgroup and file descriptors
+static void finish_process(struct launch_job *job, struct launch_result *res, const struct rusage *ru) {
+    usage_from_rusage(res, ru);
+    if (job->in_cgroup) {
+        cgroup_collect(job->cgroup_path, res);
+    }
+    if (job->pidfd >= 0) {
+        close(job->pidfd);
+    }
+}
+
+// Function to wait for a game that was asked to suspend; returns 1 once it
+// stopped, 0 if it is still running and -1 if it exited instead
+static int check_stopped(struct launch_job *job, struct launch_result *res, struct rusage *ru) {
+    if (wait4(job->pid, &res->status, WNOHANG | WUNTRACED, ru) != job->pid) {
+        return 0;
+    }
+    return WIFSTOPPED(res->status) ? 1 : -1;
+}
+
+// Function to forward keys to a game's pty; Ctrl-Z asks the game to save itself and stop
+static void relay_keys(struct launch_job *job, char *buf, ssize_t n, int *suspending) {
+    char *z = n > 0 ? memchr(buf, KEY_CTRL_Z, n) : NULL;
+    if (z != NULL) {
+        n = z - buf;
+        if (!*suspending) {
+            kill(job->pid, SIGTSTP);
+            *suspending = 1;
+        }
+    }
+    if (n > 0) {
+        write_all(job->master, buf, n);
+    }
+}
+
+// Function to relay a game's pty until it exits or stops after Ctrl-Z
+static int run_pty(struct launch_job *job, long long keypress_ns, struct launch_result *res) {
+    char buf[4096];
+    struct rusage ru = {0};
+    int previous_mode = input_mode(INPUT_RELAY);  // Every key goes straight to the game
+    long long start_ns = launch_now_ns();
+
+    int exited = 0, stopped = 0, reaped = 0;
+    int suspending = 0;
+    int pty_open = 1;
+
+    // Keys typed ahead of the game were read by the launcher already
+    relay_keys(job, buf, input_take(input_stdin(), buf, sizeof(buf)), &suspending);
+    while (!exited && !stopped) {
+        struct pollfd fds[3] = {
+            { .fd = STDIN_FILENO, .events = POLLIN },
+            { .fd = pty_open ? job->master : -1, .events = POLLIN },
+            { .fd = job->pidfd, .events = POLLIN },
+        };
+
+        // Stops are not reported through the pidfd, so look for one every few ms while suspending
+        int timeout = suspending || (job->pidfd < 0 && !pty_open) ? 10 : -1;
+        if (poll(fds, 3, timeout) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        // Forward keys to the game as they come, in whole batches
+        if (fds[0].revents & POLLIN) {
+            relay_keys(job, buf, read(STDIN_FILENO, buf, sizeof(buf)), &suspending);
+        }
+
+        // Relay game output to the real terminal
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = read(job->master, buf, sizeof(buf));
+            if (n > 0) {
+                if (res->first_output_us < 0) {
+                    res->first_output_us = (launch_now_ns() - keypress_ns) / 1000;
+                }
+                write_all(STDOUT_FILENO, buf, n);
+                res->output_bytes += n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                pty_open = 0;  // EIO: every slave fd is closed
+            }
+        }
+
+        if (suspending) {
+            int r = check_stopped(job, res, &ru);
+            stopped = r > 0;
+            exited = reaped = r < 0;
+        }
+        if (job->pidfd >= 0) {
+            exited |= (fds[2].revents & POLLIN) != 0;
+        } else if (!pty_open && !stopped && !exited) {
+            exited = reaped = wait4(job->pid, &res->status, WNOHANG, &ru) == job->pid;
+        }
+    }
+    res->run_us = (launch_now_ns() - start_ns) / 1000;
+
+    if (exited && !reaped) {
+        while (wait4(job->pid, &res->status, 0, &ru) < 0 && errno == EINTR) {
+        }
+    }
+
+    // Drain whatever the game wrote just before exiting or stopping
+    int flags = fcntl(job->master, F_GETFL);
+    fcntl(job->master, F_SETFL, flags | O_NONBLOCK);
+    ssize_t n;
+    while (pty_open && (n = read(job->master, buf, sizeof(buf))) > 0) {
+        write_all(STDOUT_FILENO, buf, n);
+        res->output_bytes += n;
+    }
+    fcntl(job->master, F_SETFL, flags);
+    input_mode(previous_mode);
+
+    if (stopped) {
+        res->suspended = 1;  // Keep the pty and the pidfd for launch_resume()
+    } else {
+        close(job->master);
+        finish_process(job, res, &ru);
+    }
+    return 0;
+}
+
+// Function to start a game and relay its pty until it exits
+int launch_game(struct launch_job *job, const char *path, const char *snapshot,
+                long long keypress_ns, struct launch_result *res) {
+    char slave_path[64];
+
+    memset(job, 0, sizeof(*job));
+    job->kind = LAUNCH_PTY;
+    snprintf(job->snapshot, sizeof(job->snapshot), "%s", snapshot != NULL ? snapshot : "");
+    launch_result_init(res);
+
+    job->master = open_pty(slave_path, sizeof(slave_path));
+    if (job->master < 0) {
+        perror("Failed to allocate a pty");
+        return -1;
+    }
+
+    fflush(stdout);
+    if (spawn_game(path, slave_path, -1, snapshot, &job->pid) < 0) {
+        perror("Failed to start game");
+        close(job->master);
+        return -1;
+    }
+    res->pid = job->pid;
+    job->in_cgroup = cgroup_enter(job->pid, job->cgroup_path, sizeof(job->cgroup_path)) == 0;
+
+    // The pidfd becomes readable once the game exits; older kernels fall back to pty hangup
+    job->pidfd = syscall(SYS_pidfd_open, job->pid, 0);
+
+    return run_pty(job, keypress_ns, res);
+}
+
+// Function to create the segment shared with a game in compositor mode
+static struct game_shm *create_shm(int *fd) {
+    *fd = memfd_create("vgc-game", MFD_CLOEXEC);
+    if (*fd < 0) {
+        return NULL;
+    }
+    if (ftruncate(*fd, sizeof(struct game_shm)) < 0) {
+        close(*fd);
+        return NULL;
+    }
+
+    struct game_shm *shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+    if (shm == MAP_FAILED) {
+        close(*fd);
+        return NULL;
+    }
+
+    // memfd pages start zeroed; the game draws into frame 0 and we hold frame 2
+    shm->magic = GAME_SHM_MAGIC;
+    shm->rows = GAME_CANVAS_ROWS;
+    shm->cols = GAME_CANVAS_COLS;
+    atomic_store(&shm->ready, 1);
+    return shm;
+}
+
+// Function to queue keys for the game and wake it if it sleeps on the ring
+static void push_keys(struct game_shm *shm, const int *keys, int n) {
+    unsigned int head = atomic_load_explicit(&shm->key_head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&shm->key_tail, memory_order_acquire);
+
+    for (int i = 0; i < n && head - tail < GAME_SHM_KEYS; i++) {
+        shm->keys[head % GAME_SHM_KEYS] = keys[i];
+        head++;
+    }
+    atomic_store_explicit(&shm->key_head, head, memory_order_release);
+    syscall(SYS_futex, (unsigned int *)&shm->key_head, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// Function to composite a game's frames until it exits or stops after Ctrl-Z
+static int run_composited(struct launch_job *job, long long keypress_ns, struct launch_result *res) {
+    char overlay[GAME_CANVAS_COLS + 1];
+    struct game_shm *shm = job->shm;
+    struct compositor comp;
+    struct rusage ru = {0};
+
+    int previous_mode = input_mode(INPUT_RELAY);  // Ctrl-C and Ctrl-Z arrive as keys
+    compositor_init(&comp);
+
+    long long start_ns = launch_now_ns();
+    long long fps_start = start_ns;
+    int fps_frames = 0, fps = 0;
+    int exited = 0, stopped = 0;
+    int suspending = 0;
+
+    overlay[0] = '\0';
+    while (!exited && !stopped) {
+        int keys[RELAY_KEYS], count = 0;
+
+        // Look more often right after a start or resume so the first frame shows up at once.
+        // Keys are decoded here, so the game gets arrows rather than escape sequences; all
+        // of them are passed on, a batch at a time.
+        int timeout = launch_now_ns() - start_ns < 50000000LL ? 1 : COMPOSITE_MS;
+        for (int key = input_read(input_stdin(), timeout); key >= 0; key = input_next(input_stdin(), 0)) {
+            if (key == KEY_CTRL_Z) {
+                if (!suspending) {
+                    kill(job->pid, SIGTSTP);
+                    suspending = 1;
+                }
+                break;  // Keys typed after it wait for the resume
+            }
+            if (key == KEY_CTRL_C) {
+                kill(job->pid, SIGTERM);  // Raw mode delivers Ctrl-C as a key; stop the game
+                continue;
+            }
+            keys[count++] = key;
+            if (count == RELAY_KEYS) {
+                push_keys(shm, keys, count);
+                count = 0;
+            }
+        }
+        if (count > 0) {
+            push_keys(shm, keys, count);
+        }
+
+        int r = check_stopped(job, res, &ru);
+        stopped = r > 0;
+        exited = r < 0;
+
+        // Take the newest frame, if the game published one since the last look; otherwise
+        // send the one held back for a slow terminal if the link had time to drain
+        if ((atomic_load_explicit(&shm->ready, memory_order_relaxed) & GAME_SHM_FRESH) == 0) {
+            if (render_wait_ms(&comp.screen) >= 0) {
+                render_flush(&comp.screen);
+                comp.bytes = comp.screen.bytes;
+            }
+            continue;
+        }
+        job->front = atomic_exchange_explicit(&shm->ready, job->front, memory_order_acq_rel) & ~GAME_SHM_FRESH;
+
+        long long now = launch_now_ns();
+        fps_frames++;
+        if (now - fps_start >= 1000000000LL) {
+            fps = fps_frames;
+            fps_frames = 0;
+            fps_start = now;
+        }
+        snprintf(overlay, sizeof(overlay), " score %d | frame %.2f ms | %d fps%s | Ctrl-Z suspends, Ctrl-C stops ",
+                 atomic_load_explicit(&shm->score, memory_order_relaxed),
+                 atomic_load_explicit(&shm->frame_ns, memory_order_relaxed) / 1e6, fps,
+                 comp.screen.dropped > 0 ? " (slow link)" : "");
+        compositor_draw(&comp, &shm->frames[job->front], overlay);
+
+        if (res->first_output_us < 0) {
+            res->first_output_us = (now - keypress_ns) / 1000;
+        }
+    }
+    res->run_us = (launch_now_ns() - start_ns) / 1000;
+
+    compositor_finish(&comp, &shm->frames[job->front]);
+    res->output_bytes = comp.bytes;
+    compositor_free(&comp);
+    input_mode(previous_mode);
+
+    if (stopped) {
+        res->suspended = 1;  // Keep the segment for launch_resume()
+    } else {
+        munmap(shm, sizeof(*shm));
+        job->shm = NULL;
+        finish_process(job, res, &ru);
+    }
+    return 0;
+}
+
+// Function to run a game that draws into shared memory while the launcher owns the terminal
+int launch_composited(struct launch_job *job, const char *path, const char *snapshot,
+                      long long keypress_ns, struct launch_result *res) {
+    int shm_fd;
+
+    memset(job, 0, sizeof(*job));
+    job->kind = LAUNCH_COMPOSITED;
+    snprintf(job->snapshot, sizeof(job->snapshot), "%s", snapshot != NULL ? snapshot : "");
+    launch_result_init(res);
+
+    job->shm = create_shm(&shm_fd);
+    if (job->shm == NULL) {
+        perror("Failed to create compositor segment");
+        return -1;
+    }
+    job->front = 2;  // Frame of the triple buffer the compositor reads
+
+    fflush(stdout);
+    if (spawn_game(path, "/dev/null", shm_fd, snapshot, &job->pid) < 0) {
+        perror("Failed to start game");
+        munmap(job->shm, sizeof(*job->shm));
+        close(shm_fd);
+        return -1;
+    }
+    close(shm_fd);
+    res->pid = job->pid;
+    job->pidfd = -1;  // The compositor polls wait4() every frame anyway
+    job->in_cgroup = cgroup_enter(job->pid, job->cgroup_path, sizeof(job->cgroup_path)) == 0;
+
+    return run_composited(job, keypress_ns, res);
+}
+
+// Function to run a plugin session until it is over or suspended
+static int run_plugin(struct launch_job *job, long long keypress_ns, struct launch_result *res) {
+    struct rusage before, after;
+
+    res->output_bytes = -1;  // Frames go straight to our own stdout
+    res->pid = getpid();
+
+    fflush(stdout);
+    job->session.first_frame_ns = 0;
+    long long start_ns = launch_now_ns();
+    getrusage(RUSAGE_SELF, &before);
+    int status = game_session_run(&job->session);
+    res->run_us = (launch_now_ns() - start_ns) / 1000;
+    getrusage(RUSAGE_SELF, &after);
+
+    // CPU time and context switches are the difference over the session;
+    // the peak RSS is the launcher's, which now includes the plugin
+    usage_from_rusage(res, &after);
+    res->user_us -= (long long)before.ru_utime.tv_sec * 1000000 + before.ru_utime.tv_usec;
+    res->sys_us -= (long long)before.ru_stime.tv_sec * 1000000 + before.ru_stime.tv_usec;
+    res->nvcsw -= before.ru_nvcsw;
+    res->nivcsw -= before.ru_nivcsw;
+    if (job->session.first_frame_ns != 0) {
+        res->first_output_us = (job->session.first_frame_ns - keypress_ns) / 1000;
+    }
+
+    // A suspended plugin keeps its state in memory; the snapshot is for the next launcher
+    if (status == GAME_SUSPENDED) {
+        if (job->snapshot[0] != '\0') {
+            game_session_save(&job->session, job->snapshot);
+        }
+        res->suspended = 1;
+        return 0;
+    }
+
+    game_session_end(&job->session);
+    dlclose(job->handle);
+    if (job->snapshot[0] != '\0') {
+        unlink(job->snapshot);  // A finished game starts afresh next time
+    }
+    return 0;
+}
+
+// Function to run a plugin in-process, without creating a process or a pty
+int launch_plugin(struct launch_job *job, const char *path, const char *snapshot,
+                  long long keypress_ns, struct launch_result *res) {
+    memset(job, 0, sizeof(*job));
+    job->kind = LAUNCH_PLUGIN;
+    snprintf(job->snapshot, sizeof(job->snapshot), "%s", snapshot != NULL ? snapshot : "");
+    launch_result_init(res);
+
+    const struct game_plugin *plugin = game_plugin_open(path, &job->handle);
+    if (plugin == NULL) {
+        return -1;
+    }
+
+    // Pick up where a suspended run of this game left off
+    unsigned int seed = (unsigned int)time(NULL) ^ (unsigned int)launch_now_ns();
+    if ((snapshot == NULL || game_session_restore(&job->session, plugin, seed, snapshot) != 0)
+        && game_session_start(&job->session, plugin, seed) != 0) {
+        dlclose(job->handle);
+        return -1;
+    }
+    return run_plugin(job, keypress_ns, res);
+}
+
+// Function to continue a suspended game
+int launch_resume(struct launch_job *job, long long keypress_ns, struct launch_result *res) {
+    launch_result_init(res);
+    res->pid = job->pid;
+
+    switch (job->kind) {
+    case LAUNCH_PTY:
+        kill(job->pid, SIGCONT);  // The game redraws as soon as it runs again
+        return run_pty(job, keypress_ns, res);
+    case LAUNCH_COMPOSITED:
+        kill(job->pid, SIGCONT);
+        return run_composited(job, keypress_ns, res);
+    default:
+        return run_plugin(job, keypress_ns, res);
+    }
+}
+
+// Function to end a suspended game for good; its snapshot stays on disk
+void launch_discard(struct launch_job *job) {
+    if (job->kind == LAUNCH_PLUGIN) {
+        game_session_end(&job->session);
+        dlclose(job->handle);
+        return;
+    }
+
+    // SIGKILL is the one signal a stopped process acts on right away
+    kill(job->pid, SIGKILL);
+    while (waitpid(job->pid, NULL, 0) < 0 && errno == EINTR) {
+    }
+    if (job->pidfd >= 0) {
+        close(job->pidfd);
+    }
+    if (job->kind == LAUNCH_PTY) {
+        close(job->master);
+    } else {
+        munmap(job->shm, sizeof(*job->shm));
+    }
+    if (job->in_cgroup) {
+        rmdir(job->cgroup_path);
+    }
+}
+
+// Function to describe how a game ended, e.g. "0", "signal 9" or "suspended"
+static void exit_description(const struct launch_result *res, char *buf, size_t len) {
+    if (res->suspended) {
+        snprintf(buf, len, "suspended");
+    } else if (WIFSIGNALED(res->status)) {
+        snprintf(buf, len, "signal %d", WTERMSIG(res->status));
+    } else {
+        snprintf(buf, len, "%d", WEXITSTATUS(res->status));
+    }
+}
+
+// Function to write a CSV field, quoted with its quotes doubled when it holds
+// a comma, a quote or a line break
+static void write_csv_field(FILE *f, const char *text) {
+    if (strpbrk(text, ",\"\r\n") == NULL) {
+        fputs(text, f);
+        return;
+    }
+    fputc('"', f);
+    for (const char *p = text; *p != '\0'; p++) {
+        if (*p == '"') {
+            fputc('"', f);
+        }
+        fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+// Function to write a JSON string, escaping quotes, backslashes and control characters
+static void write_json_string(FILE *f, const char *text) {
+    fputc('"', f);
+    for (const unsigned char *p = (const unsigned char *)text; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(f, "\\%c", *p);
+        } else if (*p < 0x20 || *p == 0x7f) {
+            fprintf(f, "\\u%04x", *p);
+        } else {
+            fputc(*p, f);
+        }
+    }
+    fputc('"', f);
+}
+
+// Function to append the metrics of one session as a CSV line
+void launch_log_metrics(const char *file, const char *game, const struct launch_result *res) {
+    FILE *f = fopen(file, "a");
+    if (f == NULL) {
+        return;
+    }
+
+    // Write the header the first time the file is used
+    fseek(f, 0, SEEK_END);
+    if (ftell(f) == 0) {
+        fprintf(f, "time,game,pid,exit,first_output_us,run_us\n");
+    }
+
+    char exit_desc[32];
+    exit_description(res, exit_desc, sizeof(exit_desc));
+
+    fprintf(f, "%ld,", (long)time(NULL));
+    write_csv_field(f, game);
+    fprintf(f, ",%d,%s,%lld,%lld\n", (int)res->pid, exit_desc, res->first_output_us, res->run_us);
+    fclose(f);
+}
+
+// Function to append the resource usage of one session to the game's own log
+void launch_log_usage(const char *dir, const char *game, const struct launch_result *res) {
+    char path[PATH_MAX];
+    char exit_desc[32];
+
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) {
+        perror("Failed to create stats directory");
+        return;
+    }
+
+    snprintf(path, sizeof(path), "%s/%s.jsonl", dir, game);
+    FILE *f = fopen(path, "a");
+    if (f == NULL) {
+        perror("Failed to open stats log");
+        return;
+    }
+
+    exit_description(res, exit_desc, sizeof(exit_desc));
+    fprintf(f, "{\"time\":%ld,\"game\":", (long)time(NULL));
+    write_json_string(f, game);
+    fprintf(f, ",\"pid\":%d,\"exit\":\"%s\",\"run_us\":%lld,"
+               "\"user_us\":%lld,\"sys_us\":%lld,\"max_rss_kb\":%ld,\"nvcsw\":%ld,\"nivcsw\":%ld,"
+               "\"output_bytes\":%lld,\"cgroup\":%s}\n",
+            (int)res->pid, exit_desc, res->run_us,
+            res->user_us, res->sys_us, res->max_rss_kb, res->nvcsw, res->nivcsw,
+            res->output_bytes, res->cgroup ? "true" : "false");
+    fclose(f);
+}
+
+// Function to print the resource usage of one session
+void launch_print_usage(const struct launch_result *res) {
+    printf("\nCPU time: %.2f s user, %.2f s system over %.1f s%s\n",
+           res->user_us / 1e6, res->sys_us / 1e6, res->run_us / 1e6, res->cgroup ? " (cgroup)" : "");
+    printf("Peak memory: %ld KB\n", res->max_rss_kb);
+    printf("Context switches: %ld voluntary, %ld involuntary\n", res->nvcsw, res->nivcsw);
+    if (res->output_bytes >= 0) {
+        printf("Terminal output: %lld bytes\n", res->output_bytes);
+    }
+}
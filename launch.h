@@ -0,0 +1,87 @@
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <limits.h>
+#include <sys/types.h>
+
+#include "game_runtime.h"
+#include "game_shm.h"
+
+// How a game is run
+enum launch_kind {
+    LAUNCH_PTY,          // Own process on its own pty
+    LAUNCH_COMPOSITED,   // Own process drawing into shared memory
+    LAUNCH_PLUGIN,       // Plugin inside the launcher
+};
+
+// A started game. Kept by the caller while the game is suspended so that
+// launch_resume() can carry on with the same process or session.
+struct launch_job {
+    int kind;
+    pid_t pid;
+    int pidfd;                      // -1 if the kernel has no pidfd_open()
+    int master;                     // LAUNCH_PTY: pty master
+    struct game_shm *shm;           // LAUNCH_COMPOSITED: shared segment
+    unsigned int front;             // LAUNCH_COMPOSITED: frame the compositor holds
+    void *handle;                   // LAUNCH_PLUGIN: dlopen() handle
+    struct game_session session;    // LAUNCH_PLUGIN: the running game
+    int in_cgroup;
+    char cgroup_path[PATH_MAX];
+    char snapshot[PATH_MAX];        // File the game suspends into, "" for none
+};
+
+// Outcome of one supervised game session
+struct launch_result {
+    pid_t pid;                   // PID of the game process
+    int status;                  // Wait status of the game (see waitpid)
+    long long first_output_us;   // Keypress to first byte written by the game, -1 if none
+    long long run_us;            // Exec to exit
+
+    // Resources used by the game, from wait4() or its cgroup when it had one
+    long long user_us, sys_us;   // CPU time in user and kernel mode
+    long max_rss_kb;             // Peak resident set size
+    long nvcsw, nivcsw;          // Voluntary and involuntary context switches
+    long long output_bytes;      // Bytes the game wrote to the terminal, -1 if not measured
+    int cgroup;                  // Set when the figures come from a cgroup v2 leaf
+    int suspended;               // Set when the game stepped aside with Ctrl-Z; usage is not known yet
+};
+
+// Start a game directly (no shell) on its own pty and supervise it until it
+// exits or is suspended with Ctrl-Z. keypress_ns is the CLOCK_MONOTONIC time of
+// the key that launched the game; snapshot, if not NULL, is the file the game
+// saves itself to when suspended and restores from when it starts.
+// Returns 0 on success, -1 if the game could not be started.
+int launch_game(struct launch_job *job, const char *path, const char *snapshot,
+                long long keypress_ns, struct launch_result *res);
+
+// Start a game in compositor mode: the game draws into a shared-memory frame
+// buffer and reads keys from a ring in the same segment, while the launcher
+// owns the terminal, composites the frames with an overlay and flushes the
+// difference. Same arguments and result as launch_game().
+int launch_composited(struct launch_job *job, const char *path, const char *snapshot,
+                      long long keypress_ns, struct launch_result *res);
+
+// Run a game_*.so plugin inside the launcher process until it is over or suspended.
+// The result uses the launcher's PID and first_output_us measures the first frame.
+int launch_plugin(struct launch_job *job, const char *path, const char *snapshot,
+                  long long keypress_ns, struct launch_result *res);
+
+// Continue a game whose last run ended with res->suspended set
+int launch_resume(struct launch_job *job, long long keypress_ns, struct launch_result *res);
+
+// End a suspended game without resuming it; its snapshot file is kept
+void launch_discard(struct launch_job *job);
+
+// Append one line describing a finished session to the metrics file
+void launch_log_metrics(const char *file, const char *game, const struct launch_result *res);
+
+// Append the resource usage of one session to dir/<game>.jsonl, one JSON object per line
+void launch_log_usage(const char *dir, const char *game, const struct launch_result *res);
+
+// Print the resource usage of one session for the return screen
+void launch_print_usage(const struct launch_result *res);
+
+// Current CLOCK_MONOTONIC time in nanoseconds
+long long launch_now_ns(void);
+
+#endif
@@ -0,0 +1,588 @@
+#include <string.h>
+
+#include "maze.h"
+
+#define CAVE_ROCK_SHARE 115   // Chance out of 256 that a cell starts as rock, about 45%
+#define CAVE_PASSES 4         // Smoothing passes of the cellular automaton
+#define CAVE_ROCK_AT 5        // Rock cells out of the 3x3 around a cell that make it rock
+
+// Rooms, the cells of odd row and column that corridors join, are tracked in
+// a grid of their own, a byte each, with a ring of BORDER rooms around it so
+// that a neighbour is never looked for past the edge. A carved room keeps the
+// direction of the room it was reached from; the maze is drawn from them in
+// one pass at the end, rather than cell by cell all over the grid.
+enum room_state {
+    UNSEEN,
+    FRONTIER,    // Next to the maze, for Prim's algorithm
+    BORDER,
+    FIRST,       // Carved first, reached from nowhere
+    CARVED,      // CARVED + the direction it was reached from, up, right, down or left
+};
+
+// Thirty-two cells of a row at a time, for the cave automaton
+typedef unsigned char bytes __attribute__((vector_size(32)));
+
+// The automaton is compiled for AVX2 as well as for any x86-64, like the
+// sudoku solver; ThreadSanitizer cannot run the resolver, so it gets the plain copy
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && !defined(__SANITIZE_THREAD__)
+#define MAZE_CLONES __attribute__((target_clones("arch=x86-64-v3", "default")))
+#else
+#define MAZE_CLONES
+#endif
+
+// Function to advance a splitmix64 generator
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function to draw a number below n, by multiplying rather than dividing
+static uint32_t below(uint64_t *random, uint32_t n) {
+    return (uint32_t)(((next_random(random) >> 32) * n) >> 32);
+}
+
+// Function to pick one of the set bits of a mask of directions at random:
+// the k-th set bit lies past every direction with at most k bits set up to
+// it, which counts it without a branch the processor could not guess
+static int pick_dir(uint64_t *random, unsigned mask) {
+    unsigned k = below(random, (uint32_t)__builtin_popcount(mask));
+    unsigned upto0 = mask & 1, upto1 = upto0 + (mask >> 1 & 1), upto2 = upto1 + (mask >> 2 & 1);
+    return (int)((upto0 <= k) + (upto1 <= k) + (upto2 <= k));
+}
+
+// Function to mark the cells of a grid holding a value with a one and the
+// others with a zero, 32 cells at a time
+MAZE_CLONES
+static void mark_equal(const char *grid, unsigned char *mark, size_t n, char value) {
+    const bytes match = (bytes){ 0 } + (unsigned char)value, one = (bytes){ 0 } + 1;
+    size_t i = 0;
+
+    for (; i + sizeof(bytes) <= n; i += sizeof(bytes)) {
+        bytes v;
+        memcpy(&v, grid + i, sizeof(v));
+        v = (bytes)(v == match) & one;
+        memcpy(mark + i, &v, sizeof(v));
+    }
+    for (; i < n; i++) {
+        mark[i] = grid[i] == value;
+    }
+}
+
+// Function to open the cells whose mark holds a value and wall the others, 32 cells at a time
+MAZE_CLONES
+static void open_where(char *grid, const unsigned char *mark, size_t n, unsigned char value) {
+    const bytes match = (bytes){ 0 } + value, wall = (bytes){ 0 } + MAZE_WALL;
+    const bytes swap = (bytes){ 0 } + (MAZE_WALL ^ MAZE_OPEN);
+    size_t i = 0;
+
+    for (; i + sizeof(bytes) <= n; i += sizeof(bytes)) {
+        bytes v;
+        memcpy(&v, mark + i, sizeof(v));
+        v = ((bytes)(v == match) & swap) ^ wall;
+        memcpy(grid + i, &v, sizeof(v));
+    }
+    for (; i < n; i++) {
+        grid[i] = mark[i] == value ? MAZE_OPEN : MAZE_WALL;
+    }
+}
+
+// Function to visit the unmarked cells reachable from one, breadth first,
+// marking them and queueing them; returns how many there are, and the steps
+// to the cell to in *steps, -1 if it is not among them. The four neighbours
+// are all read before any is marked, and each is written to the queue
+// whatever it is and only kept if it was unmarked: the reads then overlap
+// and there is no branch for the processor to guess wrong.
+static uint32_t flood(struct maze *m, uint32_t from, uint32_t to, long *steps) {
+    const uint32_t cols = (uint32_t)m->cols;
+    unsigned char *mark = m->mark;
+    uint32_t *queue = m->work;
+    uint32_t head = 0, tail = 0, level_end = 1;
+    long level = 0;
+
+    *steps = -1;
+    mark[from] = 1;
+    queue[tail++] = from;
+    while (head < tail) {
+        if (head == level_end) {
+            level++;             // Every cell of the last level is out, the queue holds the next
+            level_end = tail;
+        }
+        uint32_t cell = queue[head++];
+        if (cell == to) {
+            *steps = level;
+        }
+        uint32_t up = cell - cols, right = cell + 1, down = cell + cols, left = cell - 1;
+        uint32_t free_up = mark[up] == 0, free_right = mark[right] == 0;
+        uint32_t free_down = mark[down] == 0, free_left = mark[left] == 0;
+        mark[up] = mark[right] = mark[down] = mark[left] = 1;
+        queue[tail] = up;
+        tail += free_up;
+        queue[tail] = right;
+        tail += free_right;
+        queue[tail] = down;
+        tail += free_down;
+        queue[tail] = left;
+        tail += free_left;
+    }
+    return tail;
+}
+
+// Function to count the open cells
+static uint32_t count_open(const struct maze *m) {
+    uint32_t open = 0;
+
+    for (uint32_t i = 0; i < m->cells; i++) {
+        open += m->grid[i] != MAZE_WALL;
+    }
+    return open;
+}
+
+// Function to lay out the grid of rooms in the marks, width wide, and carve
+// one at random; returns its place in the grid
+static uint32_t lay_rooms(struct maze *m, uint32_t width, uint64_t *random) {
+    uint32_t room_rows = (uint32_t)(m->rows - 1) / 2, room_cols = width - 2;
+    uint32_t height = room_rows + 2;
+
+    memset(m->mark, UNSEEN, (size_t)height * width);
+    memset(m->mark, BORDER, width);
+    memset(m->mark + (size_t)(height - 1) * width, BORDER, width);
+    for (uint32_t r = 1; r < height - 1; r++) {
+        m->mark[r * width] = m->mark[r * width + width - 1] = BORDER;
+    }
+    uint32_t room = (below(random, room_rows) + 1) * width + below(random, room_cols) + 1;
+    m->mark[room] = FIRST;
+    return room;
+}
+
+// Function to open every carved room and the wall to the room it was reached from
+static void draw_rooms(struct maze *m, uint32_t width) {
+    const uint32_t cols = (uint32_t)m->cols;
+    const uint32_t cell_step[4] = { -cols, 1, cols, (uint32_t)-1 };
+    uint32_t room_rows = (uint32_t)(m->rows - 1) / 2, room_cols = width - 2;
+
+    for (uint32_t r = 0; r < room_rows; r++) {
+        const unsigned char *rooms = m->mark + (r + 1) * width + 1;
+        uint32_t cell = (2 * r + 1) * cols + 1;
+        for (uint32_t c = 0; c < room_cols; c++, cell += 2) {
+            if (rooms[c] >= FIRST) {
+                m->grid[cell] = MAZE_OPEN;
+            }
+            if (rooms[c] >= CARVED) {
+                m->grid[cell + cell_step[rooms[c] - CARVED]] = MAZE_OPEN;
+            }
+        }
+    }
+}
+
+// Function to tell which neighbours of a room are unseen, or carved, as a mask of directions
+static unsigned rooms_unseen(const unsigned char *rooms, uint32_t room, uint32_t width) {
+    return (unsigned)(rooms[room - width] == UNSEEN) | (unsigned)(rooms[room + 1] == UNSEEN) << 1
+           | (unsigned)(rooms[room + width] == UNSEEN) << 2 | (unsigned)(rooms[room - 1] == UNSEEN) << 3;
+}
+
+static unsigned rooms_carved(const unsigned char *rooms, uint32_t room, uint32_t width) {
+    return (unsigned)(rooms[room - width] >= FIRST) | (unsigned)(rooms[room + 1] >= FIRST) << 1
+           | (unsigned)(rooms[room + width] >= FIRST) << 2 | (unsigned)(rooms[room - 1] >= FIRST) << 3;
+}
+
+// Function to carve a maze by walking from room to room, to one not seen yet
+// while there is one and back along the way otherwise: long winding
+// corridors, and exactly one way between any two cells
+static void carve_backtracker(struct maze *m, uint64_t *random) {
+    const uint32_t width = (uint32_t)(m->cols - 1) / 2 + 2;
+    const uint32_t room_step[4] = { -width, 1, width, (uint32_t)-1 };
+    unsigned char *rooms = m->mark;
+    uint32_t *stack = m->work, top = 0;
+
+    stack[top++] = lay_rooms(m, width, random);
+    while (top > 0) {
+        uint32_t room = stack[top - 1];
+        unsigned open = rooms_unseen(rooms, room, width);
+        if (open == 0) {
+            top--;    // A dead end, go back
+            continue;
+        }
+        int dir = pick_dir(random, open);
+        room += room_step[dir];
+        rooms[room] = (unsigned char)(CARVED + ((dir + 2) & 3));
+        stack[top++] = room;
+    }
+    draw_rooms(m, width);
+}
+
+// Function to put the rooms next to a room that are not in the maze nor in
+// the frontier yet in the frontier; returns the rooms it then holds
+static uint32_t add_frontier(struct maze *m, uint32_t width, uint32_t room, uint32_t count) {
+    const uint32_t room_step[4] = { -width, 1, width, (uint32_t)-1 };
+
+    for (int dir = 0; dir < 4; dir++) {
+        uint32_t next = room + room_step[dir];
+        int unseen = m->mark[next] == UNSEEN;
+        m->work[count] = next;
+        count += (uint32_t)unseen;
+        m->mark[next] = unseen ? FRONTIER : m->mark[next];
+    }
+    return count;
+}
+
+// Function to carve a maze by growing it from a room, joining a room picked
+// at random from the ones next to it at every step: short corridors that
+// branch often, and exactly one way between any two cells (Prim's algorithm)
+static void carve_prim(struct maze *m, uint64_t *random) {
+    const uint32_t width = (uint32_t)(m->cols - 1) / 2 + 2;
+    uint32_t count = add_frontier(m, width, lay_rooms(m, width, random), 0);
+
+    while (count > 0) {
+        uint32_t i = below(random, count);
+        uint32_t room = m->work[i];
+        m->work[i] = m->work[--count];
+
+        // The frontier only holds rooms next to the maze, join one of them
+        int dir = pick_dir(random, rooms_carved(m->mark, room, width));
+        m->mark[room] = (unsigned char)(CARVED + dir);
+        count = add_frontier(m, width, room, count);
+    }
+    draw_rooms(m, width);
+}
+
+// Function to run a pass of the cave automaton from one grid of rock bytes to
+// another: the 3x3 sums come from column sums of three rows, so a cell costs
+// a few additions, 32 cells at a time; the border is left alone
+MAZE_CLONES
+static void cave_pass(const struct maze *m, const unsigned char *from, unsigned char *to, unsigned char *sum) {
+    const size_t cols = (size_t)m->cols;
+    const bytes rock_at = (bytes){ 0 } + (CAVE_ROCK_AT - 1), one = (bytes){ 0 } + 1;
+
+    for (size_t r = 1; r + 1 < (size_t)m->rows; r++) {
+        const unsigned char *up = from + (r - 1) * cols, *row = up + cols, *down = row + cols;
+        unsigned char *out = to + r * cols;
+        size_t j = 0;
+
+        for (; j + sizeof(bytes) <= cols; j += sizeof(bytes)) {
+            bytes a, b, c;
+            memcpy(&a, up + j, sizeof(a));
+            memcpy(&b, row + j, sizeof(b));
+            memcpy(&c, down + j, sizeof(c));
+            a += b + c;
+            memcpy(sum + j, &a, sizeof(a));
+        }
+        for (; j < cols; j++) {
+            sum[j] = (unsigned char)(up[j] + row[j] + down[j]);
+        }
+        for (j = 1; j + sizeof(bytes) < cols; j += sizeof(bytes)) {
+            bytes a, b, c;
+            memcpy(&a, sum + j - 1, sizeof(a));
+            memcpy(&b, sum + j, sizeof(b));
+            memcpy(&c, sum + j + 1, sizeof(c));
+            a = (bytes)(a + b + c > rock_at) & one;
+            memcpy(out + j, &a, sizeof(a));
+        }
+        for (; j + 1 < cols; j++) {
+            out[j] = sum[j - 1] + sum[j] + sum[j + 1] >= CAVE_ROCK_AT;
+        }
+    }
+}
+
+// Function to scatter rock over a grid of bytes, 32 cells at a time
+MAZE_CLONES
+static void scatter_rock(unsigned char *rock, size_t n, uint64_t *random) {
+    const bytes share = (bytes){ 0 } + CAVE_ROCK_SHARE, one = (bytes){ 0 } + 1;
+    size_t i = 0;
+
+    for (; i + sizeof(bytes) <= n; i += sizeof(bytes)) {
+        uint64_t r[4] = { next_random(random), next_random(random), next_random(random), next_random(random) };
+        bytes v;
+        memcpy(&v, r, sizeof(v));
+        v = (bytes)(v < share) & one;
+        memcpy(rock + i, &v, sizeof(v));
+    }
+    for (; i < n; i++) {
+        rock[i] = (next_random(random) & 0xff) < CAVE_ROCK_SHARE;
+    }
+}
+
+// Function to give the region of cells marked old around one the mark new,
+// a run along a row at a time, keeping a cell of each run of the rows above
+// and below still to fill on a stack; returns the cells filled. Caverns are
+// wide, so this fills them many cells per step where a search goes cell by cell.
+static uint32_t fill_region(struct maze *m, uint32_t from, unsigned char old, unsigned char new) {
+    const uint32_t cols = (uint32_t)m->cols;
+    unsigned char *mark = m->mark;
+    uint32_t *stack = m->work, top = 0, filled = 0;
+
+    stack[top++] = from;
+    while (top > 0) {
+        uint32_t cell = stack[--top];
+        if (mark[cell] != old) {
+            continue;    // Filled from another run since it was pushed
+        }
+        uint32_t left = cell, right = cell;
+        while (mark[left - 1] == old) {
+            left--;
+        }
+        while (mark[right + 1] == old) {
+            right++;
+        }
+        memset(mark + left, new, right - left + 1);
+        filled += right - left + 1;
+
+        const uint32_t near[2] = { left - cols, left + cols };
+        for (int k = 0; k < 2; k++) {
+            for (uint32_t j = near[k]; j <= near[k] + (right - left); j++) {
+                if (mark[j] == old && (j == near[k] || mark[j - 1] != old)) {
+                    stack[top++] = j;
+                }
+            }
+        }
+    }
+    return filled;
+}
+
+// Function to keep the largest region of open cells joined to each other and
+// wall up the rest, from marks of 0 for open cells and 1 for walls. Each
+// region is filled with a mark of its own, then filled again as walls as
+// soon as a larger one is known, so that no region is filled more than twice.
+static void keep_largest(struct maze *m) {
+    uint32_t best = 0, best_size = 0;
+    unsigned char kept = 2, found = 3;
+
+    for (uint32_t i = 0; i < m->cells; i++) {
+        if (m->mark[i] != 0) {
+            continue;
+        }
+        uint32_t size = fill_region(m, i, 0, found);
+        if (size <= best_size) {
+            fill_region(m, i, found, 1);
+            continue;
+        }
+        if (best_size > 0) {
+            fill_region(m, best, kept, 1);
+        }
+        best = i;
+        best_size = size;
+        found = kept;
+        kept = m->mark[i];
+    }
+    open_where(m->grid, m->mark, m->cells, kept);
+}
+
+// Function to carve caves: rock scattered at random, smoothed by a cellular
+// automaton into open caverns, of which the largest is kept
+static void carve_caves(struct maze *m, uint64_t *random) {
+    size_t cells = m->cells, cols = (size_t)m->cols;
+    unsigned char *from = m->mark, *to = (unsigned char *)m->work, *sum = to + cells;
+
+    scatter_rock(from, cells, random);
+    memset(from, 1, cols);
+    memset(from + cells - cols, 1, cols);
+    for (size_t i = 0; i < cells; i += cols) {
+        from[i] = from[i + cols - 1] = 1;
+    }
+    memcpy(to, from, cells);   // Walls the border of the other grid too
+
+    for (int pass = 0; pass < CAVE_PASSES; pass++) {
+        cave_pass(m, from, to, sum);
+        unsigned char *swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != m->mark) {
+        memcpy(m->mark, from, cells);
+    }
+    keep_largest(m);
+}
+
+// Generators by name
+const struct maze_generator maze_generators[MAZE_GENERATORS] = {
+    { "backtracker", "long winding corridors", carve_backtracker },
+    { "prim", "short branching corridors", carve_prim },
+    { "caves", "open caverns", carve_caves },
+};
+
+// Function to find a generator by name, NULL if there is none
+const struct maze_generator *maze_find(const char *name) {
+    for (int i = 0; name != NULL && i < MAZE_GENERATORS; i++) {
+        if (strcmp(maze_generators[i].name, name) == 0) {
+            return &maze_generators[i];
+        }
+    }
+    return NULL;
+}
+
+// Function to work out the arena bytes a rows x cols maze needs
+size_t maze_arena_size(int rows, int cols) {
+    size_t cells = (size_t)rows * cols;
+    return 2 * arena_round(cells) + arena_round(cells * sizeof(uint32_t));
+}
+
+// Function to carve a maze and its scratch arrays from an arena
+int maze_setup(struct maze *m, struct arena *arena, int rows, int cols) {
+    if (rows < MAZE_MIN_SIDE || rows > MAZE_MAX_SIDE || cols < MAZE_MIN_SIDE || cols > MAZE_MAX_SIDE) {
+        return -1;
+    }
+    memset(m, 0, sizeof(*m));
+    m->rows = rows;
+    m->cols = cols;
+    m->cells = (uint32_t)rows * (uint32_t)cols;
+    m->grid = arena_alloc(arena, m->cells);
+    m->mark = arena_alloc(arena, m->cells);
+    m->work = arena_array(arena, m->cells, sizeof(uint32_t));
+    return m->grid != NULL && m->mark != NULL && m->work != NULL ? 0 : -1;
+}
+
+// Function to generate a maze, falling back on a backtracker maze for caves too small to play in
+uint32_t maze_generate(struct maze *m, const struct maze_generator *generator, uint64_t seed) {
+    uint64_t random = seed;
+
+    memset(m->grid, MAZE_WALL, m->cells);
+    generator->carve(m, &random);
+    uint32_t open = count_open(m);
+    if (open < 2 && generator->carve != carve_backtracker) {
+        memset(m->grid, MAZE_WALL, m->cells);
+        carve_backtracker(m, &random);
+        open = count_open(m);
+    }
+    return open;
+}
+
+// Function to list the cells still open, in order, for the picks below;
+// every cell is written and only the open ones kept, without a branch
+void maze_collect_free(struct maze *m) {
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < m->cells; i++) {
+        m->work[count] = i;
+        count += m->grid[i] == MAZE_OPEN;
+    }
+    m->free_count = count;
+}
+
+// Function to keep cells of the list picked at random: each is kept with the
+// chance of the cells still wanted among those left to read (selection
+// sampling), so the list is read once from start to end, and the cells kept
+// are written over the ones read without a branch
+uint32_t maze_pick_free(struct maze *m, uint32_t want, uint64_t *random) {
+    uint32_t n = m->free_count, kept = 0;
+
+    want = want < n ? want : n;
+    for (uint32_t i = 0; i < n && kept < want; i++) {
+        m->work[kept] = m->work[i];
+        kept += below(random, n - i) < want - kept;
+    }
+    m->free_count = kept;
+    return kept;
+}
+
+// Function to tell whether a cell can be walled in: its open neighbours must
+// still reach each other around it, through the corners between them. On the
+// ring of the eight cells about it, neighbours on even bits and corners on odd
+// ones, each open corner between two open neighbours links them; they are in
+// one piece when there are no more of them than links plus one, or when all
+// four links close the ring.
+int maze_can_block(const struct maze *m, uint32_t cell) {
+    const uint32_t cols = (uint32_t)m->cols;
+    const uint32_t ring[8] = { -cols, 1 - cols, 1, cols + 1, cols, cols - 1, (uint32_t)-1, -cols - 1 };
+    unsigned open = 0;
+
+    for (int i = 0; i < 8; i++) {
+        open |= (unsigned)(m->grid[cell + ring[i]] != MAZE_WALL) << i;
+    }
+    unsigned before = (open << 1 | open >> 7) & 0xff, after = (open >> 1 | open << 7) & 0xff;
+    int neighbours = __builtin_popcount(open & 0x55);
+    int links = __builtin_popcount(open & before & after & 0xaa);
+    return links == 4 || neighbours <= links + 1;
+}
+
+// Function to mark the free cells maze_can_block() would allow walling in
+// with a one and the others with a zero, the test on the ring of each cell
+// worked out for 32 cells at a time; the border is marked zero
+MAZE_CLONES
+static void mark_blockable(const struct maze *m) {
+    const size_t cols = (size_t)m->cols;
+    const bytes wall = (bytes){ 0 } + MAZE_WALL, free = (bytes){ 0 } + MAZE_OPEN;
+    const bytes one = (bytes){ 0 } + 1, four = (bytes){ 0 } + 4;
+
+    memset(m->mark, 0, cols);
+    memset(m->mark + (m->cells - cols), 0, cols);
+    for (size_t r = 1; r + 1 < (size_t)m->rows; r++) {
+        const char *up = m->grid + (r - 1) * cols, *row = up + cols, *down = row + cols;
+        unsigned char *out = m->mark + r * cols;
+        size_t j = 1;
+
+        out[0] = out[cols - 1] = 0;
+        for (; j + sizeof(bytes) < cols; j += sizeof(bytes)) {
+            bytes n, ne, e, se, s, sw, w, nw, self;
+            memcpy(&n, up + j, sizeof(n));
+            memcpy(&ne, up + j + 1, sizeof(ne));
+            memcpy(&nw, up + j - 1, sizeof(nw));
+            memcpy(&e, row + j + 1, sizeof(e));
+            memcpy(&w, row + j - 1, sizeof(w));
+            memcpy(&self, row + j, sizeof(self));
+            memcpy(&s, down + j, sizeof(s));
+            memcpy(&se, down + j + 1, sizeof(se));
+            memcpy(&sw, down + j - 1, sizeof(sw));
+            n = (bytes)(n != wall) & one;
+            e = (bytes)(e != wall) & one;
+            s = (bytes)(s != wall) & one;
+            w = (bytes)(w != wall) & one;
+            bytes links = (n & e & (bytes)(ne != wall)) + (s & e & (bytes)(se != wall))
+                          + (s & w & (bytes)(sw != wall)) + (n & w & (bytes)(nw != wall));
+            bytes can = (bytes)(links == four) | (bytes)(n + e + s + w <= links + one);
+            can &= (bytes)(self == free) & one;
+            memcpy(out + j, &can, sizeof(can));
+        }
+        for (; j + 1 < cols; j++) {
+            out[j] = row[j] == MAZE_OPEN && maze_can_block(m, (uint32_t)(r * cols + j));
+        }
+    }
+}
+
+// Function to wall in free cells picked at random among the ones that can be,
+// as maze_pick_free() picks them, in one pass along them. Walling a cell in
+// can keep one of the next from being walled in, so each is tested again when
+// its turn comes, and one that fails passes it on to the next; each cell
+// walled in is then one walled in a maze still in one piece, which keeps it so.
+uint32_t maze_block_free(struct maze *m, uint32_t want, uint64_t *random) {
+    uint32_t n = 0, picked = 0, owed = 0, walled = 0;
+
+    mark_blockable(m);
+    for (uint32_t i = 0; i < m->cells; i++) {
+        m->work[n] = i;
+        n += m->mark[i];
+    }
+    want = want < n ? want : n;
+    for (uint32_t i = 0; i < n && (picked < want || owed > 0); i++) {
+        uint32_t cell = m->work[i];
+        uint32_t take = below(random, n - i) < want - picked;
+        picked += take;
+        owed += take;
+        if (owed > 0 && maze_can_block(m, cell)) {
+            m->grid[cell] = MAZE_WALL;
+            m->work[walled++] = cell;
+            owed--;
+        }
+    }
+    m->free_count = 0;
+    return walled;
+}
+
+// Function to find the fewest steps between two cells, searching the whole
+// maze so that reached counts every cell joined to the first
+long maze_distance(struct maze *m, uint32_t from, uint32_t to) {
+    long steps = -1;
+
+    m->reached = 0;
+    if (m->grid[from] == MAZE_WALL) {
+        return -1;
+    }
+    mark_equal(m->grid, m->mark, m->cells, MAZE_WALL);
+    m->reached = flood(m, from, to, &steps);
+    return steps;
+}
+
+// Function to draw a number below n for a caller placing things in the maze
+uint32_t maze_below(uint64_t *random, uint32_t n) {
+    return below(random, n);
+}
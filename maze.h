@@ -0,0 +1,87 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+// Environment variable naming the generator of the princess's mazes, e.g.
+// VGC_MAZE=caves; when unset, every game's seed picks one
+#define MAZE_ENV "VGC_MAZE"
+
+#define MAZE_WALL '#'
+#define MAZE_OPEN '.'
+#define MAZE_MIN_SIDE 3
+#define MAZE_MAX_SIDE 4096          // Largest side, so cell numbers fit 32 bits with room to spare
+#define MAZE_NO_CELL UINT32_MAX
+
+// A maze of rows x cols cells, numbered row * cols + col, each MAZE_WALL or
+// MAZE_OPEN as generated; a game may write its own marks over open cells,
+// anything but MAZE_WALL counts as open. Every generator walls the border, so
+// a cell's neighbours are never looked for outside the maze.
+//
+// The scratch arrays are shared by whatever runs at the moment: the stack or
+// frontier of a generator, the queue of a search, the list of open cells
+// entities are placed from. Nothing is allocated after maze_setup().
+struct maze {
+    int rows, cols;
+    uint32_t cells;
+    char *grid;
+    unsigned char *mark;     // A byte per cell: visited, in the frontier...
+    uint32_t *work;          // A cell number per cell
+    uint32_t free_count;     // Open cells listed in work by maze_collect_free()
+    uint32_t reached;        // Cells the last maze_distance() reached
+};
+
+// A way of carving a maze, picked by name. carve() starts from a grid of walls
+// and leaves every open cell reachable from every other.
+struct maze_generator {
+    const char *name;
+    const char *about;
+    void (*carve)(struct maze *m, uint64_t *random);
+};
+
+#define MAZE_GENERATORS 3
+extern const struct maze_generator maze_generators[MAZE_GENERATORS];
+
+// Find a generator by name, NULL if there is none
+const struct maze_generator *maze_find(const char *name);
+
+// Work out the arena bytes a rows x cols maze needs
+size_t maze_arena_size(int rows, int cols);
+
+// Carve a maze of rows x cols cells, from MAZE_MIN_SIDE to MAZE_MAX_SIDE a
+// side, from an arena; returns 0 on success
+int maze_setup(struct maze *m, struct arena *arena, int rows, int cols);
+
+// Generate a maze; the same generator and seed always give the same maze.
+// Caves too small to hold two cells are carved as a backtracker maze instead.
+// Returns the open cells.
+uint32_t maze_generate(struct maze *m, const struct maze_generator *generator, uint64_t seed);
+
+// Put every cell still MAZE_OPEN in a list, in order, for maze_pick_free()
+void maze_collect_free(struct maze *m);
+
+// Keep want cells of the list, or all of them if there are fewer, picked at
+// random in one pass along it; they are left at the start of work in the
+// order of the list, free_count of them. Returns how many there are.
+uint32_t maze_pick_free(struct maze *m, uint32_t want, uint64_t *random);
+
+// Tell whether walling a cell in keeps its open neighbours connected to each
+// other around it, and so every open cell connected to every other
+int maze_can_block(const struct maze *m, uint32_t cell);
+
+// Wall in up to want cells still MAZE_OPEN, picked at random among the ones
+// maze_can_block() allows, in one pass along the maze; the cells walled in
+// are left at the start of work. Returns how many there are.
+uint32_t maze_block_free(struct maze *m, uint32_t want, uint64_t *random);
+
+// Find the fewest steps between two cells with a breadth-first search, which
+// visits each cell once; returns -1 if there is no way through
+long maze_distance(struct maze *m, uint32_t from, uint32_t to);
+
+// Draw a number below n from a seeded generator, as the generators do
+uint32_t maze_below(uint64_t *random, uint32_t n);
+
+#endif
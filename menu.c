@@ -0,0 +1,459 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game_plugin.h"
+#include "game_runtime.h"
+#include "menu.h"
+#include "render.h"
+
+#define KEY_CTRL_N 0x0e
+#define KEY_CTRL_P 0x10
+#define KEY_ESCAPE 0x1b
+#define KEY_BACKSPACE 0x7f
+
+// Function to get the number of games matching the current query
+static int result_count(const struct menu *m) {
+    return m->query_len == 0 ? m->games->count : m->levels[m->query_len].count;
+}
+
+// Function to get the catalog index of the i-th match
+static int result_at(const struct menu *m, int i) {
+    return m->query_len == 0 ? i : m->levels[m->query_len].idx[i];
+}
+
+// Function to build the lowercase titles and the per-byte posting lists, and
+// reserve every result set a query can need, all in one block
+static int build_index(struct menu *m) {
+    const struct catalog *c = m->games;
+    size_t text_len = 0;
+
+    // How many games contain each byte, to size the posting lists
+    int counts[256] = {0};
+    int seen[256];
+    memset(seen, -1, sizeof(seen));
+    for (int i = 0; i < c->count; i++) {
+        for (const char *t = c->entries[i].title; *t; t++) {
+            unsigned char ch = tolower((unsigned char)*t);
+            if (seen[ch] != i) {
+                seen[ch] = i;
+                counts[ch]++;
+            }
+        }
+        text_len += strlen(c->entries[i].title) + 1;
+    }
+    m->post_off[0] = 0;
+    for (int b = 0; b < 256; b++) {
+        m->post_off[b + 1] = m->post_off[b] + counts[b];
+    }
+    int total = m->post_off[256];
+
+    // Level k never holds more games than the catalog, so typing never has to allocate
+    size_t level = arena_round(c->count * sizeof(int));
+    size_t size = arena_round(text_len) + arena_round((c->count + 1) * sizeof(int))
+                  + 2 * arena_round(total * sizeof(int)) + 2 * MENU_QUERY_MAX * level;
+    free(m->memory);
+    m->memory = malloc(size ? size : 1);
+    if (m->memory == NULL) {
+        arena_init(&m->arena, NULL, 0);
+        return -1;
+    }
+    arena_init(&m->arena, m->memory, size);
+    m->text = arena_alloc(&m->arena, text_len);
+    m->text_off = arena_array(&m->arena, c->count + 1, sizeof(int));
+    m->post_idx = arena_array(&m->arena, total, sizeof(int));
+    m->post_pos = arena_array(&m->arena, total, sizeof(int));
+    for (int k = 1; k <= MENU_QUERY_MAX; k++) {
+        m->levels[k].idx = arena_array(&m->arena, c->count, sizeof(int));
+        m->levels[k].pos = arena_array(&m->arena, c->count, sizeof(int));
+        m->levels[k].count = 0;
+    }
+
+    // Lowercase copy of every title
+    size_t off = 0;
+    for (int i = 0; i < c->count; i++) {
+        m->text_off[i] = off;
+        for (const char *t = c->entries[i].title; *t; t++) {
+            m->text[off++] = tolower((unsigned char)*t);
+        }
+        m->text[off++] = '\0';
+    }
+
+    // Fill the lists in catalog order with the position just after the first occurrence
+    int fill[256];
+    memcpy(fill, m->post_off, sizeof(fill));
+    memset(seen, -1, sizeof(seen));
+    for (int i = 0; i < c->count; i++) {
+        const char *t = m->text + m->text_off[i];
+        for (int p = 0; t[p]; p++) {
+            unsigned char ch = t[p];
+            if (seen[ch] != i) {
+                seen[ch] = i;
+                m->post_idx[fill[ch]] = i;
+                m->post_pos[fill[ch]++] = p + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Function to compute level k from level k-1 and the k-th query character
+static void refine(struct menu *m, int k) {
+    unsigned char ch = tolower((unsigned char)m->query[k - 1]);
+    struct menu_level *out = &m->levels[k];
+
+    if (k == 1) {
+        // The first character comes straight from the index
+        int n = m->post_off[ch + 1] - m->post_off[ch];
+        memcpy(out->idx, m->post_idx + m->post_off[ch], n * sizeof(int));
+        memcpy(out->pos, m->post_pos + m->post_off[ch], n * sizeof(int));
+        out->count = n;
+        return;
+    }
+
+    // Later characters only extend the previous matches; a subsequence match of
+    // query+ch must continue from where the match of query ended
+    const struct menu_level *in = &m->levels[k - 1];
+    int n = 0;
+    for (int i = 0; i < in->count; i++) {
+        const char *t = m->text + m->text_off[in->idx[i]];
+        const char *hit = strchr(t + in->pos[i], ch);
+        if (hit != NULL) {
+            out->idx[n] = in->idx[i];
+            out->pos[n++] = hit - t + 1;
+        }
+    }
+    out->count = n;
+}
+
+// Function to move the selection to a game, or the first match if it is gone
+static void select_entry(struct menu *m, int entry) {
+    int lo = 0, hi = result_count(m);
+
+    // Matches are in catalog order so a binary search finds the game
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (result_at(m, mid) < entry) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    m->selected = lo < result_count(m) && result_at(m, lo) == entry ? lo : 0;
+}
+
+// Function to set up the menu
+int menu_init(struct menu *m, const struct catalog *games, int rows) {
+    memset(m, 0, sizeof(*m));
+    m->games = games;
+    m->rows = rows > 0 ? rows : 1;
+    return build_index(m);
+}
+
+// Function to rebuild the index and replay the query after the catalog changed
+void menu_reindex(struct menu *m, const char *selected_name) {
+    build_index(m);
+    for (int k = 1; k <= m->query_len; k++) {
+        refine(m, k);
+    }
+
+    int entry = catalog_find(m->games, selected_name);
+    if (entry >= 0) {
+        select_entry(m, entry);
+    } else if (m->selected >= result_count(m)) {
+        m->selected = result_count(m) > 0 ? result_count(m) - 1 : 0;
+    }
+}
+
+// Function to move the selection by delta rows, staying inside the results
+static void move_selection(struct menu *m, int delta) {
+    int count = result_count(m);
+    m->selected += delta;
+    if (m->selected >= count) {
+        m->selected = count - 1;
+    }
+    if (m->selected < 0) {
+        m->selected = 0;
+    }
+}
+
+// Function to apply one key
+int menu_handle_key(struct menu *m, int key) {
+    int entry = menu_selected(m);
+
+    if (key == '\n' || key == '\r') {
+        return entry >= 0 ? MENU_LAUNCH : MENU_NONE;
+    }
+
+    // Cursor keys move the selection, during a search as well
+    switch (key) {
+    case KEY_CTRL_N:
+    case GAME_KEY_DOWN:
+        move_selection(m, 1);
+        return MENU_NONE;
+    case KEY_CTRL_P:
+    case GAME_KEY_UP:
+        move_selection(m, -1);
+        return MENU_NONE;
+    case GAME_KEY_PAGE_DOWN:
+        move_selection(m, m->rows);
+        return MENU_NONE;
+    case GAME_KEY_PAGE_UP:
+        move_selection(m, -m->rows);
+        return MENU_NONE;
+    case GAME_KEY_HOME:
+        m->selected = 0;
+        return MENU_NONE;
+    case GAME_KEY_END:
+        move_selection(m, result_count(m));
+        return MENU_NONE;
+    }
+
+    if (m->searching) {
+        if (key == KEY_ESCAPE) {
+            // Leave search and show the whole list again
+            m->searching = 0;
+            m->query_len = 0;
+        } else if (key == KEY_BACKSPACE || key == '\b') {
+            if (m->query_len > 0) {
+                m->query_len--;  // The shorter query's matches are still cached
+            }
+        } else if (key >= ' ' && key <= '~' && m->query_len < MENU_QUERY_MAX) {
+            m->query[m->query_len++] = key;
+            refine(m, m->query_len);
+        } else {
+            return MENU_NONE;
+        }
+        if (entry >= 0) {
+            select_entry(m, entry);
+        } else {
+            m->selected = 0;
+        }
+        return MENU_NONE;
+    }
+
+    switch (key) {
+    case 'w':
+        move_selection(m, -1);  // Move up
+        break;
+    case 's':
+        move_selection(m, 1);  // Move down
+        break;
+    case 'W':
+        move_selection(m, -m->rows);  // Page up
+        break;
+    case 'S':
+        move_selection(m, m->rows);  // Page down
+        break;
+    case 'g':
+        m->selected = 0;
+        break;
+    case 'G':
+        move_selection(m, result_count(m));
+        break;
+    case '/':
+        m->searching = 1;
+        break;
+    case 'q':
+        return MENU_QUIT;
+    }
+    return MENU_NONE;
+}
+
+// Function to get the catalog index of the selected game
+int menu_selected(const struct menu *m) {
+    return m->selected < result_count(m) ? result_at(m, m->selected) : -1;
+}
+
+// Function to draw the status line and the visible window of the results
+void menu_render(struct menu *m, struct game_canvas *c) {
+    int count = result_count(m);
+
+    // Scroll just enough to keep the selection visible
+    if (m->selected < m->top) {
+        m->top = m->selected;
+    } else if (m->selected >= m->top + m->rows) {
+        m->top = m->selected - m->rows + 1;
+    }
+    if (m->top > count - m->rows) {
+        m->top = count - m->rows > 0 ? count - m->rows : 0;
+    }
+
+    c->row = MENU_TOP - 2;
+    c->col = 0;
+    if (m->searching) {
+        canvas_printf(c, "Search: %.*s_  (%d of %d)", m->query_len, m->query, count, m->games->count);
+    } else if (count > m->rows) {
+        canvas_printf(c, "(%d-%d of %d, '/' to search)", m->top + 1,
+                      m->top + m->rows < count ? m->top + m->rows : count, count);
+    }
+
+    // Only the visible window is drawn; the renderer sends the rows that changed
+    for (int r = 0; r < m->rows && m->top + r < count; r++) {
+        int i = m->top + r;
+        c->row = MENU_TOP - 1 + r;
+        c->col = 0;
+        canvas_printf(c, "%s %s", i == m->selected ? "->" : "  ", m->games->entries[result_at(m, i)].title);
+    }
+    c->row = MENU_TOP - 1 + m->selected - m->top;
+    c->col = 0;
+}
+
+// Function to release the menu
+void menu_free(struct menu *m) {
+    free(m->memory);
+    memset(m, 0, sizeof(*m));
+}
+
+// Function to read the monotonic clock in nanoseconds
+static long long bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to check a title against a query by brute force
+static int naive_match(const char *title, const char *query, int len) {
+    for (int q = 0; q < len && *title; title++) {
+        if (tolower((unsigned char)*title) == tolower((unsigned char)query[q])) {
+            q++;
+            if (q == len) {
+                return 1;
+            }
+        }
+    }
+    return len == 0;
+}
+
+// Function to compare two timings for qsort
+static int compare_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Function to benchmark keystroke-to-redraw time over n synthetic games
+int menu_bench(int n) {
+    static const char *words[] = {
+        "snake", "sudoku", "princess", "maze", "arena", "super", "mega", "turbo", "dungeon", "racer",
+        "puzzle", "tetra", "galaxy", "ninja", "pixel", "quest", "robot", "zombie", "castle", "dragon",
+    };
+    const int word_count = sizeof(words) / sizeof(words[0]);
+    struct catalog c = {0};
+    struct menu m;
+    char (*titles)[48] = malloc(n * sizeof(*titles));
+    char (*names)[32] = malloc(n * sizeof(*names));
+    unsigned int seed = 12345;
+
+    c.entries = calloc(n, sizeof(*c.entries));
+    if (titles == NULL || names == NULL || c.entries == NULL) {
+        return 1;
+    }
+
+    // Titles are three random words and a number, names keep catalog order sorted
+    for (int i = 0; i < n; i++) {
+        const char *w[3];
+        for (int k = 0; k < 3; k++) {
+            seed = seed * 1103515245 + 12345;
+            w[k] = words[(seed >> 16) % word_count];
+        }
+        snprintf(titles[i], sizeof(titles[i]), "%s %s %s %d", w[0], w[1], w[2], i);
+        snprintf(names[i], sizeof(names[i]), "game_%08d", i);
+        c.entries[i].name = names[i];
+        c.entries[i].title = titles[i];
+        c.entries[i].description = "";
+    }
+    c.count = c.capacity = n;
+
+    // Redraws go through a renderer writing to /dev/null, like the launcher's screen
+    struct render screen;
+    int null_fd = open("/dev/null", O_WRONLY);
+    long long build_start = bench_now();
+    if (null_fd < 0 || menu_init(&m, &c, 40) != 0 || render_init(&screen, null_fd, MENU_TOP - 1 + 40, 80) != 0) {
+        return 1;
+    }
+    long long build_ns = bench_now() - build_start;
+    menu_render(&m, render_begin(&screen));
+    render_flush(&screen);
+    long long first_bytes = screen.bytes, first_writes = screen.writes;
+
+    // Type queries character by character, scroll, then erase them again
+    static const char *queries[] = { "snake", "sdk", "prncss", "mega dragon", "tq", "zzz", "arena 99" };
+    const int query_count = sizeof(queries) / sizeof(queries[0]);
+    long long samples[4096];
+    int sample_count = 0, failures = 0;
+    long long allocs = game_alloc_count();
+
+    for (int q = 0; q < query_count; q++) {
+        const char *query = queries[q];
+        int len = strlen(query);
+        int keys[256], key_count = 0;
+
+        keys[key_count++] = '/';
+        for (int k = 0; k < len; k++) {
+            keys[key_count++] = query[k];
+        }
+        for (int k = 0; k < 10; k++) {
+            keys[key_count++] = KEY_CTRL_N;
+        }
+        for (int k = 0; k < len; k++) {
+            keys[key_count++] = KEY_BACKSPACE;
+        }
+        keys[key_count++] = KEY_ESCAPE;
+
+        for (int k = 0; k < key_count; k++) {
+            long long start = bench_now();
+            menu_handle_key(&m, keys[k]);
+            menu_render(&m, render_begin(&screen));
+            render_flush(&screen);
+            if (sample_count < (int)(sizeof(samples) / sizeof(samples[0]))) {
+                samples[sample_count++] = bench_now() - start;
+            }
+
+            // Every incremental result set must equal a scan from scratch
+            int expected = 0;
+            for (int i = 0; i < n; i++) {
+                expected += naive_match(titles[i], m.query, m.query_len);
+            }
+            if (expected != result_count(&m)) {
+                failures++;
+            }
+        }
+    }
+
+    if (allocs >= 0) {
+        allocs = game_alloc_count() - allocs;
+    }
+
+    qsort(samples, sample_count, sizeof(samples[0]), compare_ll);
+    long long total = 0;
+    for (int i = 0; i < sample_count; i++) {
+        total += samples[i];
+    }
+    printf("menu bench: %d games, index built in %.1f us\n", n, build_ns / 1000.0);
+    printf("keystroke-to-redraw over %d keys: mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us\n",
+           sample_count, total / 1000.0 / sample_count, samples[sample_count / 2] / 1000.0,
+           samples[sample_count * 99 / 100] / 1000.0, samples[sample_count - 1] / 1000.0);
+    printf("output per redraw: %.1f bytes in %.2f writes (full screen: %lld bytes)\n",
+           (double)(screen.bytes - first_bytes) / sample_count,
+           (double)(screen.writes - first_writes) / sample_count, first_bytes);
+    printf("result sets checked against a full scan: %s\n", failures == 0 ? "ok" : "MISMATCH");
+    printf("index and result sets: %zu bytes reserved", m.arena.size);
+    if (allocs >= 0) {
+        printf(", %lld allocations while typing: %s", allocs, allocs == 0 ? "ok" : "FAILED");
+        failures += allocs != 0;
+    }
+    printf("\n");
+
+    render_free(&screen);
+    close(null_fd);
+    menu_free(&m);
+    free(c.entries);
+    free(titles);
+    free(names);
+    return failures == 0 && samples[sample_count - 1] < 1000000 ? 0 : 1;
+}
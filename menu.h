@@ -0,0 +1,75 @@
+#ifndef MENU_H
+#define MENU_H
+
+#include "arena.h"
+#include "catalog.h"
+#include "game_canvas.h"
+
+#define MENU_TOP 4          // Screen line of the first game row counting from 1, below the header and status line
+#define MENU_QUERY_MAX 63   // Longest search query
+
+// Actions returned by menu_handle_key()
+enum menu_action {
+    MENU_NONE,
+    MENU_LAUNCH,   // Start the selected game
+    MENU_QUIT,     // Leave the launcher
+};
+
+// Games matching the query typed so far, in catalog order.
+// pos[i] is where the greedy match of the query ended in the title of idx[i];
+// both have room for every game of the catalog.
+struct menu_level {
+    int *idx;
+    int *pos;
+    int count;
+};
+
+// Searchable, scrollable view over the catalog. The index and the result sets
+// are carved from one block reserved whenever the catalog changes, so keys and
+// redraws never allocate.
+struct menu {
+    const struct catalog *games;
+    void *memory;
+    struct arena arena;
+
+    // Index: lowercase titles plus, for each byte value, the games containing it
+    char *text;
+    int *text_off;
+    int post_off[257];
+    int *post_idx;
+    int *post_pos;
+
+    // levels[k] holds the matches of the first k query characters (level 0 is every game)
+    char query[MENU_QUERY_MAX + 1];
+    int query_len;
+    int searching;
+    struct menu_level levels[MENU_QUERY_MAX + 1];
+
+    // Only rows top..top+rows-1 of the results are on screen
+    int selected, top, rows;
+};
+
+// Set up a menu over games showing at most rows rows
+int menu_init(struct menu *m, const struct catalog *games, int rows);
+
+// Rebuild the index after the catalog changed, keeping the query and, if it is
+// still there, the game named selected_name under the cursor
+void menu_reindex(struct menu *m, const char *selected_name);
+
+// Apply one key, returns a menu_action
+int menu_handle_key(struct menu *m, int key);
+
+// Catalog index of the selected game, -1 if nothing matches
+int menu_selected(const struct menu *m);
+
+// Draw the status line and visible rows onto a screen canvas, leaving the
+// cursor on the selected row
+void menu_render(struct menu *m, struct game_canvas *c);
+
+// Release the index and result sets
+void menu_free(struct menu *m);
+
+// Time keystroke-to-redraw over a synthetic catalog of n games, returns 0 if all checks pass
+int menu_bench(int n);
+
+#endif
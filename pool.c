@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "pool.h"
+
+// Function to take the next task of a thread's own range, -1 if it is empty
+static int take_own(struct pool_queue *q) {
+    int task = -1;
+
+    pthread_mutex_lock(&q->lock);
+    if (q->next < q->end) {
+        task = q->next++;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return task;
+}
+
+// Function to move the back half of another thread's range to thread self,
+// trying the others in turn from the next one; returns 0 if all were empty
+static int steal(struct pool *p, int self) {
+    for (int i = 1; i < p->threads; i++) {
+        struct pool_queue *victim = &p->queues[(self + i) % p->threads];
+        int from = 0, to = 0;
+
+        pthread_mutex_lock(&victim->lock);
+        if (victim->next < victim->end) {
+            from = victim->next + (victim->end - victim->next) / 2;
+            to = victim->end;
+            victim->end = from;
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (from < to) {
+            struct pool_queue *q = &p->queues[self];
+            pthread_mutex_lock(&q->lock);
+            q->next = from;
+            q->end = to;
+            q->steals++;
+            pthread_mutex_unlock(&q->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Function to run the tasks of the current job as thread self until none are left anywhere
+static void work(struct pool *p, int self) {
+    do {
+        int task;
+        while ((task = take_own(&p->queues[self])) >= 0) {
+            p->task(p->ctx, task);
+        }
+    } while (steal(p, self));
+}
+
+// Function run by the pool's threads: wait for a job, help with it, report back
+static void *worker(void *arg) {
+    struct pool *p = arg;
+    int self = 0;
+    unsigned long seen = 0;   // Jobs may start before the thread first gets the lock
+
+    pthread_mutex_lock(&p->lock);
+    while (p->workers[self] != pthread_self()) {
+        self++;   // pool_init() stored the thread id before unlocking
+    }
+    while (1) {
+        while (p->generation == seen && !p->stop) {
+            pthread_cond_wait(&p->start, &p->lock);
+        }
+        if (p->stop) {
+            break;
+        }
+        seen = p->generation;
+        pthread_mutex_unlock(&p->lock);
+
+        work(p, self);
+
+        pthread_mutex_lock(&p->lock);
+        if (--p->running == 0) {
+            pthread_cond_signal(&p->done);
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+// Function to start the pool's threads
+int pool_init(struct pool *p, int threads) {
+    sigset_t all, old;
+
+    p->threads = threads < 1 ? 1 : threads > POOL_MAX_THREADS ? POOL_MAX_THREADS : threads;
+    p->generation = 0;
+    p->running = 0;
+    p->stop = 0;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->start, NULL);
+    pthread_cond_init(&p->done, NULL);
+    for (int i = 0; i < p->threads; i++) {
+        pthread_mutex_init(&p->queues[i].lock, NULL);
+        p->queues[i].next = p->queues[i].end = 0;
+        p->queues[i].steals = 0;
+    }
+    p->workers[0] = pthread_self();
+
+    // Signals stay with the calling thread, whose waits they have to interrupt
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    pthread_mutex_lock(&p->lock);
+    for (int i = 1; i < p->threads; i++) {
+        int err = pthread_create(&p->workers[i], NULL, worker, p);
+        if (err != 0) {
+            pthread_mutex_unlock(&p->lock);
+            pthread_sigmask(SIG_SETMASK, &old, NULL);
+            errno = err;
+            perror("pthread_create");
+            p->threads = i;
+            pool_free(p);
+            return -1;
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    return 0;
+}
+
+// Function to run a job across the pool
+void pool_run(struct pool *p, int count, void (*task)(void *ctx, int index), void *ctx) {
+    pthread_mutex_lock(&p->lock);
+    p->task = task;
+    p->ctx = ctx;
+    for (int i = 0; i < p->threads; i++) {
+        pthread_mutex_lock(&p->queues[i].lock);
+        p->queues[i].next = (int)((long long)count * i / p->threads);
+        p->queues[i].end = (int)((long long)count * (i + 1) / p->threads);
+        pthread_mutex_unlock(&p->queues[i].lock);
+    }
+    p->running = p->threads - 1;
+    p->generation++;
+    pthread_cond_broadcast(&p->start);
+    pthread_mutex_unlock(&p->lock);
+
+    work(p, 0);
+
+    pthread_mutex_lock(&p->lock);
+    while (p->running > 0) {
+        pthread_cond_wait(&p->done, &p->lock);
+    }
+    pthread_mutex_unlock(&p->lock);
+}
+
+// Function to count the steals of every thread
+long long pool_steals(struct pool *p) {
+    long long steals = 0;
+
+    for (int i = 0; i < p->threads; i++) {
+        pthread_mutex_lock(&p->queues[i].lock);
+        steals += p->queues[i].steals;
+        pthread_mutex_unlock(&p->queues[i].lock);
+    }
+    return steals;
+}
+
+// Function to stop the threads and release the pool
+void pool_free(struct pool *p) {
+    pthread_mutex_lock(&p->lock);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->start);
+    pthread_mutex_unlock(&p->lock);
+    for (int i = 1; i < p->threads; i++) {
+        pthread_join(p->workers[i], NULL);
+    }
+    for (int i = 0; i < p->threads; i++) {
+        pthread_mutex_destroy(&p->queues[i].lock);
+    }
+    pthread_cond_destroy(&p->done);
+    pthread_cond_destroy(&p->start);
+    pthread_mutex_destroy(&p->lock);
+}
+
+// Function to count the processors online
+int pool_cores(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : (int)n;
+}
@@ -0,0 +1,49 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <pthread.h>
+
+#define POOL_MAX_THREADS 64
+
+// Tasks of one job still to be run by a thread: [next, end). The thread takes
+// them from the front; a thread that ran out steals the back half.
+struct pool_queue {
+    pthread_mutex_t lock;
+    int next, end;
+    long long steals;   // Times this thread stole from another
+} __attribute__((aligned(64)));   // One cache line each, so that threads do not share them
+
+// Work-stealing thread pool. pool_run() splits the tasks 0..count-1 of a job
+// into one contiguous range per thread, the caller being one of them, and
+// returns once all have run. Threads that finish early steal half of what a
+// busy one has left, so uneven tasks still keep every thread working. Which
+// thread runs a task is left to chance: tasks must not depend on it.
+struct pool {
+    int threads;                          // Including the caller of pool_run()
+    pthread_t workers[POOL_MAX_THREADS];  // workers[1..threads-1]
+    struct pool_queue queues[POOL_MAX_THREADS];
+    pthread_mutex_t lock;
+    pthread_cond_t start, done;
+    unsigned long generation;             // Bumped for every job
+    int running;                          // Workers still busy with the job
+    int stop;
+    void (*task)(void *ctx, int index);
+    void *ctx;
+};
+
+// Start a pool of threads threads, including the caller; returns 0 on success
+int pool_init(struct pool *p, int threads);
+
+// Run task(ctx, i) for every i in [0, count) across the pool and wait for all of them
+void pool_run(struct pool *p, int count, void (*task)(void *ctx, int index), void *ctx);
+
+// Times threads stole work since the pool started
+long long pool_steals(struct pool *p);
+
+// Stop and join the threads
+void pool_free(struct pool *p);
+
+// Number of processors online, at least 1
+int pool_cores(void);
+
+#endif
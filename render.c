@@ -0,0 +1,601 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <termios.h>
+
+#include "render.h"
+
+// SGR parameters of each game_style
+static const char *const style_params[GAME_STYLE_COUNT] = {
+    "", "1;34", "1;31", "1;32", "7",
+};
+
+// Escapes of one frame being encoded, with what the terminal looks like so far
+struct encoder {
+    char *out;
+    size_t len, cap;
+    int row, col;   // Terminal cursor, row -1 when unknown
+    int style;      // Terminal attributes
+};
+
+// Function to get the style a cell is drawn with
+static int cell_style(const struct game_cell *cell) {
+    return cell->style < GAME_STYLE_COUNT ? cell->style : GAME_STYLE_PLAIN;
+}
+
+// Function to get the character a cell is drawn with
+static char cell_char(const struct game_cell *cell) {
+    return cell->ch >= ' ' && cell->ch < 127 ? cell->ch : '?';
+}
+
+// Function to check whether a cell shows nothing
+static int cell_blank(const struct game_cell *cell) {
+    return cell->ch == ' ' && cell_style(cell) == GAME_STYLE_PLAIN;
+}
+
+// Function to append bytes to the frame
+static void emit(struct encoder *e, const char *s, size_t len) {
+    if (e->len + len > e->cap) {
+        return;  // Cannot happen with a RENDER_OUT_MAX buffer
+    }
+    memcpy(e->out + e->len, s, len);
+    e->len += len;
+}
+
+// Function to change the terminal attributes to style
+static void emit_style(struct encoder *e, int style) {
+    char buf[16];
+
+    if (style == e->style) {
+        return;
+    }
+    if (style == GAME_STYLE_PLAIN) {
+        emit(e, "\033[m", 3);
+    } else {
+        emit(e, buf, snprintf(buf, sizeof(buf), "\033[%s%sm", e->style == GAME_STYLE_PLAIN ? "" : "0;",
+                              style_params[style]));
+    }
+    e->style = style;
+}
+
+// Function to write the absolute cursor position for row, col (both 0-based) into buf
+static int format_position(char *buf, size_t cap, int row, int col) {
+    if (col == 0) {
+        return row == 0 ? snprintf(buf, cap, "\033[H") : snprintf(buf, cap, "\033[%dH", row + 1);
+    }
+    return snprintf(buf, cap, "\033[%d;%dH", row + 1, col + 1);
+}
+
+// Function to move the cursor to row, col with the shortest sequence available.
+// line holds the cells of the cursor's row as they are on the terminal.
+static void emit_move(struct encoder *e, int row, int col, const struct game_cell *line) {
+    char best[32], alt[32];
+    int best_len, alt_len = -1;
+
+    if (e->row == row && e->col == col) {
+        return;
+    }
+    best_len = format_position(best, sizeof(best), row, col);
+
+    if (e->row == row && col > e->col) {
+        int gap = col - e->col;
+
+        // Rewriting the few cells in between is shortest if they share the current style
+        if (gap < best_len && gap <= 4) {
+            int same = 1;
+            for (int j = e->col; j < col; j++) {
+                same &= cell_style(&line[j]) == e->style;
+            }
+            if (same) {
+                for (int j = e->col; j < col; j++) {
+                    char ch = cell_char(&line[j]);
+                    emit(e, &ch, 1);
+                }
+                e->col = col;
+                return;
+            }
+        }
+        alt_len = gap == 1 ? snprintf(alt, sizeof(alt), "\033[C") : snprintf(alt, sizeof(alt), "\033[%dC", gap);
+    } else if (e->row == row) {
+        alt_len = col == 0 ? snprintf(alt, sizeof(alt), "\r") : snprintf(alt, sizeof(alt), "\033[%dD", e->col - col);
+    } else if (e->row >= 0 && row > e->row && col == 0 && row - e->row < 8) {
+        // Next lines: carriage return and line feeds, never past the bottom since row is on screen
+        alt_len = 0;
+        if (e->col != 0) {
+            alt[alt_len++] = '\r';
+        }
+        for (int i = e->row; i < row; i++) {
+            alt[alt_len++] = '\n';
+        }
+    }
+
+    if (alt_len >= 0 && alt_len < best_len) {
+        emit(e, alt, alt_len);
+    } else {
+        emit(e, best, best_len);
+    }
+    e->row = row;
+    e->col = col;
+}
+
+// Function to draw one cell at the cursor
+static void emit_cell(struct encoder *e, const struct game_cell *cell, int cols) {
+    char ch = cell_char(cell);
+
+    emit_style(e, cell_style(cell));
+    emit(e, &ch, 1);
+    if (++e->col >= cols) {
+        e->row = -1;  // Terminals differ on where the cursor is after the last column
+    }
+}
+
+// Function to encode the escapes turning front into back
+size_t render_diff(struct game_cell *front, const struct game_canvas *back, int clear,
+                   char *out, size_t cap) {
+    struct encoder e = { out, 0, cap, -1, -1, GAME_STYLE_PLAIN };
+    int rows = back->rows, cols = back->cols;
+
+    if (clear) {
+        emit(&e, "\033[m\033[H\033[J", 9);  // Clear screen with plain attributes
+        for (int i = 0; i < rows * cols; i++) {
+            front[i].ch = ' ';
+            front[i].style = GAME_STYLE_PLAIN;
+        }
+        e.row = e.col = 0;
+    }
+
+    for (int i = 0; i < rows; i++) {
+        const struct game_cell *want = &back->cells[i * cols];
+        struct game_cell *line = &front[i * cols];
+
+        if (memcmp(want, line, cols * sizeof(*line)) == 0) {
+            continue;  // Most lines of a frame are unchanged
+        }
+
+        // From column tail on the new line is blank; if enough of that part
+        // is still drawn, one erase-to-end-of-line clears it
+        int tail = cols;
+        while (tail > 0 && cell_blank(&want[tail - 1])) {
+            tail--;
+        }
+        int first_stale = -1, stale = 0;
+        for (int j = tail; j < cols; j++) {
+            if (!cell_blank(&line[j])) {
+                stale++;
+                if (first_stale < 0) {
+                    first_stale = j;
+                }
+            }
+        }
+        int erase = stale > 3;
+
+        for (int j = 0; j < (erase ? tail : cols); j++) {
+            if (want[j].ch == line[j].ch && want[j].style == line[j].style) {
+                continue;  // Already on screen
+            }
+            emit_move(&e, i, j, line);
+            emit_cell(&e, &want[j], cols);
+            line[j] = want[j];
+        }
+        if (erase) {
+            emit_move(&e, i, first_stale, line);
+            emit_style(&e, GAME_STYLE_PLAIN);
+            emit(&e, "\033[K", 3);
+            for (int j = first_stale; j < cols; j++) {
+                line[j].ch = ' ';
+                line[j].style = GAME_STYLE_PLAIN;
+            }
+        }
+    }
+    emit_style(&e, GAME_STYLE_PLAIN);
+
+    // Always place the cursor absolutely, so every frame also puts it back in sync
+    int row = back->row < rows ? back->row : rows - 1;
+    int col = back->col < cols ? back->col : cols - 1;
+    char buf[32];
+    emit(&e, buf, format_position(buf, sizeof(buf), row, col));
+    return e.len;
+}
+
+// Function to read the monotonic clock in nanoseconds
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to set up a renderer for a rows x cols screen
+int render_init(struct render *r, int fd, int rows, int cols) {
+    memset(r, 0, sizeof(*r));
+    r->fd = r->out_fd = fd;
+    r->rows = rows;
+    r->cols = cols;
+    r->front = calloc((size_t)rows * cols, sizeof(*r->front));
+    r->back = calloc((size_t)rows * cols, sizeof(*r->back));
+    r->out = malloc(RENDER_OUT_MAX(rows, cols));
+    if (r->front == NULL || r->back == NULL || r->out == NULL) {
+        render_free(r);
+        return -1;
+    }
+    r->canvas.cells = r->back;
+    r->canvas.rows = rows;
+    r->canvas.cols = cols;
+    r->clear = 1;
+    r->throttle = 1;
+    canvas_clear(&r->canvas);
+
+    // A descriptor of its own for the terminal, so writes that would wait can
+    // be non-blocking without changing the one shared with other processes
+    if (isatty(fd)) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+        int out = open(path, O_WRONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (out >= 0) {
+            r->out_fd = out;
+        }
+    }
+    return 0;
+}
+
+// Function to start drawing a new frame
+struct game_canvas *render_begin(struct render *r) {
+    if (r->pending) {
+        r->dropped++;  // The frame held back is never going to be seen
+    }
+    canvas_clear(&r->canvas);
+    return &r->canvas;
+}
+
+// Function to repaint everything with the next frame
+void render_invalidate(struct render *r) {
+    r->clear = 1;
+}
+
+// Function to bring the estimate of the bytes still in the link up to date
+static void drain(struct render *r, long long now) {
+    if (r->rate == 0) {
+        // The link is assumed to have carried a burst once output paused for a second
+        if (r->full_ns == 0 && now - r->write_ns > 1000000000LL) {
+            r->queued = 0;
+        }
+        return;
+    }
+    r->queued -= r->rate * (now - r->queued_ns) / 1000000000LL;
+    if (r->queued < 0) {
+        r->queued = 0;
+    }
+    r->queued_ns = now;
+
+    // A link that has kept up for a while may have become faster; if it has
+    // not, it fills up again and the next measurement says so
+    if (r->queued == 0 && now - r->calm_ns > 1000000000LL) {
+        r->rate += r->rate / 4;
+        r->calm_ns = now;
+        r->full_ns = 0;  // Measure afresh
+        if (r->rate > RENDER_RATE_FREE) {
+            r->rate = r->capacity = 0;
+        }
+    }
+}
+
+// Function to note that the link took no more output: it holds its capacity now
+static void link_full(struct render *r, long long now) {
+    r->calm_ns = now;
+    if (r->full_ns == 0) {
+        r->full_ns = now;
+        r->full_bytes = r->bytes;
+        if (r->rate == 0) {
+            r->burst_ns = now - r->queued_ns;
+            r->burst_bytes = r->queued;
+        }
+        return;
+    }
+    if (now - r->full_ns < RENDER_RATE_MS * 1000000LL) {
+        return;
+    }
+
+    // Full then and full now: whatever it took in between, it has carried.
+    // The kernel makes room in chunks, so the longer the span the better.
+    long long rate = (r->bytes - r->full_bytes) * 1000000000LL / (now - r->full_ns);
+    if (rate <= 0) {
+        return;
+    }
+    r->rate = rate;
+
+    // The burst that first filled the link, less what it carried meanwhile, is its capacity
+    r->capacity = r->burst_bytes - rate * r->burst_ns / 1000000000LL;
+    if (r->capacity < 1024) {
+        r->capacity = 1024;
+    }
+    r->queued = r->capacity;
+    r->queued_ns = now;
+}
+
+// Function to write as much of the pending output as the link takes, returns -1 on error
+static int send_out(struct render *r) {
+    while (r->out_pos < r->out_len) {
+        long long start = now_ns();
+        ssize_t n = write(r->out_fd, r->out + r->out_pos, r->out_len - r->out_pos);
+        long long now = now_ns();
+
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            link_full(r, now);
+            return 0;  // The rest goes out on a later flush
+        }
+        if (n < 0) {
+            r->clear = 1;  // Part of the frame is missing on the terminal
+            r->out_pos = r->out_len = 0;
+            return -1;
+        }
+
+        drain(r, now);
+        if (r->rate == 0 && r->queued == 0) {
+            r->queued_ns = start;  // A new burst of output
+        }
+        r->queued += n;
+        r->write_ns = now;
+        if (now - start > RENDER_SLOW_WRITE_MS * 1000000LL) {
+            link_full(r, now);  // A blocking descriptor waited for room
+        }
+        r->writes++;
+        r->bytes += n;
+        r->out_pos += n;
+    }
+    return 0;
+}
+
+// Function to tell whether the terminal is still busy with earlier output
+static int congested(struct render *r, long long now) {
+    int outq = 0;
+
+    if (!r->throttle) {
+        return 0;
+    }
+    drain(r, now);
+    if (ioctl(r->fd, TIOCOUTQ, &outq) == 0 && outq > RENDER_OUTQ_SLACK) {
+        return 1;  // A real tty says so itself; a pseudo-terminal always reads 0
+    }
+    return r->rate > 0 && r->queued > r->rate * RENDER_LAG_MS / 1000;
+}
+
+// Function to bring the terminal up to date with the back buffer in one write()
+int render_flush(struct render *r) {
+    long long now = now_ns();
+
+    // The rest of the last frame goes first, the terminal is mid-sequence until then
+    if (r->out_pos < r->out_len) {
+        if (send_out(r) != 0) {
+            return -1;
+        }
+        if (r->out_pos < r->out_len) {
+            r->pending = 1;
+            return 0;
+        }
+    }
+    if (congested(r, now)) {
+        r->pending = 1;  // Merged into the next frame, or sent once the link has drained
+        return 0;
+    }
+
+    r->out_len = render_diff(r->front, &r->canvas, r->clear, r->out, RENDER_OUT_MAX(r->rows, r->cols));
+    r->out_pos = 0;
+    r->clear = 0;
+    r->pending = 0;
+    r->frames++;
+    if (r->start_ns == 0) {
+        r->start_ns = now;
+    }
+    int status = send_out(r);
+    while (!r->throttle && status == 0 && r->out_pos < r->out_len) {
+        // Every frame in full, however long the terminal takes
+        struct pollfd pfd = { .fd = r->out_fd, .events = POLLOUT };
+        poll(&pfd, 1, -1);
+        status = send_out(r);
+    }
+    if (now_ns() - now > r->stall_ns) {
+        r->stall_ns = now_ns() - now;
+    }
+    return status;
+}
+
+// Function to tell when a held frame should be tried again
+int render_wait_ms(const struct render *r) {
+    long long excess = r->queued - r->rate * RENDER_LAG_MS / 1000;
+
+    if (!r->pending && r->out_pos == r->out_len) {
+        return -1;
+    }
+    if (r->out_pos == r->out_len && r->rate > 0 && excess > 0) {
+        return (int)(excess * 1000 / r->rate) + 1;
+    }
+    return 10;  // Waiting for room in the link, or for TIOCOUTQ to go down
+}
+
+// Function to finish what is held back, however long the terminal takes
+void render_sync(struct render *r) {
+    int ms;
+
+    while ((ms = render_wait_ms(r)) >= 0) {
+        struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+        nanosleep(&ts, NULL);
+        if (render_flush(r) != 0) {
+            break;
+        }
+    }
+}
+
+// Function to print how much the renderer sent and dropped
+void render_report(const struct render *r, FILE *f) {
+    long long elapsed = r->start_ns > 0 ? now_ns() - r->start_ns : 0;
+
+    fprintf(f, "%lld frames sent, %lld dropped, %lld bytes in %lld writes, %.0f bytes/s", r->frames, r->dropped,
+            r->bytes, r->writes, elapsed > 0 ? r->bytes * 1e9 / elapsed : 0.0);
+    if (r->rate > 0) {
+        fprintf(f, ", paced to %lld bytes/s", r->rate);
+    }
+    fprintf(f, ", longest flush %.1f ms\n", r->stall_ns / 1e6);
+}
+
+// Function to release the renderer
+void render_free(struct render *r) {
+    free(r->front);
+    free(r->back);
+    free(r->out);
+    r->front = r->back = NULL;
+    r->out = NULL;
+    if (r->out_fd != r->fd) {
+        close(r->out_fd);
+        r->out_fd = r->fd;
+    }
+}
+
+// Function to get the terminal size
+void render_term_size(int fd, int *rows, int *cols) {
+    struct winsize ws;
+
+    if (ioctl(fd, TIOCGWINSZ, &ws) < 0 || ws.ws_row == 0 || ws.ws_col == 0) {
+        ws.ws_row = 24;
+        ws.ws_col = 80;
+    }
+    *rows = ws.ws_row;
+    *cols = ws.ws_col;
+}
+
+#define BENCH_FPS 30
+#define BENCH_SECONDS 3
+#define BENCH_MARK "#0123456789#"   // Drawn on the last frame only
+
+// Function to read the master side of a pseudo-terminal at bytes_per_sec like a
+// slow link, and report on out when the mark of the last frame came through
+static void slow_reader(int master, int bytes_per_sec, int out) {
+    char buf[4096 + sizeof(BENCH_MARK)];
+    size_t keep = 0, chunk = bytes_per_sec / 100;
+    struct timespec tick = { 0, 10000000L };
+
+    if (chunk > 4096) {
+        chunk = 4096;
+    }
+    for (;;) {
+        nanosleep(&tick, NULL);
+        ssize_t n = read(master, buf + keep, chunk);
+        if (n <= 0) {
+            break;  // The writer closed its side
+        }
+        keep += n;
+        if (memmem(buf, keep, BENCH_MARK, sizeof(BENCH_MARK) - 1) != NULL) {
+            long long seen = now_ns();
+            if (write(out, &seen, sizeof(seen)) != sizeof(seen)) {
+                break;
+            }
+        }
+        // The mark may be split between two reads
+        size_t tail = keep < sizeof(BENCH_MARK) ? keep : sizeof(BENCH_MARK);
+        memmove(buf, buf + keep - tail, tail);
+        keep = tail;
+    }
+    _exit(0);
+}
+
+// Function to draw frames at BENCH_FPS on a link of bytes_per_sec, returns how long
+// after its time the last frame reached the far end, -1 on error
+static long long bench_link(int bytes_per_sec, int throttle, struct render *r, long long *loop_ns) {
+    struct termios tio;
+    int fds[2];
+    long long seen = -1;
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        perror("posix_openpt");
+        return -1;
+    }
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0 || pipe(fds) < 0) {
+        perror("open");
+        return -1;
+    }
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    pid_t reader = fork();
+    if (reader < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (reader == 0) {
+        close(slave);
+        close(fds[0]);
+        slow_reader(master, bytes_per_sec, fds[1]);
+    }
+    close(master);
+    close(fds[1]);
+
+    // Every cell changes on every frame, about as bad as a full repaint per move
+    render_init(r, slave, 24, 80);
+    r->throttle = throttle;
+    long long start = now_ns(), drawn = 0;
+    for (int f = 0; f < BENCH_FPS * BENCH_SECONDS; f++) {
+        struct game_canvas *c = render_begin(r);
+        for (int i = 0; i < c->rows * c->cols; i++) {
+            c->cells[i].ch = 'a' + (i / c->cols + i % c->cols + f) % 26;
+        }
+        if (f == BENCH_FPS * BENCH_SECONDS - 1) {
+            canvas_puts(c, BENCH_MARK);
+            drawn = start + (long long)f * 1000000000LL / BENCH_FPS;  // When a real-time game would show it
+        }
+        render_flush(r);
+
+        long long next = start + (long long)(f + 1) * 1000000000LL / BENCH_FPS, now = now_ns();
+        if (next > now) {
+            struct timespec ts = { (next - now) / 1000000000LL, (next - now) % 1000000000LL };
+            nanosleep(&ts, NULL);
+        }
+    }
+    *loop_ns = now_ns() - start;
+    render_sync(r);
+
+    if (read(fds[0], &seen, sizeof(seen)) != sizeof(seen)) {
+        seen = -1;
+    }
+    close(slave);
+    close(fds[0]);
+    kill(reader, SIGTERM);
+    waitpid(reader, NULL, 0);
+    return seen < 0 ? -1 : seen - drawn;
+}
+
+// Function to compare frame dropping against sending every frame on a slow link
+int render_bench(int bytes_per_sec) {
+    long long lag[2], loop[2];
+    struct render r[2];
+
+    printf("link of %d bytes/s, %d s of %d fps with every cell changing\n", bytes_per_sec, BENCH_SECONDS,
+           BENCH_FPS);
+    for (int throttle = 0; throttle < 2; throttle++) {
+        lag[throttle] = bench_link(bytes_per_sec, throttle, &r[throttle], &loop[throttle]);
+        if (lag[throttle] < 0) {
+            return 1;
+        }
+        printf("%-12s loop took %.1f s, last frame seen %.0f ms after its time\n%-12s ",
+               throttle ? "dropping" : "every frame", loop[throttle] / 1e9, lag[throttle] / 1e6, "");
+        render_report(&r[throttle], stdout);
+        render_free(&r[throttle]);
+    }
+
+    // Dropping frames keeps the loop on time and the screen close behind it
+    int ok = lag[1] < lag[0] && loop[1] < loop[0] && r[1].dropped > 0;
+    printf("%s\n", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "game_canvas.h"
+
+#define RENDER_LAG_MS 100         // Most output allowed to wait in the link for a slow terminal
+#define RENDER_OUTQ_SLACK 64      // Bytes the tty may still hold (TIOCOUTQ) when a frame is sent
+#define RENDER_SLOW_WRITE_MS 5    // A write() taking longer found the link full
+#define RENDER_RATE_MS 1000       // Shortest time over which the link speed is measured
+#define RENDER_RATE_FREE 4000000  // Link speed in bytes per second above which output is not paced
+
+// Longest output of render_diff() for a rows x cols screen: a cursor move and
+// a style change in front of every cell
+#define RENDER_OUT_MAX(rows, cols) ((size_t)(rows) * ((cols) * 24 + 8) + 64)
+
+// Encode the escapes that turn a terminal showing front into one showing back,
+// touching only the cells that differ, then place the cursor where back left
+// it. front has back->rows * back->cols cells and is updated to match back.
+// If clear is set the terminal contents are unknown: it is cleared first.
+// Returns the number of bytes written to out (at most RENDER_OUT_MAX).
+size_t render_diff(struct game_cell *front, const struct game_canvas *back, int clear,
+                   char *out, size_t cap);
+
+// Double-buffered renderer for one terminal. A frame is drawn into the back
+// buffer through the canvas from render_begin(); render_flush() compares it
+// with the front buffer, which holds what the terminal shows, and sends the
+// difference with a single write().
+//
+// On a slow link (serial line, congested SSH) the renderer never waits for the
+// terminal. It writes through a non-blocking descriptor of its own, and frames
+// are held back while the tty's output queue (TIOCOUTQ) is not empty, while the
+// rest of a frame cut short is still going out, or while the bytes estimated to
+// be queued would take longer than RENDER_LAG_MS to drain. A held frame is
+// replaced by the next one and counted as dropped. As the difference is taken
+// against what the terminal shows, the frame sent later still carries the
+// latest state in one go.
+struct render {
+    int fd;
+    int rows, cols;
+    struct game_cell *front;
+    struct game_cell *back;
+    struct game_canvas canvas;  // Canvas over back
+    int clear;                  // Terminal contents unknown, repaint everything next time
+    char *out;                  // Escapes of the frame, RENDER_OUT_MAX bytes
+    long long frames, bytes, writes;
+
+    // Backpressure
+    int out_fd;                 // Non-blocking descriptor of the terminal, or fd if it has none
+    size_t out_pos, out_len;    // out[out_pos..out_len) is the rest of a frame not written yet
+    int throttle;               // Hold frames back on a slow link, on by default
+    int pending;                // The back buffer holds a frame not sent yet
+    long long dropped;          // Frames replaced before they were sent
+    long long rate;             // Link speed in bytes per second, 0 while unknown
+    long long capacity;         // Bytes the link holds when it is full, once rate is known
+    long long queued;           // Bytes estimated to be in the link; the current burst while rate is unknown
+    long long queued_ns;        // When queued was last brought up to date; start of the burst
+    long long full_ns;          // When the link was found full and how much had been sent
+    long long full_bytes;       //   then, to measure rate; 0 when it is not full
+    long long burst_ns;         // Start and size of the burst that first filled the link,
+    long long burst_bytes;      //   to work out its capacity once rate is known
+    long long calm_ns;          // Since when the link has not been full
+    long long write_ns;         // When the last write() returned
+    long long start_ns;         // When the first frame was sent
+    long long stall_ns;         // Longest render_flush()
+};
+
+// Set up a renderer for a rows x cols screen on fd; the first frame clears the terminal
+int render_init(struct render *r, int fd, int rows, int cols);
+
+// Start a frame: blank the back buffer and return the canvas to draw it on
+struct game_canvas *render_begin(struct render *r);
+
+// Forget what the terminal shows, e.g. after something else wrote to it
+void render_invalidate(struct render *r);
+
+// Send the difference between the back and front buffers, returns 0 on success.
+// Under backpressure the frame is held back instead; see render_wait_ms().
+int render_flush(struct render *r);
+
+// Milliseconds until a frame held back should be flushed again, -1 if none is
+int render_wait_ms(const struct render *r);
+
+// Finish a frame cut short and send a held one, waiting for the terminal as
+// long as that takes; needed before anything else writes to the terminal
+void render_sync(struct render *r);
+
+// Print frames sent and dropped and the output rate
+void render_report(const struct render *r, FILE *f);
+
+// Drive a renderer on a pseudo-terminal read at bytes_per_sec, with and
+// without backpressure, and compare stalls and lag; returns 0 if all pass
+int render_bench(int bytes_per_sec);
+
+// Release the buffers
+void render_free(struct render *r);
+
+// Get the size of the terminal on fd, 24 x 80 if it is not a terminal
+void render_term_size(int fd, int *rows, int *cols);
+
+#endif
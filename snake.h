@@ -0,0 +1,215 @@
+#ifndef SNAKE_H
+#define SNAKE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define SNAKE_MAX_CELLS ((size_t)1 << 30)   // Largest board, so cell numbers fit in 32 bits
+
+// Directions a snake moves in, stored in two bits each
+enum snake_dir {
+    SNAKE_UP,
+    SNAKE_RIGHT,
+    SNAKE_DOWN,
+    SNAKE_LEFT,
+};
+
+// Outcome of snake_step()
+enum snake_step {
+    SNAKE_MOVED,
+    SNAKE_ATE,      // The head reached the food and the snake grew by one
+    SNAKE_CRASHED,  // The head would leave the board or enter the body; nothing moved
+};
+
+// A snake on a width x height board whose every step costs the same however
+// long it is. The body is a ring of 2-bit moves leading from the tail to the
+// head: a step adds one at the head end and takes one from the tail end, so the
+// segments in between are never touched. An occupancy bitset tells whether a
+// cell is taken, and the cells that are not are kept in an array together with
+// each one's index in it, so that a random free cell is picked in one go and
+// cells are taken or given back by swapping with the last entry.
+//
+// Cells are numbered y * width + x. Header-only like arena.h, so that plugins
+// built on their own can use it too; all memory comes from an arena.
+struct snake {
+    int width, height;
+    uint64_t *occupied;       // One bit per cell, set where the body is
+    uint32_t *free_cells;     // The free_count cells not taken, in no order
+    uint32_t *free_slot;      // Index in free_cells of each free cell
+    uint32_t free_count;
+    unsigned char *moves;     // Ring of 2-bit moves, four per byte, one per segment after the tail
+    uint32_t capacity;        // Moves the ring holds
+    uint32_t first;           // Ring index of the move that leaves the tail
+    uint32_t length;          // Segments, head included
+    int head_x, head_y;
+    int tail_x, tail_y;
+};
+
+static const signed char snake_dx[4] = { 0, 1, 0, -1 };
+static const signed char snake_dy[4] = { -1, 0, 1, 0 };
+
+// Function to work out the arena bytes a snake on a width x height board needs, 0 if it is too large
+static inline size_t snake_arena_size(int width, int height) {
+    size_t cells = (size_t)width * height;
+
+    if (width <= 0 || height <= 0 || cells > SNAKE_MAX_CELLS) {
+        return 0;
+    }
+    return arena_round((cells + 63) / 64 * sizeof(uint64_t)) + 2 * arena_round(cells * sizeof(uint32_t))
+           + arena_round((cells + 3) / 4);
+}
+
+// Function to carve the buffers of a snake on a width x height board, returns 0 on success
+static inline int snake_setup(struct snake *s, struct arena *arena, int width, int height) {
+    size_t cells = (size_t)width * height;
+
+    if (snake_arena_size(width, height) == 0) {
+        return -1;
+    }
+    s->width = width;
+    s->height = height;
+    s->capacity = (uint32_t)cells;
+    s->occupied = arena_array(arena, (cells + 63) / 64, sizeof(uint64_t));
+    s->free_cells = arena_array(arena, cells, sizeof(uint32_t));
+    s->free_slot = arena_array(arena, cells, sizeof(uint32_t));
+    s->moves = arena_alloc(arena, (cells + 3) / 4);
+    return s->occupied != NULL && s->free_cells != NULL && s->free_slot != NULL && s->moves != NULL ? 0 : -1;
+}
+
+// Function to tell whether the body covers a cell
+static inline int snake_occupied(const struct snake *s, uint32_t cell) {
+    return (int)(s->occupied[cell >> 6] >> (cell & 63)) & 1;
+}
+
+// Function to put a cell under the body: set its bit and swap it out of the free cells
+static inline void snake_take(struct snake *s, uint32_t cell) {
+    uint32_t slot = s->free_slot[cell];
+    uint32_t last = s->free_cells[--s->free_count];
+
+    s->free_cells[slot] = last;
+    s->free_slot[last] = slot;
+    s->occupied[cell >> 6] |= (uint64_t)1 << (cell & 63);
+}
+
+// Function to hand a cell the body left back to the free cells
+static inline void snake_give(struct snake *s, uint32_t cell) {
+    s->free_slot[cell] = s->free_count;
+    s->free_cells[s->free_count++] = cell;
+    s->occupied[cell >> 6] &= ~((uint64_t)1 << (cell & 63));
+}
+
+// Function to read move i of the ring
+static inline int snake_move_at(const struct snake *s, uint32_t i) {
+    return (s->moves[i >> 2] >> ((i & 3) * 2)) & 3;
+}
+
+// Function to write move i of the ring
+static inline void snake_set_move(struct snake *s, uint32_t i, int dir) {
+    unsigned char shift = (unsigned char)((i & 3) * 2);
+    s->moves[i >> 2] = (unsigned char)((s->moves[i >> 2] & ~(3 << shift)) | (dir << shift));
+}
+
+// Function to empty the board and start a snake of one segment at (x, y); the only step that scans the board
+static inline void snake_start(struct snake *s, int x, int y) {
+    uint32_t cells = s->capacity;
+
+    memset(s->occupied, 0, (cells + 63) / 64 * sizeof(uint64_t));
+    for (uint32_t i = 0; i < cells; i++) {
+        s->free_cells[i] = i;
+        s->free_slot[i] = i;
+    }
+    s->free_count = cells;
+    s->first = 0;
+    s->length = 1;
+    s->head_x = s->tail_x = x;
+    s->head_y = s->tail_y = y;
+    snake_take(s, (uint32_t)(y * s->width + x));
+}
+
+// Function to move the head one cell in dir, growing by one if it lands on the
+// food cell
+static inline int snake_step(struct snake *s, int dir, uint32_t food) {
+    const int width = s->width;
+    int x = s->head_x + snake_dx[dir];
+    int y = s->head_y + snake_dy[dir];
+
+    if (x < 0 || x >= width || y < 0 || y >= s->height) {
+        return SNAKE_CRASHED;
+    }
+    // The tail counts as well: it has not moved out of the way yet
+    uint32_t cell = (uint32_t)y * (uint32_t)width + (uint32_t)x;
+    if (snake_occupied(s, cell)) {
+        return SNAKE_CRASHED;
+    }
+
+    // Add the move at the head end of the ring
+    uint32_t end = s->first + s->length - 1;
+    snake_set_move(s, end >= s->capacity ? end - s->capacity : end, dir);
+    snake_take(s, cell);
+    s->head_x = x;
+    s->head_y = y;
+    if (cell == food) {
+        s->length++;
+        return SNAKE_ATE;
+    }
+
+    // And take the oldest one from the tail end
+    int tail = snake_move_at(s, s->first);
+    snake_give(s, (uint32_t)s->tail_y * (uint32_t)width + (uint32_t)s->tail_x);
+    s->tail_x += snake_dx[tail];
+    s->tail_y += snake_dy[tail];
+    if (++s->first == s->capacity) {
+        s->first = 0;
+    }
+    return SNAKE_MOVED;
+}
+
+// Function to pick a free cell from a random number, returns -1 once the body fills the board
+static inline long snake_free_cell(const struct snake *s, unsigned long random) {
+    return s->free_count == 0 ? -1 : (long)s->free_cells[random % s->free_count];
+}
+
+// Function to pack the body's moves from the tail to the head, four per byte,
+// into out; returns the bytes written, (length - 1 + 3) / 4
+static inline size_t snake_pack(const struct snake *s, unsigned char *out) {
+    size_t bytes = ((size_t)s->length - 1 + 3) / 4;
+    uint32_t i = s->first;
+
+    memset(out, 0, bytes);
+    for (uint32_t n = 0; n + 1 < s->length; n++) {
+        out[n >> 2] |= (unsigned char)(snake_move_at(s, i) << ((n & 3) * 2));
+        if (++i == s->capacity) {
+            i = 0;
+        }
+    }
+    return bytes;
+}
+
+// Function to lay out a body of length segments from its tail at (x, y) and
+// the moves packed by snake_pack(); returns -1 if it leaves the board or
+// crosses itself
+static inline int snake_unpack(struct snake *s, int x, int y, uint32_t length, const unsigned char *in) {
+    if (length < 1 || length > s->capacity || x < 0 || x >= s->width || y < 0 || y >= s->height) {
+        return -1;
+    }
+    snake_start(s, x, y);
+    for (uint32_t n = 0; n + 1 < length; n++) {
+        int dir = (in[n >> 2] >> ((n & 3) * 2)) & 3;
+        x += snake_dx[dir];
+        y += snake_dy[dir];
+        if (x < 0 || x >= s->width || y < 0 || y >= s->height || snake_occupied(s, (uint32_t)(y * s->width + x))) {
+            return -1;
+        }
+        snake_set_move(s, n, dir);
+        snake_take(s, (uint32_t)(y * s->width + x));
+    }
+    s->length = length;
+    s->head_x = x;
+    s->head_y = y;
+    return 0;
+}
+
+#endif
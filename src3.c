@@ -1,136 +1,167 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
-#include <termios.h>
-#include <signal.h>
+#include <string.h>
+
+#include "game_plugin.h"
+#include "maze.h"
+#ifndef GAME_PLUGIN_BUILD
 #include <time.h>
 
-#define ROWS 15
+#include "game_runtime.h"
+#endif
+
+#define ROWS 15     // Maze played when no size is asked for
 #define COLS 20
-#define BANDIT_COUNT 15
+#define MIN_SIDE 5
+#define MAX_ROWS (GAME_CANVAS_ROWS - 5)  // Room left for the title, the life and the message
+#define MAX_COLS GAME_CANVAS_COLS
+#define BANDIT_COUNT 15     // On a ROWS x COLS maze, scaled with the area of others
 #define LIFE_PILL_COUNT 3
 #define POISON_COUNT 5
 #define BLOCK_COUNT 15
+#define STEP_MS 330   // Time per step of the warrior
+#define MOVES 2       // Steps remembered ahead
+
+// Game variables
+typedef struct PrincessGame {
+    int rows, cols;        // Maze size, settled by princess_configure()
+    struct maze maze;      // rows * cols cells, row by row, and room to generate them
+    int warrior_x, warrior_y; // Warrior position, drawn at random like the princess's
+    int life; // Warrior's initial life
+    int princess_x, princess_y; // Princess position (random)
+    int bandit_count, life_pill_count, poison_count, block_count;
+    int (*bandits)[2]; // Bandit positions
+    int (*life_pills)[2]; // Life pills positions
+    int (*poisons)[2]; // Poison positions
+    int (*blocks)[2]; // Random block positions
+    const char *message; // Shown once the game is over
+    char moves[MOVES]; // Keys waiting for their step
+    int move_count;
+} PrincessGame;
+
+// Function to draw the maze, clipped to the canvas
+static void draw_maze(const PrincessGame *g, struct game_canvas *c) {
+    canvas_blit(c, g->maze.grid, g->cols, g->rows, g->cols < c->cols ? g->cols : c->cols);
+}
 
-// Global variables
-char maze[ROWS][COLS];
-int warrior_x = 0, warrior_y = 0; // Warrior starting position at (0, 0)
-int life = 3; // Warrior's initial life
-int princess_x, princess_y; // Princess position (random)
-int bandits[BANDIT_COUNT][2]; // Bandit positions
-int life_pills[LIFE_PILL_COUNT][2]; // Life pills positions
-int poisons[POISON_COUNT][2]; // Poison positions
-int blocks[BLOCK_COUNT][2]; // Random block positions
-struct termios oldt, newt;
+// Function to print the maze and life
+void print_maze(const PrincessGame *g, struct game_canvas *c) {
+    canvas_style(c, GAME_STYLE_TITLE);
+    canvas_puts(c, "Save the Princess Game");
+    canvas_style(c, GAME_STYLE_PLAIN);
+    canvas_puts(c, "\n\n");
+    canvas_printf(c, "Life: %d\n", g->life); // Display remaining life
+    draw_maze(g, c);
+}
 
-// Function to restore terminal settings
-void restore_terminal() {
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+// Function to put an item on a cell of the maze and note where it is; an item
+// left out for want of room is at (-1, -1)
+static void put_item(PrincessGame *g, char item, int pos[2], uint32_t cell) {
+    if (cell == MAZE_NO_CELL) {
+        pos[0] = pos[1] = -1;
+        return;
+    }
+    pos[0] = (int)(cell / (uint32_t)g->cols);
+    pos[1] = (int)(cell % (uint32_t)g->cols);
+    g->maze.grid[cell] = item;
 }
 
-// Signal handler for graceful exit
-void handle_exit(int sig) {
-    restore_terminal();
-    printf("\nGame exited gracefully.\n");
-    exit(0);
+// Function to scale a count of items for the inside of the maze to the share
+// of it that is open, so that corridors and caves are not crammed with them;
+// the arrays were sized for the whole inside
+static int open_share(const PrincessGame *g, int count, uint32_t open) {
+    int n = (int)((long long)count * open / ((long long)(g->rows - 2) * (g->cols - 2)));
+    return n > 0 ? n : 1;
 }
 
-// Function to print the maze and life
-void print_maze() {
-    system("clear"); // Clear the console
-    printf("\033[1;34mSave the Princess Game\033[0m\n\n");
-    printf("Life: %d\n", life); // Display remaining life
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            printf("%c", maze[i][j]);
+// Function to place the warrior, the princess and the items on distinct open
+// cells of a freshly generated maze. The cells are picked in one pass along
+// the maze, then each takes one of the items still to place at random, with
+// as many chances as there are of that item left, which spreads them as a
+// shuffle would. Blocks come last, walled in one pass as well.
+static void place_everyone(PrincessGame *g, uint64_t seed, uint32_t open) {
+    uint64_t random = ~seed;   // Not the stream the maze was carved with
+    int warrior[1][2], princess[1][2];
+
+    g->bandit_count = open_share(g, g->bandit_count, open);
+    g->life_pill_count = open_share(g, g->life_pill_count, open);
+    g->poison_count = open_share(g, g->poison_count, open);
+    g->block_count = open_share(g, g->block_count, open);
+    struct {
+        char item;
+        int count;
+        int (*pos)[2];
+    } kinds[] = {
+        { 'W', 1, warrior },
+        { 'P', 1, princess },
+        { 'B', g->bandit_count, g->bandits },
+        { 'L', g->life_pill_count, g->life_pills },
+        { 'X', g->poison_count, g->poisons },
+    };
+    const int kind_count = (int)(sizeof(kinds) / sizeof(kinds[0]));
+    int left[sizeof(kinds) / sizeof(kinds[0])];
+    uint32_t wanted = 0;
+
+    for (int k = 0; k < kind_count; k++) {
+        wanted += (uint32_t)kinds[k].count;
+    }
+    maze_collect_free(&g->maze);
+    uint32_t picked = maze_pick_free(&g->maze, wanted, &random);
+
+    // With fewer cells than items the last ones are left out; a maze has two
+    // open cells at least, so never the warrior or the princess
+    uint32_t room = picked;
+    for (int k = 0; k < kind_count; k++) {
+        left[k] = (uint32_t)kinds[k].count < room ? kinds[k].count : (int)room;
+        room -= (uint32_t)left[k];
+        for (int i = left[k]; i < kinds[k].count; i++) {
+            put_item(g, kinds[k].item, kinds[k].pos[i], MAZE_NO_CELL);
         }
-        printf("\n");
     }
-}
-
-// Function to generate random maze with elements
-void generate_random_maze() {
-    // Initialize maze with walls and random empty spaces
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            if (i == 0 || i == ROWS - 1 || j == 0 || j == COLS - 1) {
-                maze[i][j] = '#'; // Wall
-            } else {
-                maze[i][j] = (rand() % 4 == 0) ? '#' : '.'; // Random walls or empty spaces
-            }
+    for (uint32_t i = 0; i < picked; i++) {
+        uint32_t r = maze_below(&random, picked - i);
+        int k = 0;
+        while (r >= (uint32_t)left[k]) {
+            r -= (uint32_t)left[k++];
         }
+        left[k]--;
+        put_item(g, kinds[k].item, kinds[k].pos[left[k]], g->maze.work[i]);
+    }
+    g->warrior_x = warrior[0][0];
+    g->warrior_y = warrior[0][1];
+    g->princess_x = princess[0][0];
+    g->princess_y = princess[0][1];
+
+    // Place blocks (#) that do not allow movement, only where walling the cell
+    // in cuts no way off, which in a maze of corridors leaves some out
+    uint32_t walled = maze_block_free(&g->maze, (uint32_t)g->block_count, &random);
+    for (int i = 0; i < g->block_count; i++) {
+        put_item(g, MAZE_WALL, g->blocks[i], (uint32_t)i < walled ? g->maze.work[i] : MAZE_NO_CELL);
     }
+}
 
-    // Ensure there is a clear path from the warrior to the princess
-    for (int j = 0; j < COLS; j++) {
-        maze[0][j] = '.'; // First row
-    }
-    for (int i = 0; i < ROWS; i++) {
-        maze[i][COLS - 1] = '.'; // Last column
-    }
-
-    // Place the warrior
-    maze[warrior_x][warrior_y] = 'W';
-
-    // Randomly place the princess (P) in an open space
-    do {
-        princess_x = rand() % (ROWS - 2) + 1; // Random x position
-        princess_y = rand() % (COLS - 2) + 1; // Random y position
-    } while (maze[princess_x][princess_y] != '.'); // Ensure it's not a wall or block
-     maze[princess_x][princess_y] = 'P'; // Place princess
-
-    // Place bandits (B)
-    for (int i = 0; i < BANDIT_COUNT; i++) {
-        int x, y;
-        do {
-            x = rand() % (ROWS - 2) + 1;
-            y = rand() % (COLS - 2) + 1;
-        } while (maze[x][y] != '.' || (x == princess_x && y == princess_y)); // Ensure no overlap with princess
-        bandits[i][0] = x;
-        bandits[i][1] = y;
-        maze[x][y] = 'B';
-    }
-
-    // Place life pills (L)
-    for (int i = 0; i < LIFE_PILL_COUNT; i++) {
-        int x, y;
-        do {
-            x = rand() % (ROWS - 2) + 1;
-            y = rand() % (COLS - 2) + 1;
-        } while (maze[x][y] != '.' || (x == princess_x && y == princess_y)); // Ensure no overlap with princess
-        life_pills[i][0] = x;
-        life_pills[i][1] = y;
-        maze[x][y] = 'L';
-    }
-
-    // Place poisons (X)
-    for (int i = 0; i < POISON_COUNT; i++) {
-        int x, y;
-        do {
-            x = rand() % (ROWS - 2) + 1;
-            y = rand() % (COLS - 2) + 1;
-        } while (maze[x][y] != '.' || (x == princess_x && y == princess_y)); // Ensure no overlap with princess
-        poisons[i][0] = x;
-        poisons[i][1] = y;
-        maze[x][y] = 'X';
-    }
-
-    // Place blocks (B) that do not allow movement
-    for (int i = 0; i < BLOCK_COUNT; i++) {
-        int x, y;
-        do {
-            x = rand() % (ROWS - 2) + 1;
-            y = rand() % (COLS - 2) + 1;
-        } while (maze[x][y] != '.' || (x == princess_x && y == princess_y)); // Ensure no overlap with princess
-        blocks[i][0] = x;
-        blocks[i][1] = y;
-        maze[x][y] = '#';
+// Function to count the fewest steps from the warrior to the princess, -1 if
+// she cannot be reached; bandits, pills and poison are in the way but passable
+static long princess_distance(PrincessGame *g) {
+    if (g->warrior_x < 0 || g->princess_x < 0) {
+        return -1;
     }
+    return maze_distance(&g->maze, (uint32_t)(g->warrior_x * g->cols + g->warrior_y),
+                         (uint32_t)(g->princess_x * g->cols + g->princess_y));
+}
+
+// Function to generate a maze with elements from a seed: the generators leave
+// every open cell joined to every other and blocks keep it that way, which the
+// search proves; returns the steps from the warrior to the princess
+long generate_random_maze(PrincessGame *g, const struct maze_generator *generator, uint64_t seed) {
+    uint32_t open = maze_generate(&g->maze, generator, seed);
+    place_everyone(g, seed, open);
+    return princess_distance(g);
 }
 
 // Function to move the warrior
-void move_warrior(char direction) {
-    int new_x = warrior_x, new_y = warrior_y;
+int move_warrior(PrincessGame *g, char direction) {
+    int new_x = g->warrior_x, new_y = g->warrior_y;
 
     if (direction == 'w') new_x--;       // Move up
     else if (direction == 'a') new_y--; // Move left
@@ -138,100 +169,333 @@ void move_warrior(char direction) {
     else if (direction == 'd') new_y++; // Move right
 
     // Check if the new position is within bounds and not a wall or block
-    if (new_x >= 0 && new_x < ROWS && new_y >= 0 && new_y < COLS && maze[new_x][new_y] != '#') {
+    if (new_x >= 0 && new_x < g->rows && new_y >= 0 && new_y < g->cols && g->maze.grid[new_x * g->cols + new_y] != '#') {
+        char *cell = &g->maze.grid[new_x * g->cols + new_y];
+
         // Check for life pill
-        if (maze[new_x][new_y] == 'L') {
-            life++;  // Increase life
-            maze[new_x][new_y] = '.';  // Remove life pill from the maze
+        if (*cell == 'L') {
+            g->life++;  // Increase life
+            *cell = '.';  // Remove life pill from the maze
         }
 
         // Check for bandit
-        if (maze[new_x][new_y] == 'B') {
-            life--;   // Decrease life when encountering bandit
-            maze[new_x][new_y] = '.';  // Remove bandit from the maze
+        if (*cell == 'B') {
+            g->life--;   // Decrease life when encountering bandit
+            *cell = '.';  // Remove bandit from the maze
         }
 
         // Check for poison
-        if (maze[new_x][new_y] == 'X') {
-            life--;  // Decrease life when stepping on poison
-            maze[new_x][new_y] = '.';  // Remove poison
+        if (*cell == 'X') {
+            g->life--;  // Decrease life when stepping on poison
+            *cell = '.';  // Remove poison
         }
 
         // Check for princess
-        if (new_x == princess_x && new_y == princess_y) {
-            print_maze();
-            printf("Congratulations! You saved the princess!\n");            
-            restore_terminal();
-            exit(0);
+        if (new_x == g->princess_x && new_y == g->princess_y) {
+            g->message = "Congratulations! You saved the princess!";
+            return GAME_OVER;
         }
 
         // Update player position
-        maze[warrior_x][warrior_y] = '.';
-        warrior_x = new_x;
-        warrior_y = new_y;
-        maze[warrior_x][warrior_y] = 'W'; // Set new position
+        g->maze.grid[g->warrior_x * g->cols + g->warrior_y] = '.';
+        g->warrior_x = new_x;
+        g->warrior_y = new_y;
+        g->maze.grid[g->warrior_x * g->cols + g->warrior_y] = 'W'; // Set new position
 
         // Check if warrior's life is zero
-        if (life <= 0) {
-            print_maze();
-            printf("Game Over! You lost all your life.\n");
-            restore_terminal();
-            exit(0);
+        if (g->life <= 0) {
+            g->message = "Game Over! You lost all your life.";
+            return GAME_OVER;
+        }
+    }
+    return GAME_CONTINUE;
+}
+
+// Function to scale a count of items on a ROWS x COLS maze to the area inside the walls of this one
+static int scaled(int count, int rows, int cols) {
+    int n = count * (rows - 2) * (cols - 2) / ((ROWS - 2) * (COLS - 2));
+    return n > 0 ? n : 1;
+}
+
+// Function to work out the arena bytes of a rows x cols maze and its items
+static size_t princess_arena_size(int rows, int cols) {
+    int items = scaled(BANDIT_COUNT, rows, cols) + scaled(LIFE_PILL_COUNT, rows, cols)
+                + scaled(POISON_COUNT, rows, cols) + scaled(BLOCK_COUNT, rows, cols);
+    return maze_arena_size(rows, cols) + 4 * ARENA_ALIGN + items * sizeof(int[2]);
+}
+
+// Function to settle the maze size: the default for what is not asked, clamped to fit the canvas
+static int princess_configure(struct game_board *board, size_t *arena_size) {
+    int *side[2] = { &board->width, &board->height };
+    int fallback[2] = { COLS, ROWS };
+    int most[2] = { MAX_COLS, MAX_ROWS };
+
+    for (int i = 0; i < 2; i++) {
+        if (*side[i] <= 0) {
+            *side[i] = fallback[i];
         }
+        *side[i] = *side[i] < MIN_SIDE ? MIN_SIDE : *side[i] > most[i] ? most[i] : *side[i];
     }
+    *arena_size = princess_arena_size(board->height, board->width);
+    return 0;
 }
 
-// Function to get user input without requiring 'Enter' key
-char get_input() {
-    char ch;
-    struct termios oldt, newt;
+// Function to take the maze and the item positions from the arena
+static int princess_alloc(PrincessGame *g, struct arena *arena, const struct game_board *board) {
+    g->rows = board->height;
+    g->cols = board->width;
+    g->bandit_count = scaled(BANDIT_COUNT, g->rows, g->cols);
+    g->life_pill_count = scaled(LIFE_PILL_COUNT, g->rows, g->cols);
+    g->poison_count = scaled(POISON_COUNT, g->rows, g->cols);
+    g->block_count = scaled(BLOCK_COUNT, g->rows, g->cols);
+    if (maze_setup(&g->maze, arena, g->rows, g->cols) != 0) {
+        return -1;
+    }
+    g->bandits = arena_array(arena, g->bandit_count, sizeof(int[2]));
+    g->life_pills = arena_array(arena, g->life_pill_count, sizeof(int[2]));
+    g->poisons = arena_array(arena, g->poison_count, sizeof(int[2]));
+    g->blocks = arena_array(arena, g->block_count, sizeof(int[2]));
+    return g->bandits != NULL && g->life_pills != NULL && g->poisons != NULL
+           && g->blocks != NULL ? 0 : -1;
+}
 
-    // Save old terminal settings and apply new ones
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);  // Disable canonical mode and echo
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+// Function to set up a new game
+static int princess_init(void *state, struct arena *arena, const struct game_board *board, unsigned int seed) {
+    PrincessGame *g = state;
+    const struct maze_generator *generator = maze_find(getenv(MAZE_ENV));
 
-    ch = getchar(); // Get user input
+    if (princess_alloc(g, arena, board) != 0) {
+        return -1;
+    }
+    g->life = 3;
 
-    // Restore old terminal settings
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    // Generate the random maze with obstacles, bandits, and the princess, with
+    // the generator asked for or else one the seed picks
+    if (generator == NULL) {
+        generator = &maze_generators[seed % MAZE_GENERATORS];
+    }
+    return generate_random_maze(g, generator, seed) >= 0 ? 0 : -1;
+}
+
+// Function to handle one key; moves are kept for the next steps, and keys
+// held down beyond MOVES are dropped so the warrior stops when they are released
+static int princess_handle_input(void *state, int key) {
+    PrincessGame *g = state;
+
+    if (key == 'q') { // Exit on 'q'
+        return GAME_QUIT;
+    }
 
-    return ch;
+    if (g->move_count < MOVES) {
+        g->moves[g->move_count++] = game_key_wasd(key); // Arrows included
+    }
+    return GAME_CONTINUE;
 }
 
-// Main function
-int main() {
-    // Set up terminal for non-canonical mode
-    tcgetattr(STDIN_FILENO, &oldt); // Save old settings
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO); // Disable canonical mode and echo
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-
-    // Handle signals for graceful exit
-    signal(SIGINT, handle_exit);
-    signal(SIGTERM, handle_exit);
-
-    // Seed random number generator
-    srand(time(NULL));
-
-    // Generate the random maze with obstacles, bandits, and the princess
-    generate_random_maze();
-
-    // Game loop
-    while (1) {
-        print_maze(); // Display the maze with stats
-        char input = get_input(); // Read user input without requiring 'Enter'
-
-        if (input == 'q') { // Exit on 'q'
-            break;
-        }
-        move_warrior(input); // Update warrior position
-        sleep(0.33);
+// Function to take the next step, at most one every STEP_MS
+static int princess_tick(void *state) {
+    PrincessGame *g = state;
+
+    if (g->move_count == 0) {
+        return GAME_IDLE; // Standing still until the next key
     }
+    char move = g->moves[0];
+    memmove(g->moves, g->moves + 1, --g->move_count);
+    return move_warrior(g, move); // Update warrior position
+}
+
+// Function to draw the maze, and the result once the game is over
+static void princess_draw(const void *state, struct game_canvas *c) {
+    const PrincessGame *g = state;
+
+    print_maze(g, c); // Display the maze with stats
+    if (g->message != NULL) {
+        canvas_printf(c, "%s\n", g->message);
+    }
+}
 
-    // Restore terminal settings and exit
-    restore_terminal();
-    printf("\nGame exited gracefully.\n");
+// Function to report the life points left as the score
+static int princess_score(const void *state) {
+    const PrincessGame *g = state;
+    return g->life;
+}
+
+// Function to save the maze and where everyone stands; the maze already marks
+// every bandit, pill, poison and block that is left
+static size_t princess_save(const void *state, void *buf, size_t cap) {
+    const PrincessGame *g = state;
+    int where[5] = { g->warrior_x, g->warrior_y, g->life, g->princess_x, g->princess_y };
+    size_t cells = (size_t)g->rows * g->cols;
+
+    if (cap < cells + sizeof(where)) {
+        return 0;
+    }
+    memcpy(buf, g->maze.grid, cells);
+    memcpy((char *)buf + cells, where, sizeof(where));
+    return cells + sizeof(where);
+}
+
+// Function to continue a saved game
+static int princess_restore(void *state, struct arena *arena, const struct game_board *board,
+                            const void *buf, size_t len) {
+    PrincessGame *g = state;
+    int where[5];
+    size_t cells = (size_t)board->width * board->height;
+
+    if (len != cells + sizeof(where)) {
+        return -1;
+    }
+    if (princess_alloc(g, arena, board) != 0) {
+        return -1;
+    }
+    memcpy(g->maze.grid, buf, cells);
+    memcpy(where, (const char *)buf + cells, sizeof(where));
+    if (where[0] < 0 || where[0] >= g->rows || where[1] < 0 || where[1] >= g->cols) {
+        return -1;
+    }
+    g->warrior_x = where[0];
+    g->warrior_y = where[1];
+    g->life = where[2];
+    g->princess_x = where[3];
+    g->princess_y = where[4];
     return 0;
 }
+
+// Catalog metadata
+GAME_NOTE("Save the Princess Game", "Cross the maze past bandits and poison to reach the princess.");
+
+// Plugin descriptor
+const struct game_plugin game_plugin = {
+    .abi_version = GAME_ABI_VERSION,
+    .name = "save_the_princess",
+    .title = "Save the Princess Game",
+    .state_size = sizeof(PrincessGame),
+    .board = { COLS, ROWS },
+    .tick_ms = STEP_MS,
+    .configure = princess_configure,
+    .init = princess_init,
+    .handle_input = princess_handle_input,
+    .tick = princess_tick,
+    .draw = princess_draw,
+    .score = princess_score,
+    .save = princess_save,
+    .restore = princess_restore,
+};
+
+#ifndef GAME_PLUGIN_BUILD
+#define BENCH_ROUNDS 20000   // Frames drawn per timing
+
+// Function to read the monotonic clock in nanoseconds
+static long long bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to time drawing mazes of the common widths, returns 0 if each is
+// drawn as it is
+static int bench_board(void) {
+    static const int widths[] = { 20, 40, 100 };
+    static struct game_cell cells[GAME_CANVAS_ROWS * GAME_CANVAS_COLS];
+    struct game_canvas c = { cells, GAME_CANVAS_ROWS, GAME_CANVAS_COLS, 0, 0, 0 };
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+        struct game_board board = { widths[i], MAX_ROWS };
+        PrincessGame g = { 0 };
+        struct arena arena;
+        size_t size;
+
+        princess_configure(&board, &size);
+        void *mem = malloc(size);
+        if (mem == NULL) {
+            perror("malloc");
+            return -1;
+        }
+        arena_init(&arena, mem, size);
+        princess_alloc(&g, &arena, &board);
+        generate_random_maze(&g, &maze_generators[0], 1);
+
+        canvas_clear(&c);
+        long long start = bench_ns();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            c.row = 0;
+            draw_maze(&g, &c);
+        }
+        long long ns = bench_ns() - start;
+
+        int same = 1;
+        for (int y = 0; y < g.rows; y++) {
+            for (int x = 0; x < g.cols; x++) {
+                same &= cells[y * c.cols + x].ch == g.maze.grid[y * g.cols + x];
+            }
+        }
+        printf("%dx%d: drawing %.2f us/frame; %s\n", g.cols, g.rows, ns / 1000.0 / BENCH_ROUNDS,
+               same ? "drawn as generated" : "DRAWN WRONG");
+        failed |= !same;
+        free(mem);
+    }
+    return failed ? -1 : 0;
+}
+
+// Function to time every generator on mazes from the canvas's size up to
+// the largest, then placing everyone and searching from the warrior; returns
+// 0 if the princess can always be reached and every open cell still can be
+static int bench_maze(void) {
+    static const int sides[][2] = { { MAX_ROWS, MAX_COLS }, { 1024, 1024 }, { MAZE_MAX_SIDE, MAZE_MAX_SIDE } };
+    int failed = 0;
+
+    for (size_t s = 0; s < sizeof(sides) / sizeof(sides[0]); s++) {
+        for (int i = 0; i < MAZE_GENERATORS; i++) {
+            struct game_board board = { sides[s][1], sides[s][0] };
+            size_t size = princess_arena_size(board.height, board.width);
+            PrincessGame g = { 0 };
+            struct arena arena;
+
+            void *mem = malloc(size);
+            if (mem == NULL) {
+                perror("malloc");
+                return -1;
+            }
+            arena_init(&arena, mem, size);
+            if (princess_alloc(&g, &arena, &board) != 0) {
+                free(mem);
+                return -1;
+            }
+
+            long long start = bench_ns();
+            uint32_t open = maze_generate(&g.maze, &maze_generators[i], 1);
+            long long carved = bench_ns();
+            place_everyone(&g, 1, open);
+            long long placed = bench_ns();
+            long steps = princess_distance(&g);
+            long long searched = bench_ns();
+
+            // Blocks took open cells, every other one must still be reached
+            uint32_t blocked = 0;
+            for (int b = 0; b < g.block_count; b++) {
+                blocked += g.blocks[b][0] >= 0;
+            }
+            int joined = steps >= 0 && g.maze.reached == open - blocked;
+            printf("%4dx%-4d %-11s: carved in %8.2f ms, placed in %6.2f ms, searched in %7.2f ms; %4.1f%% open, "
+                   "princess %ld steps away, %s\n", g.rows, g.cols, maze_generators[i].name, (carved - start) / 1e6,
+                   (placed - carved) / 1e6, (searched - placed) / 1e6, 100.0 * open / g.maze.cells, steps,
+                   joined ? "all reachable" : "CUT OFF");
+            failed |= !joined;
+            free(mem);
+        }
+    }
+    return failed ? -1 : 0;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--bench-board") == 0) {
+        return bench_board() == 0 ? 0 : 1;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--bench-maze") == 0) {
+        return bench_maze() == 0 ? 0 : 1;
+    }
+    return game_main(&game_plugin, argc, argv);
+}
+#endif
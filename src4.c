@@ -0,0 +1,269 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "battle.h"
+#include "game_plugin.h"
+#include "pool.h"
+#include "snake.h"
+#ifndef GAME_PLUGIN_BUILD
+#include <time.h>
+
+#include "game_runtime.h"
+#endif
+
+#define WIDTH 512     // Board played when no size is asked for
+#define HEIGHT 256
+#define SPEED_MS 100  // Time per step, VGC_TICK_MS overrides it
+#define VIEW_ROWS (GAME_CANVAS_ROWS - 6)  // Room left for the title, the status and the messages
+#define VIEW_COLS GAME_CANVAS_COLS
+
+// What is drawn in a cell of the board
+static const char cell_chars[] = { '.', '#', 'O', '*' };  // In the order of enum battle_cell
+#define CELL_PLAYER '@'
+
+// Game variables
+typedef struct ArenaGame {
+    struct battle battle;   // Board and snakes, sized by arena_game_configure()
+    struct pool *pool;      // Threads the ticks run on
+    int best;               // Longest the player's snake grew
+    int over;               // Set when the game ended
+} ArenaGame;
+
+// Function to work out the arena bytes a board needs: the battle and a pool on a cache line of its own
+static size_t arena_game_size(int width, int height) {
+    size_t size = battle_arena_size(width, height);
+    return size == 0 ? 0 : size + arena_round(sizeof(struct pool)) + 64 - ARENA_ALIGN;
+}
+
+// Function to settle the board size: the default for what is not asked, clamped to what a battle can hold
+static int arena_game_configure(struct game_board *board, size_t *arena_size) {
+    int *side[2] = { &board->width, &board->height };
+    int fallback[2] = { WIDTH, HEIGHT };
+
+    for (int i = 0; i < 2; i++) {
+        if (*side[i] <= 0) {
+            *side[i] = fallback[i];
+        }
+        *side[i] = *side[i] < BATTLE_MIN_SIDE ? BATTLE_MIN_SIDE
+                   : *side[i] > BATTLE_MAX_SIDE ? BATTLE_MAX_SIDE : *side[i];
+    }
+    *arena_size = arena_game_size(board->width, board->height);
+    return 0;
+}
+
+// Function to set up a new game: the threads, then the snakes, the player's among them
+static int arena_game_init(void *state, struct arena *arena, const struct game_board *board, unsigned int seed) {
+    ArenaGame *g = state;
+
+    g->pool = arena_alloc_aligned(arena, sizeof(struct pool), 64);
+    if (g->pool == NULL || pool_init(g->pool, pool_cores()) != 0) {
+        g->pool = NULL;
+        return -1;
+    }
+    if (battle_setup(&g->battle, arena, board->width, board->height, 1, seed) != 0) {
+        pool_free(g->pool);
+        g->pool = NULL;
+        return -1;
+    }
+    g->best = (int)g->battle.snakes[0].length;
+    return 0;
+}
+
+// Function to stop the threads
+static void arena_game_shutdown(void *state) {
+    ArenaGame *g = state;
+
+    if (g->pool != NULL) {
+        pool_free(g->pool);
+        g->pool = NULL;
+    }
+}
+
+// Function to handle one key
+static int arena_game_handle_input(void *state, int key) {
+    ArenaGame *g = state;
+    const char *dir;
+
+    if (key == 'q') {  // Exit on 'q'
+        return GAME_QUIT;
+    }
+    key = game_key_wasd(key);  // Arrow keys steer as well
+    dir = key != 0 ? strchr("wdsa", key) : NULL;  // In the order of enum snake_dir
+    if (dir != NULL) {
+        battle_steer(&g->battle, (int)(dir - "wdsa"));
+    }
+    return GAME_CONTINUE;
+}
+
+// Function to move every snake one step
+static int arena_game_tick(void *state) {
+    ArenaGame *g = state;
+    const struct battle_snake *player = &g->battle.snakes[0];
+
+    battle_tick(&g->battle, g->pool);
+    if (player->length == 0) {
+        g->over = 1;
+        return GAME_OVER;
+    }
+    g->best = (int)player->length > g->best ? (int)player->length : g->best;
+    return GAME_CONTINUE;
+}
+
+// Function to draw the part of the board around the player's head
+static void draw_view(const ArenaGame *g, struct game_canvas *c) {
+    const struct battle *b = &g->battle;
+    const struct battle_snake *player = &b->snakes[0];
+    int rows = b->height < VIEW_ROWS ? b->height : VIEW_ROWS;
+    int cols = b->width < VIEW_COLS ? b->width : VIEW_COLS;
+    cols = cols < c->cols ? cols : c->cols;  // A narrow terminal shows less of it
+    int top = player->head_y - rows / 2;
+    int left = player->head_x - cols / 2;
+    char line[VIEW_COLS];
+
+    // Keep the view on the board
+    top = top < 0 ? 0 : top > b->height - rows ? b->height - rows : top;
+    left = left < 0 ? 0 : left > b->width - cols ? b->width - cols : left;
+
+    int view_top = c->row;
+    for (int y = top; y < top + rows; y++) {
+        const unsigned char *cells = &b->cells[y * b->width + left];
+        for (int x = 0; x < cols; x++) {
+            line[x] = cell_chars[cells[x]];
+        }
+        canvas_blit(c, line, 0, 1, cols);
+    }
+
+    // The player's head, in colour; it stays where it died
+    int row = view_top + player->head_y - top;
+    if (row < c->rows && player->head_x - left < c->cols) {
+        struct game_cell *cell = &c->cells[row * c->cols + player->head_x - left];
+        cell->ch = CELL_PLAYER;
+        cell->style = player->length > 0 ? GAME_STYLE_GOOD : GAME_STYLE_BAD;
+    }
+}
+
+// Function to draw the board, or the final length once the game is over
+static void arena_game_draw(const void *state, struct game_canvas *c) {
+    const ArenaGame *g = state;
+    const struct battle *b = &g->battle;
+
+    canvas_style(c, GAME_STYLE_TITLE);
+    canvas_puts(c, "Snake Arena");
+    canvas_style(c, GAME_STYLE_PLAIN);
+    canvas_printf(c, "  %dx%d board, %d snakes, %d threads\n\n", b->width, b->height, b->snake_count,
+                  g->pool != NULL ? g->pool->threads : 0);
+    canvas_printf(c, "Length: %u  Best: %d  Tick: %u  Deaths: %ld\n", b->snakes[0].length, g->best, b->tick,
+                  b->deaths);
+    draw_view(g, c);
+    if (g->over) {
+        if (b->snakes[0].length == 0) {
+            canvas_puts(c, "Game Over: Your snake ran into a wall or another snake.\n");
+        }
+        canvas_printf(c, "Game Over! Final Length: %d\n", g->best);
+    }
+}
+
+// Function to report the score to the launcher
+static int arena_game_score(const void *state) {
+    const ArenaGame *g = state;
+    return g->best;
+}
+
+// Catalog metadata
+GAME_NOTE("Snake Arena", "Outgrow thousands of bot snakes on one big board.");
+
+// Plugin descriptor
+const struct game_plugin game_plugin = {
+    .abi_version = GAME_ABI_VERSION,
+    .name = "snake_arena",
+    .title = "Snake Arena",
+    .state_size = sizeof(ArenaGame),
+    .board = { WIDTH, HEIGHT },
+    .tick_ms = SPEED_MS,
+    .flags = GAME_FLAG_OWN_PROCESS,  // A thread per core and thousands of bots every tick
+    .configure = arena_game_configure,
+    .init = arena_game_init,
+    .handle_input = arena_game_handle_input,
+    .tick = arena_game_tick,
+    .draw = arena_game_draw,
+    .score = arena_game_score,
+    .shutdown = arena_game_shutdown,
+};
+
+#ifndef GAME_PLUGIN_BUILD
+#define BENCH_SIDE 1024     // Board of the benchmark, 16384 snakes
+#define BENCH_TICKS 300     // Ticks timed for every thread count
+#define BENCH_SEED 1
+
+// Function to read the monotonic clock in nanoseconds
+static long long bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to play the same battle of bots on 1, 2, 4... threads, up to twice
+// the cores online, timing the ticks; returns 0 if every run ends the same
+static int bench_arena(void) {
+    size_t size = arena_game_size(BENCH_SIDE, BENCH_SIDE);
+    int cores = pool_cores();
+    double single = 0;
+    uint64_t first_hash = 0;
+    int failed = 0;
+
+    void *mem = malloc(size);
+    if (mem == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    printf("%dx%d board, %d snakes, %d ticks, %d cores online\n", BENCH_SIDE, BENCH_SIDE,
+           BENCH_SIDE * BENCH_SIDE / BATTLE_CELLS_PER_SNAKE, BENCH_TICKS, cores);
+
+    for (int threads = 1; threads <= 2 * cores || threads <= 4; threads *= 2) {
+        struct pool *pool;
+        struct battle b;
+        struct arena arena;
+
+        arena_init(&arena, mem, size);
+        pool = arena_alloc_aligned(&arena, sizeof(struct pool), 64);
+        if (pool == NULL || pool_init(pool, threads) != 0) {
+            failed = 1;
+            break;
+        }
+        if (battle_setup(&b, &arena, BENCH_SIDE, BENCH_SIDE, 0, BENCH_SEED) != 0) {
+            pool_free(pool);
+            failed = 1;
+            break;
+        }
+
+        long long start = bench_ns();
+        for (int t = 0; t < BENCH_TICKS; t++) {
+            battle_tick(&b, pool);
+        }
+        double seconds = (double)(bench_ns() - start) / 1e9;
+        uint64_t hash = battle_hash(&b);
+        long long steals = pool_steals(pool);
+        pool_free(pool);
+
+        double rate = BENCH_TICKS / seconds;
+        single = threads == 1 ? rate : single;
+        first_hash = threads == 1 ? hash : first_hash;
+        failed |= hash != first_hash;
+        printf("%2d threads: %8.1f ticks/s, %.2fx one thread, %lld steals, %ld deaths, hash %016llx\n",
+               threads, rate, rate / single, steals, b.deaths, (unsigned long long)hash);
+    }
+    free(mem);
+
+    printf("results %s across thread counts\n", failed ? "DIFFER" : "identical");
+    return failed ? -1 : 0;
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    if (argc >= 2 && strcmp(argv[1], "--bench-arena") == 0) {
+        return bench_arena() == 0 ? 0 : 1;
+    }
+    return game_main(&game_plugin, argc, argv);
+}
+#endif
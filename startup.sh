@@ -23,6 +23,18 @@ sudo ln -s /dev/vgc_device vgc_device
 echo "Copying executables to the mounted disk..."
 sudo cp bin/* mount/
 
+# Install the sudoku puzzle bank, building it first if initialize.sh did not
+echo "Installing the sudoku puzzle bank..."
+if [ ! -f "data/sudoku.bank" ]; then
+    sudo mkdir -p data
+    sudo ./bin/sudoku-tool --build-bank data/sudoku.bank 100000
+fi
+sudo cp data/sudoku.bank mount/
+
+# Build the catalog manifest so the launcher does not scan the disk at startup
+echo "Building the game catalog..."
+sudo ./bin/main-screen --build-catalog mount
+
 # Disk image is mounted and executables copied
 echo "Disk image mounted and executables copied successfully."
 
@@ -0,0 +1,604 @@
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sudoku.h"
+
+#define ALL 0x1ff   // Every value, bit v - 1 standing for value v
+
+// Sixteen 16-bit lanes, of which the first nine are used: one per cell of a
+// line of the board, or one per row, column or box
+typedef uint16_t lanes __attribute__((vector_size(32)));
+
+// The lanes past the ninth: set in every mask of values placed, so that they
+// never show up as a candidate nor as a value missing from a unit
+static const lanes PADDING = { 0, 0, 0, 0, 0, 0, 0, 0, 0, ALL, ALL, ALL, ALL, ALL, ALL, ALL };
+
+// The search is compiled for AVX2 as well as for any x86-64, and the copy the
+// processor can run is picked when the program loads: a vector of sixteen
+// lanes fits one AVX2 register but has to be split for SSE2. ThreadSanitizer
+// cannot run the resolver that picks the copy, so it gets the plain one.
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && !defined(__SANITIZE_THREAD__)
+#define SUDOKU_CLONES __attribute__((target_clones("arch=x86-64-v3", "default")))
+#else
+#define SUDOKU_CLONES
+#endif
+
+// Lane masks, to update a few lanes of a vector with whole-vector operations:
+// writing single lanes would stall the next read of the whole vector
+#define X 0xffff
+static const lanes LANE[9] = {   // Lane j
+    { X }, { 0, X }, { 0, 0, X }, { 0, 0, 0, X }, { 0, 0, 0, 0, X }, { 0, 0, 0, 0, 0, X },
+    { 0, 0, 0, 0, 0, 0, X }, { 0, 0, 0, 0, 0, 0, 0, X }, { 0, 0, 0, 0, 0, 0, 0, 0, X },
+};
+static const lanes TRIPLE[3] = {   // Lanes 3k to 3k + 2
+    { X, X, X }, { 0, 0, 0, X, X, X }, { 0, 0, 0, 0, 0, 0, X, X, X },
+};
+static const lanes STRIDE[3] = {   // Lanes k, k + 3 and k + 6
+    { X, 0, 0, X, 0, 0, X }, { 0, X, 0, 0, X, 0, 0, X }, { 0, 0, X, 0, 0, X, 0, 0, X },
+};
+#undef X
+
+// Ways of laying the board out as nine vectors. Adding up the nine vectors
+// lane by lane goes over the cells of a column in the first layout, of a row in
+// the second and of a box in the third, so every unit can be checked for
+// values with one place left in it at once.
+enum layout {
+    BY_ROW,   // Vector r, lane c: the cell in row r and column c
+    BY_COL,   // Vector c, lane r: the same cell
+    BY_BOX,   // Vector p, lane b: the cell at position p of box b, both counted row by row
+};
+
+// A board being solved. Rather than the candidates of every cell, it keeps the
+// values placed in every unit, spread over the lanes the way the candidates of
+// each layout need them, so a whole vector of candidates is a few ORs away.
+struct state {
+    lanes row_used;       // Lane r: values placed in row r
+    lanes col_used;       // Lane c: values placed in column c
+    lanes box_used;       // Lane b: values placed in box b
+    lanes box_by_col[3];  // Band k, lane c: values placed in the box of band k over column c
+    lanes box_by_row[3];  // Stack k, lane r: values placed in the box of row r in stack k
+    lanes row_by_box[3];  // Vector k, lane b: values placed in row k of box b
+    lanes col_by_box[3];  // Vector k, lane b: values placed in column k of box b
+    lanes open[3][9];     // ALL in the lanes of empty cells, per layout
+    unsigned char grid[SUDOKU_CELLS];
+    int empty;            // Cells left to fill
+};
+
+// What a search looks for and what it found so far
+struct search {
+    unsigned char *solution;
+    int limit;
+    int found;
+    struct sudoku_stats *stats;
+};
+
+// Function to tell whether any lane is set
+static inline int any(const lanes *v) {
+    uint64_t words[4];
+    memcpy(words, v, sizeof words);
+    return (words[0] | words[1] | words[2] | words[3]) != 0;
+}
+
+// Function to find the cell at vector i, lane j of a layout
+static inline int cell_of(int layout, int i, int j) {
+    switch (layout) {
+    case BY_ROW:
+        return i * 9 + j;
+    case BY_COL:
+        return j * 9 + i;
+    default:
+        return (j / 3 * 3 + i / 3) * 9 + j % 3 * 3 + i % 3;
+    }
+}
+
+// Function to set up an empty board
+static void state_init(struct state *s) {
+    lanes open = ~PADDING & ALL;
+
+    s->row_used = s->col_used = s->box_used = PADDING;
+    for (int k = 0; k < 3; k++) {
+        s->box_by_col[k] = s->box_by_row[k] = s->row_by_box[k] = s->col_by_box[k] = PADDING;
+    }
+    for (int layout = 0; layout < 3; layout++) {
+        for (int i = 0; i < 9; i++) {
+            s->open[layout][i] = open;
+        }
+    }
+    memset(s->grid, 0, sizeof s->grid);
+    s->empty = SUDOKU_CELLS;
+}
+
+// Function to put value v in a cell; returns 1 if it was placed, 0 if the
+// cell already held it and -1 if it clashes with the board
+static int place(struct state *s, int cell, int v) {
+    int r = cell / 9, c = cell % 9;
+    int b = r / 3 * 3 + c / 3, p = r % 3 * 3 + c % 3;
+    uint16_t bit = (uint16_t)(1 << (v - 1));
+
+    if (s->grid[cell] != 0) {
+        return s->grid[cell] == v ? 0 : -1;
+    }
+    if ((s->row_used[r] | s->col_used[c] | s->box_used[b]) & bit) {
+        return -1;
+    }
+    s->grid[cell] = (unsigned char)v;
+    s->empty--;
+
+    s->row_used |= bit & LANE[r];
+    s->col_used |= bit & LANE[c];
+    s->box_used |= bit & LANE[b];
+    s->box_by_col[r / 3] |= bit & TRIPLE[c / 3];
+    s->box_by_row[c / 3] |= bit & TRIPLE[r / 3];
+    s->row_by_box[r % 3] |= bit & TRIPLE[r / 3];
+    s->col_by_box[c % 3] |= bit & STRIDE[c / 3];
+    s->open[BY_ROW][r] &= ~LANE[c];
+    s->open[BY_COL][c] &= ~LANE[r];
+    s->open[BY_BOX][p] &= ~LANE[b];
+    return 1;
+}
+
+// Function to work out the candidates of every cell in one layout; filled cells have none
+static void candidates(const struct state *s, int layout, lanes cand[9]) {
+    for (int i = 0; i < 9; i++) {
+        lanes used;
+        switch (layout) {
+        case BY_ROW:
+            used = s->col_used | s->box_by_col[i / 3] | s->row_used[i];
+            break;
+        case BY_COL:
+            used = s->row_used | s->box_by_row[i / 3] | s->col_used[i];
+            break;
+        default:
+            used = s->box_used | s->row_by_box[i / 3] | s->col_by_box[i % 3];
+            break;
+        }
+        cand[i] = ~used & s->open[layout][i];
+    }
+}
+
+// Function to fill what one layout shows: values with one place left in the
+// units across its lanes and, in the row layout, cells with one value left.
+// Returns the cells filled, or -1 if the board cannot be solved.
+static inline __attribute__((always_inline)) int sweep(struct state *s, int layout, struct sudoku_stats *stats) {
+    lanes cand[9], once = { 0 }, twice = { 0 }, dead = { 0 };
+    const lanes used = layout == BY_ROW ? s->col_used : layout == BY_COL ? s->row_used : s->box_used;
+    int filled = 0;
+
+    candidates(s, layout, cand);
+    for (int i = 0; i < 9; i++) {
+        dead |= (lanes)(cand[i] == 0) & s->open[layout][i];
+        twice |= once & cand[i];
+        once |= cand[i];
+    }
+    // An empty cell with no value left, or a value with no place left in a unit
+    dead |= (once | used) ^ ALL;
+    if (any(&dead)) {
+        return -1;
+    }
+
+    lanes hidden = once & ~twice;
+    if (any(&hidden)) {
+        for (int j = 0; j < 9; j++) {
+            for (unsigned int m = hidden[j]; m != 0; m &= m - 1) {
+                unsigned int bit = m & -m;
+                int i = 0;
+                while (!(cand[i][j] & bit)) {
+                    i++;
+                }
+                int placed = place(s, cell_of(layout, i, j), __builtin_ctz(bit) + 1);
+                if (placed < 0) {
+                    return -1;
+                }
+                filled += placed;
+                stats->hidden += placed;
+            }
+        }
+    }
+
+    if (layout == BY_ROW) {
+        for (int i = 0; i < 9; i++) {
+            lanes single = (lanes)((cand[i] & (cand[i] - 1)) == 0) & cand[i];
+            if (!any(&single)) {
+                continue;
+            }
+            for (int j = 0; j < 9; j++) {
+                if (single[j] != 0) {
+                    int placed = place(s, i * 9 + j, __builtin_ctz(single[j]) + 1);
+                    if (placed < 0) {
+                        return -1;
+                    }
+                    filled += placed;
+                    stats->naked += placed;
+                }
+            }
+        }
+    }
+    return filled;
+}
+
+// Function to fill every cell the singles decide, going round the layouts
+// until none of them fills anything; returns -1 if the board cannot be solved.
+// The layouts are swept by name so that each sweep is compiled for its own.
+static int propagate(struct state *s, struct sudoku_stats *stats) {
+    int filled[3] = { 1, 1, 1 };
+
+    while (s->empty > 0 && filled[0] + filled[1] + filled[2] > 0) {
+        if ((filled[BY_ROW] = sweep(s, BY_ROW, stats)) < 0 || (filled[BY_COL] = sweep(s, BY_COL, stats)) < 0
+            || (filled[BY_BOX] = sweep(s, BY_BOX, stats)) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to solve a board by propagating, then trying every value of the
+// cell with the fewest left, until the search has found as many solutions as
+// it looks for
+__attribute__((flatten)) SUDOKU_CLONES
+static void search(struct state *s, struct search *job) {
+    lanes cand[9];
+    int best = -1, fewest = 10;
+
+    if (propagate(s, job->stats) < 0) {
+        return;
+    }
+    if (s->empty == 0) {
+        if (job->found++ == 0 && job->solution != NULL) {
+            memcpy(job->solution, s->grid, SUDOKU_CELLS);
+        }
+        return;
+    }
+
+    candidates(s, BY_ROW, cand);
+    for (int cell = 0; cell < SUDOKU_CELLS && fewest > 2; cell++) {
+        if (s->grid[cell] == 0) {
+            int n = __builtin_popcount(cand[cell / 9][cell % 9]);
+            if (n < fewest) {
+                fewest = n;
+                best = cell;
+            }
+        }
+    }
+
+    job->stats->guesses++;
+    unsigned int m = cand[best / 9][best % 9];
+    while (m != 0 && job->found < job->limit) {
+        int v = __builtin_ctz(m) + 1;
+        m &= m - 1;
+        if (m == 0) {  // The last value can have the board itself
+            place(s, best, v);
+            search(s, job);
+        } else {
+            struct state next = *s;
+            place(&next, best, v);
+            search(&next, job);
+        }
+    }
+}
+
+// Function to read a puzzle from text
+int sudoku_parse(const char *text, unsigned char *grid) {
+    for (int i = 0; i < SUDOKU_CELLS; i++) {
+        if (text[i] >= '1' && text[i] <= '9') {
+            grid[i] = (unsigned char)(text[i] - '0');
+        } else if (text[i] == '0' || text[i] == '.') {
+            grid[i] = 0;
+        } else {
+            return -1;
+        }
+    }
+    char end = text[SUDOKU_CELLS];
+    return end == '\0' || isspace((unsigned char)end) ? 0 : -1;
+}
+
+// Function to write a grid as text
+void sudoku_format(const unsigned char *grid, char *text) {
+    for (int i = 0; i < SUDOKU_CELLS; i++) {
+        text[i] = grid[i] != 0 ? (char)('0' + grid[i]) : '.';
+    }
+    text[SUDOKU_CELLS] = '\0';
+}
+
+// Function to solve a puzzle and count its solutions up to a limit
+int sudoku_solve(const unsigned char *puzzle, unsigned char *solution, int limit, struct sudoku_stats *stats) {
+    struct sudoku_stats unused = { 0 };
+    struct search job = { solution, limit < 1 ? 1 : limit, 0, stats != NULL ? stats : &unused };
+    struct state s;
+
+    state_init(&s);
+    for (int cell = 0; cell < SUDOKU_CELLS; cell++) {
+        if (puzzle[cell] > 9 || (puzzle[cell] != 0 && place(&s, cell, puzzle[cell]) < 0)) {
+            return 0;  // Givens that clash leave nothing to solve
+        }
+    }
+    search(&s, &job);
+    return job.found;
+}
+
+const char *const sudoku_grade_names[SUDOKU_GRADES] = { "easy", "medium", "hard", "expert" };
+
+// Function to look up a grade by name
+int sudoku_find_grade(const char *name) {
+    for (int grade = 0; grade < SUDOKU_GRADES; grade++) {
+        if (strcmp(name, sudoku_grade_names[grade]) == 0) {
+            return grade;
+        }
+    }
+    return -1;
+}
+
+// A board solved the way a person would: every empty cell keeps the values
+// not yet ruled out, which the techniques narrow down
+struct logic {
+    uint16_t cand[SUDOKU_CELLS];   // Values left in every empty cell, 0 in filled ones
+    unsigned char grid[SUDOKU_CELLS];
+    int empty;
+};
+
+// Function to find cell i of unit u: rows are units 0-8, columns 9-17 and boxes 18-26
+static inline int unit_cell(int u, int i) {
+    if (u < 9) {
+        return u * 9 + i;
+    }
+    if (u < 18) {
+        return i * 9 + u - 9;
+    }
+    u -= 18;
+    return (u / 3 * 3 + i / 3) * 9 + u % 3 * 3 + i % 3;
+}
+
+// Function to fill a cell and rule its value out of the cells that see it;
+// returns -1 if the value was already ruled out there
+static int logic_fill(struct logic *l, int cell, int v) {
+    int units[3] = { cell / 9, 9 + cell % 9, 18 + cell / 27 * 3 + cell % 9 / 3 };
+    uint16_t bit = (uint16_t)(1 << (v - 1));
+
+    if (l->grid[cell] != 0 || !(l->cand[cell] & bit)) {
+        return -1;
+    }
+    l->grid[cell] = (unsigned char)v;
+    l->cand[cell] = 0;
+    l->empty--;
+    for (int k = 0; k < 3; k++) {
+        for (int i = 0; i < 9; i++) {
+            l->cand[unit_cell(units[k], i)] &= (uint16_t)~bit;
+        }
+    }
+    return 0;
+}
+
+// Function to fill every naked and hidden single in sight; returns the cells
+// filled, or -1 on a contradiction
+static int logic_singles(struct logic *l) {
+    int filled = 0;
+
+    for (int cell = 0; cell < SUDOKU_CELLS; cell++) {
+        uint16_t m = l->cand[cell];
+        if (l->grid[cell] == 0 && (m & (m - 1)) == 0) {
+            if (m == 0 || logic_fill(l, cell, __builtin_ctz(m) + 1) != 0) {
+                return -1;
+            }
+            filled++;
+        }
+    }
+    for (int u = 0; u < 27; u++) {
+        unsigned int once = 0, twice = 0;
+        for (int i = 0; i < 9; i++) {
+            twice |= once & l->cand[unit_cell(u, i)];
+            once |= l->cand[unit_cell(u, i)];
+        }
+        for (unsigned int m = once & ~twice; m != 0; m &= m - 1) {
+            for (int i = 0; i < 9; i++) {
+                int cell = unit_cell(u, i);
+                if (l->cand[cell] & m & -m) {
+                    if (logic_fill(l, cell, __builtin_ctz(m) + 1) != 0) {
+                        return -1;
+                    }
+                    filled++;
+                    break;
+                }
+            }
+        }
+    }
+    return filled;
+}
+
+// Function to rule a value out of the cells of unit u outside unit keep; returns how many lost it
+static int logic_rule_out(struct logic *l, int u, int keep, uint16_t bit) {
+    int removed = 0;
+
+    for (int i = 0; i < 9; i++) {
+        int cell = unit_cell(u, i), inside = 0;
+        for (int k = 0; k < 9 && !inside; k++) {
+            inside = unit_cell(keep, k) == cell;
+        }
+        if (!inside && (l->cand[cell] & bit)) {
+            l->cand[cell] &= (uint16_t)~bit;
+            removed++;
+        }
+    }
+    return removed;
+}
+
+// Function to apply locked candidates: a value that a box only has room for
+// in one row or column cannot go elsewhere in that line, and a value that a
+// line only has room for in one box cannot go elsewhere in that box. Returns
+// the candidates ruled out.
+static int logic_locked(struct logic *l) {
+    int removed = 0;
+
+    for (int u = 0; u < 27; u++) {
+        for (int v = 0; v < 9; v++) {
+            uint16_t bit = (uint16_t)(1 << v);
+            int rows = 0, cols = 0, boxes = 0, cells = 0;
+            for (int i = 0; i < 9; i++) {
+                int cell = unit_cell(u, i);
+                if (l->cand[cell] & bit) {
+                    rows |= 1 << (cell / 9);
+                    cols |= 1 << (cell % 9);
+                    boxes |= 1 << (cell / 27 * 3 + cell % 9 / 3);
+                    cells++;
+                }
+            }
+            if (cells < 2) {
+                continue;  // Singles are for logic_singles()
+            }
+            if (u >= 18 && (rows & (rows - 1)) == 0) {
+                removed += logic_rule_out(l, __builtin_ctz(rows), u, bit);
+            }
+            if (u >= 18 && (cols & (cols - 1)) == 0) {
+                removed += logic_rule_out(l, 9 + __builtin_ctz(cols), u, bit);
+            }
+            if (u < 18 && (boxes & (boxes - 1)) == 0) {
+                removed += logic_rule_out(l, 18 + __builtin_ctz(boxes), u, bit);
+            }
+        }
+    }
+    return removed;
+}
+
+// Function to apply naked pairs and triples, two or three cells of a unit
+// with only as many values between them, which the unit's other cells cannot
+// have, and hidden pairs, two values with the same two places in a unit,
+// which those places must hold. Returns the candidates ruled out.
+static int logic_subsets(struct logic *l) {
+    int removed = 0;
+
+    for (int u = 0; u < 27; u++) {
+        int cells[9], n = 0;
+        uint16_t places[9] = { 0 };   // Value v, bit i: cell i of the unit can have it
+
+        for (int i = 0; i < 9; i++) {
+            int cell = unit_cell(u, i);
+            for (int v = 0; v < 9; v++) {
+                places[v] |= (uint16_t)(((l->cand[cell] >> v) & 1) << i);
+            }
+            if (l->grid[cell] == 0) {
+                cells[n++] = cell;
+            }
+        }
+
+        for (int a = 0; a < n; a++) {
+            for (int b = a + 1; b < n; b++) {
+                for (int c = b; c < n; c++) {   // c == b: a pair
+                    uint16_t both = l->cand[cells[a]] | l->cand[cells[b]] | l->cand[cells[c]];
+                    if (__builtin_popcount(both) != (c == b ? 2 : 3)) {
+                        continue;
+                    }
+                    for (int k = 0; k < n; k++) {
+                        if (k != a && k != b && k != c && (l->cand[cells[k]] & both)) {
+                            l->cand[cells[k]] &= (uint16_t)~both;
+                            removed++;
+                        }
+                    }
+                }
+            }
+        }
+
+        for (int v = 0; v < 9; v++) {
+            for (int w = v + 1; w < 9; w++) {
+                if (places[v] != places[w] || __builtin_popcount(places[v]) != 2) {
+                    continue;
+                }
+                uint16_t pair = (uint16_t)(1 << v | 1 << w);
+                for (unsigned int m = places[v]; m != 0; m &= m - 1) {
+                    int cell = unit_cell(u, __builtin_ctz(m));
+                    if (l->cand[cell] & ~pair) {
+                        l->cand[cell] &= pair;
+                        removed++;
+                    }
+                }
+            }
+        }
+    }
+    return removed;
+}
+
+// Function to grade a puzzle by the hardest technique solving it takes
+int sudoku_grade(const unsigned char *puzzle) {
+    struct logic l;
+    int grade = SUDOKU_EASY;
+
+    l.empty = SUDOKU_CELLS;
+    for (int cell = 0; cell < SUDOKU_CELLS; cell++) {
+        l.cand[cell] = ALL;
+        l.grid[cell] = 0;
+    }
+    for (int cell = 0; cell < SUDOKU_CELLS; cell++) {
+        if (puzzle[cell] > 9 || (puzzle[cell] != 0 && logic_fill(&l, cell, puzzle[cell]) != 0)) {
+            return -1;
+        }
+    }
+
+    // Always the easiest technique that still gets somewhere
+    while (l.empty > 0) {
+        int filled = logic_singles(&l);
+        if (filled < 0) {
+            return -1;
+        } else if (filled > 0) {
+            continue;
+        } else if (logic_locked(&l) > 0) {
+            grade = grade > SUDOKU_MEDIUM ? grade : SUDOKU_MEDIUM;
+        } else if (logic_subsets(&l) > 0) {
+            grade = SUDOKU_HARD;
+        } else {
+            return SUDOKU_EXPERT;
+        }
+    }
+    return grade;
+}
+
+// Function to advance a splitmix64 generator
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function to shuffle n values
+static void shuffle(unsigned char *values, int n, uint64_t *random) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)(next_random(random) % (uint64_t)(i + 1));
+        unsigned char t = values[i];
+        values[i] = values[j];
+        values[j] = t;
+    }
+}
+
+// Function to generate a graded puzzle with a unique solution
+int sudoku_generate(uint64_t seed, unsigned char *puzzle, unsigned char *solution) {
+    unsigned char full[SUDOKU_CELLS] = { 0 }, order[SUDOKU_CELLS];
+    uint64_t random = seed;
+
+    // The three boxes on the diagonal share no unit, so any values do for
+    // them, and whatever they hold the rest of the grid can be completed
+    for (int b = 0; b < 9; b += 4) {
+        unsigned char values[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+        shuffle(values, 9, &random);
+        for (int i = 0; i < 9; i++) {
+            full[unit_cell(18 + b, i)] = values[i];
+        }
+    }
+    sudoku_solve(full, full, 1, NULL);
+
+    memcpy(puzzle, full, SUDOKU_CELLS);
+    for (int i = 0; i < SUDOKU_CELLS; i++) {
+        order[i] = (unsigned char)i;
+    }
+    shuffle(order, SUDOKU_CELLS, &random);
+    for (int i = 0; i < SUDOKU_CELLS; i++) {
+        int cell = order[i];
+        unsigned char given = puzzle[cell];
+        puzzle[cell] = 0;
+        if (sudoku_solve(puzzle, NULL, SUDOKU_MANY, NULL) != 1) {
+            puzzle[cell] = given;
+        }
+    }
+
+    if (solution != NULL) {
+        memcpy(solution, full, SUDOKU_CELLS);
+    }
+    return sudoku_grade(puzzle);
+}
@@ -0,0 +1,58 @@
+#ifndef SUDOKU_H
+#define SUDOKU_H
+
+#include <stdint.h>
+
+#define SUDOKU_SIDE 9
+#define SUDOKU_CELLS (SUDOKU_SIDE * SUDOKU_SIDE)
+#define SUDOKU_MANY 2   // Solutions to look for when checking that a puzzle has only one
+
+// What solving a puzzle took, over every branch of the search
+struct sudoku_stats {
+    long long naked;     // Cells filled because one value was left for them
+    long long hidden;    // Cells filled because a row, column or box had one place left for a value
+    long long guesses;   // Cells the search had to branch on
+};
+
+// How hard a puzzle is for a person, by the hardest technique it takes
+enum sudoku_grade {
+    SUDOKU_EASY,     // Naked and hidden singles
+    SUDOKU_MEDIUM,   // Locked candidates as well
+    SUDOKU_HARD,     // Naked pairs and triples and hidden pairs as well
+    SUDOKU_EXPERT,   // None of those is enough: it takes trial and error
+    SUDOKU_GRADES,
+};
+
+// Names of the grades, "easy" to "expert"
+extern const char *const sudoku_grade_names[SUDOKU_GRADES];
+
+// Look up a grade by name; returns it, or -1 if no grade has that name
+int sudoku_find_grade(const char *name);
+
+// Read a puzzle written as 81 cells row by row, a digit for a given and '0'
+// or '.' for an empty cell, into values 0 to 9; the cells may be followed by
+// the end of the text or by white space and anything after it. Returns 0 on
+// success, -1 if the text is not a puzzle.
+int sudoku_parse(const char *text, unsigned char *grid);
+
+// Write a grid as 81 characters, '.' for empty cells, and a terminating NUL
+void sudoku_format(const unsigned char *grid, char *text);
+
+// Solve a puzzle of values 0 to 9, row by row, looking for at most limit
+// solutions; the first one found goes to solution if it is not NULL, and the
+// work done is added to stats if it is not NULL. Returns how many solutions
+// were found: with limit SUDOKU_MANY, 0, 1 or 2 for a puzzle with none, a
+// unique one or several.
+int sudoku_solve(const unsigned char *puzzle, unsigned char *solution, int limit, struct sudoku_stats *stats);
+
+// Grade a puzzle with a unique solution by solving it with the techniques of
+// enum sudoku_grade; returns the grade, or -1 if the puzzle contradicts itself
+int sudoku_grade(const unsigned char *puzzle);
+
+// Generate a puzzle: fill a complete grid at random, then empty its cells in
+// random order, keeping each given whose removal would leave more than one
+// solution. The solution goes to solution if it is not NULL. The same seed
+// always gives the same puzzle. Returns the puzzle's grade.
+int sudoku_generate(uint64_t seed, unsigned char *puzzle, unsigned char *solution);
+
+#endif
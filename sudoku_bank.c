@@ -0,0 +1,261 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sudoku_bank.h"
+
+#define GROUP_BITS 10   // Bits of three givens, 9 * 9 * 9 < 1024
+
+// Function to write the low bits of value at bit offset at of a record
+static void put_bits(unsigned char *record, int at, unsigned int value, int bits) {
+    for (int i = 0; i < bits; i++) {
+        if (value >> i & 1) {
+            record[(at + i) / 8] |= (unsigned char)(1 << (at + i) % 8);
+        }
+    }
+}
+
+// Function to read bits bits at bit offset at of a record, a byte at a time
+static unsigned int get_bits(const unsigned char *record, int at, int bits) {
+    unsigned int value = record[at / 8] >> at % 8;
+    for (int got = 8 - at % 8, byte = at / 8 + 1; got < bits; got += 8, byte++) {
+        value |= (unsigned int)record[byte] << got;
+    }
+    return value & ((1u << bits) - 1);
+}
+
+// Function to pack a puzzle into a record
+int sudoku_bank_pack(const unsigned char *puzzle, unsigned char *record) {
+    unsigned int group = 0;
+    int givens = 0, at = SUDOKU_BANK_MASK_BYTES * 8;
+
+    memset(record, 0, SUDOKU_BANK_RECORD);
+    for (int cell = 0; cell < SUDOKU_CELLS; cell++) {
+        if (puzzle[cell] == 0) {
+            continue;
+        }
+        if (++givens > SUDOKU_BANK_MAX_GIVENS) {
+            return -1;
+        }
+        record[cell / 8] |= (unsigned char)(1 << cell % 8);
+        group = group * 9 + puzzle[cell] - 1;
+        if (givens % 3 == 0) {
+            put_bits(record, at, group, GROUP_BITS);
+            at += GROUP_BITS;
+            group = 0;
+        }
+    }
+    // The last group, its missing digits read as zeros
+    if (givens % 3 != 0) {
+        for (int i = givens % 3; i < 3; i++) {
+            group *= 9;
+        }
+        put_bits(record, at, group, GROUP_BITS);
+    }
+    return 0;
+}
+
+// Function to unpack a record into a puzzle, once its mask is known to name
+// cells of the grid only and no more givens than the record holds digits for
+int sudoku_bank_unpack(const unsigned char *record, unsigned char *puzzle) {
+    const int last = SUDOKU_BANK_MASK_BYTES - 1;
+    unsigned int group = 0;
+    int givens = 0, at = SUDOKU_BANK_MASK_BYTES * 8;
+
+    for (int byte = 0; byte < SUDOKU_BANK_MASK_BYTES; byte++) {
+        givens += __builtin_popcount(record[byte]);
+    }
+    if (givens > SUDOKU_BANK_MAX_GIVENS || (unsigned int)record[last] >> (SUDOKU_CELLS - last * 8) != 0) {
+        return -1;
+    }
+    givens = 0;
+    memset(puzzle, 0, SUDOKU_CELLS);
+    for (int byte = 0; byte < SUDOKU_BANK_MASK_BYTES; byte++) {
+        // Only the cells with a given, lowest first
+        for (unsigned int mask = record[byte]; mask != 0; mask &= mask - 1) {
+            int cell = byte * 8 + __builtin_ctz(mask);
+            if (givens % 3 == 0) {
+                group = get_bits(record, at, GROUP_BITS);
+                at += GROUP_BITS;
+            }
+            static const unsigned int place[3] = { 81, 9, 1 };
+            puzzle[cell] = (unsigned char)(group / place[givens % 3] % 9 + 1);
+            givens++;
+        }
+    }
+    return 0;
+}
+
+// Function to map a bank
+int sudoku_bank_open(struct sudoku_bank *bank, const char *path) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    memset(bank, 0, sizeof(*bank));
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            perror(path);
+        }
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(struct sudoku_bank_header)) {
+        fprintf(stderr, "%s: not a puzzle bank\n", path);
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    bank->header = map;
+    bank->records = (const unsigned char *)map + sizeof(struct sudoku_bank_header);
+    bank->size = (size_t)st.st_size;
+
+    // Everything the picks rely on, so that a damaged file cannot send them out
+    // of the mapping; the records themselves are checked as they are unpacked
+    const struct sudoku_bank_header *h = bank->header;
+    int valid = memcmp(h->magic, SUDOKU_BANK_MAGIC, sizeof(h->magic)) == 0 && h->record_size == SUDOKU_BANK_RECORD
+                && bank->size == sizeof(*h) + (size_t)h->count * SUDOKU_BANK_RECORD;
+    for (int grade = 0; grade < SUDOKU_GRADES && valid; grade++) {
+        valid = (uint64_t)h->first[grade] + h->per_grade[grade] <= h->count;
+    }
+    if (!valid) {
+        fprintf(stderr, "%s: not a puzzle bank\n", path);
+        sudoku_bank_close(bank);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to name the seen marks of the current player
+int sudoku_bank_seen_path(char *path, size_t size) {
+    const char *env = getenv(SUDOKU_SEEN_ENV);
+    const char *player = getenv(SUDOKU_PLAYER_ENV);
+    const char *home = getenv("HOME");
+
+    if (env != NULL) {
+        return snprintf(path, size, "%s", env) < (int)size ? 0 : -1;
+    }
+    player = player != NULL ? player : getenv("USER");
+    if (player == NULL || home == NULL || strchr(player, '/') != NULL) {
+        return -1;
+    }
+    return snprintf(path, size, "%s/.vgc_sudoku_%s.seen", home, player) < (int)size ? 0 : -1;
+}
+
+// Function to map the seen marks of a player
+int sudoku_bank_track(struct sudoku_bank *bank, const char *path) {
+    struct sudoku_seen_header h;
+    size_t size = sizeof(h) + ((size_t)bank->header->count + 63) / 64 * sizeof(uint64_t);
+    struct stat st;
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    // Marks for another bank are no use: start over
+    if (pread(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h) || memcmp(h.magic, SUDOKU_SEEN_MAGIC, sizeof(h.magic)) != 0
+        || h.bank_id != bank->header->id || h.count != bank->header->count || fstat(fd, &st) != 0
+        || (size_t)st.st_size != size) {
+        memcpy(h.magic, SUDOKU_SEEN_MAGIC, sizeof(h.magic));
+        h.bank_id = bank->header->id;
+        h.count = bank->header->count;
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)size) != 0
+            || pwrite(fd, &h, sizeof(h), 0) != (ssize_t)sizeof(h)) {
+            perror(path);
+            close(fd);
+            return -1;
+        }
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    bank->seen = (uint64_t *)((char *)map + sizeof(h));
+    bank->seen_size = size;
+    return 0;
+}
+
+// Function to scramble a seed, so that neighbouring seeds land far apart
+static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function to mark the first record in [from, to) the player has not had as
+// seen, a word of marks at a time; returns it, or -1 if they had them all.
+// Two games of one player can pick at once, hence the atomic updates.
+static long claim_unseen(uint64_t *seen, uint32_t from, uint32_t to) {
+    for (uint64_t i = from; i < to; i = (i | 63) + 1) {
+        uint64_t *word = &seen[i / 64];
+        uint64_t unseen = ~__atomic_load_n(word, __ATOMIC_RELAXED) & (~0ULL << (i % 64));
+
+        while (unseen != 0) {
+            uint64_t j = (i & ~63ULL) + (uint64_t)__builtin_ctzll(unseen);
+            uint64_t bit = 1ULL << (j % 64);
+            if (j >= to) {
+                return -1;
+            }
+            if (!(__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit)) {
+                return (long)j;
+            }
+            unseen &= ~bit;   // Taken in the meantime
+        }
+    }
+    return -1;
+}
+
+// Function to pick a puzzle of a grade
+long sudoku_bank_pick(struct sudoku_bank *bank, int grade, uint64_t seed, unsigned char *puzzle) {
+    const struct sudoku_bank_header *h = bank->header;
+
+    if (grade < 0 || grade >= SUDOKU_GRADES || h->per_grade[grade] == 0) {
+        return -1;
+    }
+    uint32_t first = h->first[grade], end = first + h->per_grade[grade];
+    long index = (long)(first + mix(seed) % h->per_grade[grade]);
+
+    if (bank->seen != NULL) {
+        long next = claim_unseen(bank->seen, (uint32_t)index, end);
+        if (next < 0) {
+            next = claim_unseen(bank->seen, first, (uint32_t)index);
+        }
+        if (next < 0) {
+            // Every puzzle of the grade was had: forget them and start over
+            for (uint32_t i = first; i < end; i++) {
+                __atomic_fetch_and(&bank->seen[i / 64], ~(1ULL << (i % 64)), __ATOMIC_RELAXED);
+            }
+            __atomic_fetch_or(&bank->seen[index / 64], 1ULL << (index % 64), __ATOMIC_RELAXED);
+            next = index;
+        }
+        index = next;
+    }
+    if (sudoku_bank_unpack(bank->records + (size_t)index * SUDOKU_BANK_RECORD, puzzle) != 0) {
+        return -1;
+    }
+    return index;
+}
+
+// Function to unmap a bank
+void sudoku_bank_close(struct sudoku_bank *bank) {
+    if (bank->seen != NULL) {
+        munmap((char *)bank->seen - sizeof(struct sudoku_seen_header), bank->seen_size);
+    }
+    if (bank->header != NULL) {
+        munmap((void *)bank->header, bank->size);
+    }
+    memset(bank, 0, sizeof(*bank));
+}
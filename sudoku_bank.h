@@ -0,0 +1,82 @@
+#ifndef SUDOKU_BANK_H
+#define SUDOKU_BANK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sudoku.h"
+
+#define SUDOKU_BANK_MAGIC "VGCBANK1"
+#define SUDOKU_SEEN_MAGIC "VGCSEEN1"
+#define SUDOKU_BANK_PATH "mount/sudoku.bank"   // Where startup.sh installs the bank, from the launcher's directory
+#define SUDOKU_BANK_ENV "VGC_SUDOKU_BANK"      // Path of the bank, SUDOKU_BANK_PATH if unset
+#define SUDOKU_GRADE_ENV "VGC_SUDOKU_GRADE"    // Grade of the puzzles picked, by name
+#define SUDOKU_PLAYER_ENV "VGC_PLAYER"         // Name the puzzles a player has seen are kept under, $USER if unset
+#define SUDOKU_SEEN_ENV "VGC_SUDOKU_SEEN"      // Path of the player's seen marks, ~/.vgc_sudoku_<player>.seen if unset
+
+// A puzzle packs into a record of SUDOKU_BANK_RECORD bytes: one bit per cell
+// saying whether it holds a given, then the givens in cell order, three to 10
+// bits as base-9 digits. Solutions are not stored: the solver finds one in
+// microseconds, and the puzzles are unique.
+#define SUDOKU_BANK_RECORD 24
+#define SUDOKU_BANK_MASK_BYTES ((SUDOKU_CELLS + 7) / 8)
+#define SUDOKU_BANK_MAX_GIVENS ((SUDOKU_BANK_RECORD - SUDOKU_BANK_MASK_BYTES) * 8 / 10 * 3)
+
+// Start of a bank file. The records follow, sorted by grade, so the puzzles
+// of a grade are a range and any of them is one multiplication away.
+struct sudoku_bank_header {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t count;                       // Records in the file
+    uint32_t first[SUDOKU_GRADES];        // Index of the first record of every grade
+    uint32_t per_grade[SUDOKU_GRADES];    // Records of every grade
+    uint64_t id;                          // Hash of the records, to tell banks apart
+};
+
+// Start of a player's seen marks: a bit per record of the bank it names follows
+struct sudoku_seen_header {
+    char magic[8];
+    uint64_t bank_id;
+    uint64_t count;
+};
+
+// A bank mapped into memory, and the seen marks of the player picking from it
+struct sudoku_bank {
+    const struct sudoku_bank_header *header;
+    const unsigned char *records;
+    size_t size;          // Bytes of the bank mapped
+    uint64_t *seen;       // Bit i set once the player had record i, NULL when not tracked
+    size_t seen_size;     // Bytes of the seen marks mapped
+};
+
+// Pack a puzzle into a record; returns -1 if it has more than SUDOKU_BANK_MAX_GIVENS givens
+int sudoku_bank_pack(const unsigned char *puzzle, unsigned char *record);
+
+// Unpack a record into a puzzle; returns -1, with the puzzle untouched, if
+// the record is damaged: a given past the last cell, or more givens than
+// SUDOKU_BANK_MAX_GIVENS
+int sudoku_bank_unpack(const unsigned char *record, unsigned char *puzzle);
+
+// Map a bank read-only; returns 0 on success, -1 if it is missing, which is
+// not reported, or if it cannot be read or is not a bank
+int sudoku_bank_open(struct sudoku_bank *bank, const char *path);
+
+// Work out where the seen marks of the player named by the environment go;
+// returns 0 on success
+int sudoku_bank_seen_path(char *path, size_t size);
+
+// Map the player's seen marks for the bank, creating them, or starting them
+// over if they were made for another bank; returns 0 on success
+int sudoku_bank_track(struct sudoku_bank *bank, const char *path);
+
+// Pick a puzzle of a grade from a seed and mark it seen. Where the seed lands
+// is worked out in constant time; with seen marks, the pick moves on to the
+// next puzzle the player has not had, and once they had every puzzle of the
+// grade they start over. Returns the record picked, -1 if the bank has none
+// of that grade or the record is damaged.
+long sudoku_bank_pick(struct sudoku_bank *bank, int grade, uint64_t seed, unsigned char *puzzle);
+
+// Unmap a bank and its seen marks
+void sudoku_bank_close(struct sudoku_bank *bank);
+
+#endif
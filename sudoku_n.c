@@ -0,0 +1,430 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "sudoku_n.h"
+
+#define LANES 32          // Lanes of a vector, enough for a line of the largest grid
+#define FILL_TRIES 8      // Random starts tried for a complete grid before falling back to a pattern
+#define FILL_BUDGET 2000  // Guesses allowed to complete a grid
+#define CHECK_BUDGET 8    // Guesses allowed to settle whether a removal keeps the solution unique
+
+// Thirty-two 32-bit lanes, of which the first side are used: one per cell of
+// a line of the board, or one per row, column or box. Bit v - 1 of a lane
+// stands for value v.
+typedef uint32_t lanes __attribute__((vector_size(LANES * sizeof(uint32_t))));
+
+// As in sudoku.c, the propagation is compiled for AVX2 as well as for any
+// x86-64, and the copy the processor can run is picked when the program loads
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && !defined(__SANITIZE_THREAD__)
+#define SUDOKU_CLONES __attribute__((target_clones("arch=x86-64-v3", "default")))
+#else
+#define SUDOKU_CLONES
+#endif
+
+// Ways of laying the board out as side vectors, as in sudoku.c: adding up the
+// vectors lane by lane goes over the cells of a column, of a row or of a box
+enum layout {
+    BY_ROW,   // Vector r, lane c: the cell in row r and column c
+    BY_COL,   // Vector c, lane r: the same cell
+    BY_BOX,   // Vector p, lane b: the cell at position p of box b, both counted row by row
+    LAYOUTS,
+};
+
+// Shape of a grid, and the lane masks that update a few lanes of a vector
+// with whole-vector operations
+struct geometry {
+    int box, side, cells;
+    uint32_t all;                      // Every value
+    lanes full;                        // all in the lanes used
+    lanes bits;                        // Lane j: bit j, to turn a mask of lanes into a vector
+    lanes lane[SUDOKU_N_MAX_SIDE];     // Lane j
+    lanes group[SUDOKU_N_MAX_BOX];     // Lanes k * box to k * box + box - 1
+    lanes stride[SUDOKU_N_MAX_BOX];    // Lanes k, k + box, k + 2 * box...
+};
+
+// A board being solved: the values placed in every unit, spread over the
+// lanes the way the candidates of each layout need them
+struct state {
+    lanes row_used;                          // Lane r: values placed in row r
+    lanes col_used;                          // Lane c: values placed in column c
+    lanes box_used;                          // Lane b: values placed in box b
+    lanes box_by_col[SUDOKU_N_MAX_BOX];      // Band k, lane c: values placed in the box of band k over column c
+    lanes box_by_row[SUDOKU_N_MAX_BOX];      // Stack k, lane r: values placed in the box of row r in stack k
+    lanes row_by_box[SUDOKU_N_MAX_BOX];      // Vector k, lane b: values placed in row k of box b
+    lanes col_by_box[SUDOKU_N_MAX_BOX];      // Vector k, lane b: values placed in column k of box b
+    uint32_t open[LAYOUTS][SUDOKU_N_MAX_SIDE];  // Bit j of vector i set while its cell is empty, per layout
+    unsigned char grid[SUDOKU_N_MAX_CELLS];
+    int empty;                               // Cells left to fill
+};
+
+// What a search looks for and what it found so far
+struct search {
+    const struct geometry *g;
+    unsigned char *solution;
+    int limit;
+    int found;
+    long long budget;          // Guesses allowed, 0 for no limit
+    int gave_up;               // Set once the guesses ran out
+    struct sudoku_stats *stats;
+};
+
+// Function to work out the shape of a grid; returns -1 if box is out of range
+static int geometry_init(struct geometry *g, int box) {
+    if (box < SUDOKU_N_MIN_BOX || box > SUDOKU_N_MAX_BOX) {
+        return -1;
+    }
+    memset(g, 0, sizeof(*g));
+    g->box = box;
+    g->side = box * box;
+    g->cells = g->side * g->side;
+    g->all = (uint32_t)((1ULL << g->side) - 1);
+    for (int j = 0; j < LANES; j++) {
+        g->bits[j] = 1u << j;
+    }
+    for (int j = 0; j < g->side; j++) {
+        g->full[j] = g->all;
+        g->lane[j][j] = UINT32_MAX;
+        g->group[j / box][j] = UINT32_MAX;
+        g->stride[j % box][j] = UINT32_MAX;
+    }
+    return 0;
+}
+
+// Function to tell whether any lane is set
+static inline int any(const lanes *v) {
+    uint64_t words[LANES / 2], seen = 0;
+    memcpy(words, v, sizeof words);
+    for (int i = 0; i < LANES / 2; i++) {
+        seen |= words[i];
+    }
+    return seen != 0;
+}
+
+// Function to find the cell at vector i, lane j of a layout
+static inline int cell_of(const struct geometry *g, int layout, int i, int j) {
+    switch (layout) {
+    case BY_ROW:
+        return i * g->side + j;
+    case BY_COL:
+        return j * g->side + i;
+    default:
+        return (j / g->box * g->box + i / g->box) * g->side + j % g->box * g->box + i % g->box;
+    }
+}
+
+// Function to set up an empty board
+static void state_init(const struct geometry *g, struct state *s) {
+    memset(s, 0, sizeof(*s));
+    for (int layout = 0; layout < LAYOUTS; layout++) {
+        for (int i = 0; i < g->side; i++) {
+            s->open[layout][i] = g->all;
+        }
+    }
+    s->empty = g->cells;
+}
+
+// Function to put value v in a cell; returns 1 if it was placed, 0 if the
+// cell already held it and -1 if it clashes with the board
+static int place(const struct geometry *g, struct state *s, int cell, int v) {
+    int box = g->box;
+    int r = cell / g->side, c = cell % g->side;
+    int b = r / box * box + c / box, p = r % box * box + c % box;
+    uint32_t bit = 1u << (v - 1);
+
+    if (s->grid[cell] != 0) {
+        return s->grid[cell] == v ? 0 : -1;
+    }
+    if ((s->row_used[r] | s->col_used[c] | s->box_used[b]) & bit) {
+        return -1;
+    }
+    s->grid[cell] = (unsigned char)v;
+    s->empty--;
+
+    s->row_used |= bit & g->lane[r];
+    s->col_used |= bit & g->lane[c];
+    s->box_used |= bit & g->lane[b];
+    s->box_by_col[r / box] |= bit & g->group[c / box];
+    s->box_by_row[c / box] |= bit & g->group[r / box];
+    s->row_by_box[r % box] |= bit & g->group[r / box];
+    s->col_by_box[c % box] |= bit & g->stride[c / box];
+    s->open[BY_ROW][r] &= ~(1u << c);
+    s->open[BY_COL][c] &= ~(1u << r);
+    s->open[BY_BOX][p] &= ~(1u << b);
+    return 1;
+}
+
+// Function to work out the candidates of the cells of vector i of a layout; filled cells have none
+static inline lanes candidates(const struct geometry *g, const struct state *s, int layout, int i) {
+    lanes used, open = (lanes)((g->bits & s->open[layout][i]) != 0) & g->all;
+
+    switch (layout) {
+    case BY_ROW:
+        used = s->col_used | s->box_by_col[i / g->box] | s->row_used[i];
+        break;
+    case BY_COL:
+        used = s->row_used | s->box_by_row[i / g->box] | s->col_used[i];
+        break;
+    default:
+        used = s->box_used | s->row_by_box[i / g->box] | s->col_by_box[i % g->box];
+        break;
+    }
+    return ~used & open;
+}
+
+// Function to fill what one layout shows, as sweep() in sudoku.c does.
+// Returns the cells filled, or -1 if the board cannot be solved.
+static inline __attribute__((always_inline)) int sweep(const struct geometry *g, struct state *s, int layout,
+                                                       struct sudoku_stats *stats) {
+    lanes cand[SUDOKU_N_MAX_SIDE], once = { 0 }, twice = { 0 }, dead = { 0 };
+    const lanes used = layout == BY_ROW ? s->col_used : layout == BY_COL ? s->row_used : s->box_used;
+    int filled = 0;
+
+    for (int i = 0; i < g->side; i++) {
+        cand[i] = candidates(g, s, layout, i);
+        dead |= (lanes)(cand[i] == 0) & (lanes)((g->bits & s->open[layout][i]) != 0);
+        twice |= once & cand[i];
+        once |= cand[i];
+    }
+    // An empty cell with no value left, or a value with no place left in a unit
+    dead |= ~(once | used) & g->full;
+    if (any(&dead)) {
+        return -1;
+    }
+
+    lanes hidden = once & ~twice;
+    if (any(&hidden)) {
+        for (int j = 0; j < g->side; j++) {
+            for (uint32_t m = hidden[j]; m != 0; m &= m - 1) {
+                uint32_t bit = m & -m;
+                int i = 0;
+                while (!(cand[i][j] & bit)) {
+                    i++;
+                }
+                int placed = place(g, s, cell_of(g, layout, i, j), __builtin_ctz(bit) + 1);
+                if (placed < 0) {
+                    return -1;
+                }
+                filled += placed;
+                stats->hidden += placed;
+            }
+        }
+    }
+
+    if (layout == BY_ROW) {
+        for (int i = 0; i < g->side; i++) {
+            lanes single = (lanes)((cand[i] & (cand[i] - 1)) == 0) & cand[i];
+            if (!any(&single)) {
+                continue;
+            }
+            for (int j = 0; j < g->side; j++) {
+                if (single[j] != 0) {
+                    int placed = place(g, s, i * g->side + j, __builtin_ctz(single[j]) + 1);
+                    if (placed < 0) {
+                        return -1;
+                    }
+                    filled += placed;
+                    stats->naked += placed;
+                }
+            }
+        }
+    }
+    return filled;
+}
+
+// Function to fill every cell the singles decide, going round the layouts
+// until none of them fills anything; returns -1 if the board cannot be
+// solved. Kept out of the search, so that its vectors are not on the stack of
+// every level of it.
+__attribute__((noinline, flatten)) SUDOKU_CLONES
+static int propagate(const struct geometry *g, struct state *s, struct sudoku_stats *stats) {
+    int filled[LAYOUTS] = { 1, 1, 1 };
+
+    while (s->empty > 0 && filled[0] + filled[1] + filled[2] > 0) {
+        if ((filled[BY_ROW] = sweep(g, s, BY_ROW, stats)) < 0 || (filled[BY_COL] = sweep(g, s, BY_COL, stats)) < 0
+            || (filled[BY_BOX] = sweep(g, s, BY_BOX, stats)) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to solve a board by propagating, then trying every value of the
+// cell with the fewest left, until the search has found as many solutions as
+// it looks for or used up its guesses
+static void search(struct state *s, struct search *job) {
+    const struct geometry *g = job->g;
+    int best = -1, fewest = LANES + 1;
+
+    if (propagate(g, s, job->stats) < 0) {
+        return;
+    }
+    if (s->empty == 0) {
+        if (job->found++ == 0 && job->solution != NULL) {
+            memcpy(job->solution, s->grid, (size_t)g->cells);
+        }
+        return;
+    }
+
+    for (int i = 0; i < g->side && fewest > 2; i++) {
+        lanes cand = candidates(g, s, BY_ROW, i);
+        for (uint32_t open = s->open[BY_ROW][i]; open != 0; open &= open - 1) {
+            int j = __builtin_ctz(open);
+            int n = __builtin_popcount(cand[j]);
+            if (n < fewest) {
+                fewest = n;
+                best = i * g->side + j;
+            }
+        }
+    }
+
+    if (job->budget > 0 && job->stats->guesses >= job->budget) {
+        job->gave_up = 1;
+        return;
+    }
+    job->stats->guesses++;
+    uint32_t m = candidates(g, s, BY_ROW, best / g->side)[best % g->side];
+    while (m != 0 && job->found < job->limit && !job->gave_up) {
+        int v = __builtin_ctz(m) + 1;
+        m &= m - 1;
+        if (m == 0) {  // The last value can have the board itself
+            place(g, s, best, v);
+            search(s, job);
+        } else {
+            struct state next = *s;
+            place(g, &next, best, v);
+            search(&next, job);
+        }
+    }
+}
+
+// Function to solve a puzzle with at most budget guesses, 0 for no limit;
+// returns the solutions found, or -1 if the guesses ran out first
+static int solve(const struct geometry *g, const unsigned char *puzzle, unsigned char *solution, int limit,
+                 struct sudoku_stats *stats, long long budget) {
+    struct sudoku_stats unused = { 0 };
+    struct search job = { g, solution, limit < 1 ? 1 : limit, 0, budget, 0, stats != NULL ? stats : &unused };
+    struct state s;
+
+    if (budget > 0) {
+        job.budget += job.stats->guesses;   // The guesses of this solve, whatever stats held before
+    }
+    state_init(g, &s);
+    for (int cell = 0; cell < g->cells; cell++) {
+        if (puzzle[cell] > g->side || (puzzle[cell] != 0 && place(g, &s, cell, puzzle[cell]) < 0)) {
+            return 0;  // Givens that clash leave nothing to solve
+        }
+    }
+    search(&s, &job);
+    return job.gave_up ? -1 : job.found;
+}
+
+// Function to solve a puzzle and count its solutions up to a limit
+int sudoku_n_solve(int box, const unsigned char *puzzle, unsigned char *solution, int limit,
+                   struct sudoku_stats *stats) {
+    struct geometry g;
+
+    if (geometry_init(&g, box) != 0) {
+        return 0;
+    }
+    return solve(&g, puzzle, solution, limit, stats, 0);
+}
+
+// Function to check a grid for values out of range and repeats
+int sudoku_n_check(int box, const unsigned char *grid) {
+    struct geometry g;
+    struct state s;
+
+    if (geometry_init(&g, box) != 0) {
+        return 0;
+    }
+    state_init(&g, &s);
+    for (int cell = 0; cell < g.cells; cell++) {
+        if (grid[cell] > g.side || (grid[cell] != 0 && place(&g, &s, cell, grid[cell]) < 0)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Function to advance a splitmix64 generator
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Function to shuffle n cell numbers
+static void shuffle(uint16_t *cells, int n, uint64_t *random) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = (int)(next_random(random) % (uint64_t)(i + 1));
+        uint16_t t = cells[i];
+        cells[i] = cells[j];
+        cells[j] = t;
+    }
+}
+
+// Function to fill a complete grid at random: the boxes on the diagonal share
+// no unit, so they take shuffled values, and the solver completes the rest.
+// Should it take too long, the grid is the pattern that shifts each row by a
+// box and each band by one, with its values shuffled instead.
+static void fill_grid(const struct geometry *g, unsigned char *full, uint64_t *random) {
+    uint16_t values[SUDOKU_N_MAX_SIDE];
+
+    for (int attempt = 0; attempt < FILL_TRIES; attempt++) {
+        memset(full, 0, (size_t)g->cells);
+        for (int b = 0; b < g->side; b += g->box + 1) {
+            for (int i = 0; i < g->side; i++) {
+                values[i] = (uint16_t)(i + 1);
+            }
+            shuffle(values, g->side, random);
+            for (int i = 0; i < g->side; i++) {
+                full[cell_of(g, BY_BOX, i, b)] = (unsigned char)values[i];
+            }
+        }
+        if (solve(g, full, full, 1, NULL, FILL_BUDGET) == 1) {
+            return;
+        }
+    }
+    for (int i = 0; i < g->side; i++) {
+        values[i] = (uint16_t)(i + 1);
+    }
+    shuffle(values, g->side, random);
+    for (int r = 0; r < g->side; r++) {
+        for (int c = 0; c < g->side; c++) {
+            full[r * g->side + c] = (unsigned char)values[(g->box * (r % g->box) + r / g->box + c) % g->side];
+        }
+    }
+}
+
+// Function to generate a puzzle with a unique solution
+int sudoku_n_generate(int box, uint64_t seed, unsigned char *puzzle, unsigned char *solution) {
+    unsigned char full[SUDOKU_N_MAX_CELLS];
+    uint16_t order[SUDOKU_N_MAX_CELLS];
+    uint64_t random = seed;
+    struct geometry g;
+
+    if (geometry_init(&g, box) != 0) {
+        return -1;
+    }
+    fill_grid(&g, full, &random);
+
+    memcpy(puzzle, full, (size_t)g.cells);
+    for (int i = 0; i < g.cells; i++) {
+        order[i] = (uint16_t)i;
+    }
+    shuffle(order, g.cells, &random);
+    for (int i = 0; i < g.cells; i++) {
+        int cell = order[i];
+        unsigned char given = puzzle[cell];
+        puzzle[cell] = 0;
+        if (solve(&g, puzzle, NULL, SUDOKU_MANY, NULL, CHECK_BUDGET) != 1) {
+            puzzle[cell] = given;
+        }
+    }
+
+    if (solution != NULL) {
+        memcpy(solution, full, (size_t)g.cells);
+    }
+    return 0;
+}
@@ -0,0 +1,31 @@
+#ifndef SUDOKU_N_H
+#define SUDOKU_N_H
+
+#include <stdint.h>
+
+#include "sudoku.h"
+
+// Grids of box x box boxes of box x box cells, from 4x4 to 25x25. The usual
+// 9x9 grid is one of them, but sudoku.h has a solver and a grader tuned for it.
+#define SUDOKU_N_MIN_BOX 2
+#define SUDOKU_N_MAX_BOX 5
+#define SUDOKU_N_MAX_SIDE (SUDOKU_N_MAX_BOX * SUDOKU_N_MAX_BOX)
+#define SUDOKU_N_MAX_CELLS (SUDOKU_N_MAX_SIDE * SUDOKU_N_MAX_SIDE)
+
+// Solve a puzzle of box * box * box * box cells, row by row, holding values 0
+// to box * box, looking for at most limit solutions, like sudoku_solve().
+// Returns how many solutions were found, 0 as well if box is out of range.
+int sudoku_n_solve(int box, const unsigned char *puzzle, unsigned char *solution, int limit,
+                   struct sudoku_stats *stats);
+
+// Check a grid: returns 1 if every value is in range and no row, column or
+// box holds one twice, 0 otherwise
+int sudoku_n_check(int box, const unsigned char *grid);
+
+// Generate a puzzle with a unique solution, like sudoku_generate(); on the
+// larger grids, a cell whose removal the solver cannot settle quickly keeps
+// its given. The same box and seed always give the same puzzle. Returns 0 on
+// success, -1 if box is out of range.
+int sudoku_n_generate(int box, uint64_t seed, unsigned char *puzzle, unsigned char *solution);
+
+#endif
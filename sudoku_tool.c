@@ -0,0 +1,675 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pool.h"
+#include "sudoku.h"
+#include "sudoku_bank.h"
+#include "sudoku_n.h"
+
+#define BATCH 16384         // Puzzles read and solved at a time
+#define CHUNK 64            // Puzzles per task of the pool
+#define BENCH_ROUNDS 400    // Times the benchmark solves every hard puzzle
+#define BENCH_GENERATED 2000  // Puzzles the benchmark generates on every thread count
+#define BENCH_PICKS 1000000   // Picks the bank benchmark times
+#define BENCH_CHECKED 2000    // Picked puzzles the bank benchmark solves and grades again
+#define BENCH_SIZED 8         // Puzzles of every size the sizes benchmark generates and solves
+
+// Puzzles known to be hard for people and for solvers, for the benchmark
+static const char *const hard_puzzles[] = {
+    "8..........36......7..9.2...5...7.......457.....1...3...1....68..85...1..9....4..",
+    "1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..",
+    "4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......",
+    "1.......2.9.4...5...6...7...5.9.3.......7.......85..4.7.....6...3...9.8...2.....1",
+    "..............3.85..1.2.......5.7.....4...1...9.......5......73..2.1........4...9",
+    "12.3....435....1....4........54..2..6...7.........8.9...31..5.......9.7.....6...8",
+    ".2.4.37.........32........4.4.2...7.8...5.........1...5.....9...3.9....7..1..86..",
+};
+#define HARD_COUNT (int)(sizeof(hard_puzzles) / sizeof(hard_puzzles[0]))
+
+// Puzzles solved together on the pool
+struct batch {
+    int count;
+    int limit;                                // Solutions looked for per puzzle
+    unsigned char (*puzzles)[SUDOKU_CELLS];
+    unsigned char (*solutions)[SUDOKU_CELLS];
+    signed char *found;                       // Solutions found, -1 for a line that is not a puzzle
+    struct sudoku_stats *stats;               // One per chunk, so that threads add to their own
+};
+
+// Function to read the monotonic clock in nanoseconds
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Function to allocate a batch of BATCH puzzles; returns 0 on success
+static int batch_alloc(struct batch *b, int limit) {
+    b->count = 0;
+    b->limit = limit;
+    b->puzzles = malloc(BATCH * sizeof *b->puzzles);
+    b->solutions = malloc(BATCH * sizeof *b->solutions);
+    b->found = malloc(BATCH * sizeof *b->found);
+    b->stats = malloc((BATCH / CHUNK) * sizeof *b->stats);
+    if (b->puzzles == NULL || b->solutions == NULL || b->found == NULL || b->stats == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    return 0;
+}
+
+// Function to release a batch
+static void batch_free(struct batch *b) {
+    free(b->puzzles);
+    free(b->solutions);
+    free(b->found);
+    free(b->stats);
+}
+
+// Function to solve one chunk of a batch
+static void solve_chunk(void *ctx, int chunk) {
+    struct batch *b = ctx;
+    int end = (chunk + 1) * CHUNK < b->count ? (chunk + 1) * CHUNK : b->count;
+
+    memset(&b->stats[chunk], 0, sizeof b->stats[chunk]);
+    for (int i = chunk * CHUNK; i < end; i++) {
+        if (b->found[i] >= 0) {
+            b->found[i] = (signed char)sudoku_solve(b->puzzles[i], b->solutions[i], b->limit, &b->stats[chunk]);
+        }
+    }
+}
+
+// Function to solve a batch on the pool and add up its guesses
+static long long solve_batch(struct pool *pool, struct batch *b) {
+    int chunks = (b->count + CHUNK - 1) / CHUNK;
+    long long guesses = 0;
+
+    pool_run(pool, chunks, solve_chunk, b);
+    for (int c = 0; c < chunks; c++) {
+        guesses += b->stats[c].guesses;
+    }
+    return guesses;
+}
+
+// Function to solve the puzzles of stdin, one per line, printing a line for
+// each: its solution or the puzzle itself, and how many solutions it has
+static int solve_stream(struct pool *pool, int limit) {
+    static const char *const verdicts[] = { "none", "unique", "multiple" };
+    long counts[4] = { 0 };   // Lines that are not puzzles, then puzzles by solutions found
+    long long guesses = 0, busy = 0;
+    struct batch b;
+    char *line = NULL;
+    size_t cap = 0;
+    int done = 0;
+
+    if (batch_alloc(&b, limit) != 0) {
+        batch_free(&b);
+        return -1;
+    }
+    while (!done) {
+        b.count = 0;
+        while (b.count < BATCH) {
+            if (getline(&line, &cap, stdin) < 0) {
+                done = 1;
+                break;
+            }
+            b.found[b.count] = (signed char)(sudoku_parse(line, b.puzzles[b.count]) == 0 ? 0 : -1);
+            b.count++;
+        }
+
+        long long start = now_ns();
+        guesses += solve_batch(pool, &b);
+        busy += now_ns() - start;
+
+        for (int i = 0; i < b.count; i++) {
+            char text[SUDOKU_CELLS + 1];
+            int found = b.found[i];
+            counts[found + 1]++;
+            if (found < 0) {
+                puts("invalid");
+                continue;
+            }
+            sudoku_format(found > 0 ? b.solutions[i] : b.puzzles[i], text);
+            printf("%s %s\n", text, found < limit ? verdicts[found] : limit == 1 ? "solved" : verdicts[2]);
+        }
+    }
+    free(line);
+    batch_free(&b);
+
+    long puzzles = counts[1] + counts[2] + counts[3];
+    double seconds = (double)busy / 1e9;
+    fprintf(stderr, "%ld puzzles in %.3f s on %d threads: %.0f puzzles/s, %.2f guesses per puzzle\n", puzzles,
+            seconds, pool->threads, seconds > 0 ? puzzles / seconds : 0.0,
+            puzzles > 0 ? (double)guesses / puzzles : 0.0);
+    fprintf(stderr, "%ld solved, %ld without a solution, %ld lines not puzzles", counts[2] + counts[3], counts[1],
+            counts[0]);
+    if (limit > 1) {
+        fprintf(stderr, ", %ld with several solutions", counts[3]);
+    }
+    fputc('\n', stderr);
+    return 0;
+}
+
+// Function to time the hard puzzles, each on its own and then all of them on
+// 1, 2, 4... threads, up to twice the cores online; returns 0 if every puzzle
+// has a unique solution every time
+static int bench_solver(void) {
+    int cores = pool_cores();
+    int failed = 0;
+    double single = 0;
+    struct batch b;
+
+    if (batch_alloc(&b, SUDOKU_MANY) != 0) {
+        batch_free(&b);
+        return -1;
+    }
+    printf("%d hard puzzles, checked for a unique solution, %d cores online\n", HARD_COUNT, cores);
+    for (int i = 0; i < HARD_COUNT; i++) {
+        struct sudoku_stats stats = { 0 };
+        unsigned char puzzle[SUDOKU_CELLS];
+        int found = 0;
+
+        sudoku_parse(hard_puzzles[i], puzzle);
+        long long start = now_ns();
+        for (int r = 0; r < BENCH_ROUNDS; r++) {
+            found = sudoku_solve(puzzle, NULL, SUDOKU_MANY, &stats);
+        }
+        long long ns = (now_ns() - start) / BENCH_ROUNDS;
+        failed |= found != 1;
+        printf("%.20s... %7.1f us, %4lld guesses, %4lld naked and %4lld hidden singles, %s\n", hard_puzzles[i],
+               ns / 1e3, stats.guesses / BENCH_ROUNDS, stats.naked / BENCH_ROUNDS, stats.hidden / BENCH_ROUNDS,
+               found == 1 ? "unique" : "NOT UNIQUE");
+    }
+
+    b.count = HARD_COUNT * BENCH_ROUNDS < BATCH ? HARD_COUNT * BENCH_ROUNDS : BATCH;
+    for (int i = 0; i < b.count; i++) {
+        sudoku_parse(hard_puzzles[i % HARD_COUNT], b.puzzles[i]);
+    }
+    for (int threads = 1; threads <= 2 * cores || threads <= 4; threads *= 2) {
+        struct pool pool;
+        if (pool_init(&pool, threads) != 0) {
+            failed = 1;
+            break;
+        }
+        memset(b.found, 0, b.count * sizeof *b.found);
+        long long start = now_ns();
+        solve_batch(&pool, &b);
+        double seconds = (double)(now_ns() - start) / 1e9;
+        long long steals = pool_steals(&pool);
+        pool_free(&pool);
+
+        for (int i = 0; i < b.count; i++) {
+            failed |= b.found[i] != 1 || memcmp(b.solutions[i], b.solutions[i % HARD_COUNT], SUDOKU_CELLS) != 0;
+        }
+        double rate = b.count / seconds;
+        single = threads == 1 ? rate : single;
+        printf("%2d threads: %9.0f puzzles/s, %.2fx one thread, %lld steals\n", threads, rate, rate / single,
+               steals);
+    }
+    batch_free(&b);
+
+    printf("solutions %s\n", failed ? "WRONG" : "unique and identical");
+    return failed ? -1 : 0;
+}
+
+// Puzzles generated together on the pool
+struct generation {
+    int count;
+    uint64_t seed;                            // Puzzle i is generated from seed + i
+    unsigned char (*puzzles)[SUDOKU_CELLS];
+    signed char *grades;
+    long long *ns;                            // Time each puzzle took
+};
+
+// Function to allocate room for BATCH generated puzzles; returns 0 on success
+static int generation_alloc(struct generation *g) {
+    g->count = 0;
+    g->puzzles = malloc(BATCH * sizeof *g->puzzles);
+    g->grades = malloc(BATCH * sizeof *g->grades);
+    g->ns = malloc(BATCH * sizeof *g->ns);
+    if (g->puzzles == NULL || g->grades == NULL || g->ns == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    return 0;
+}
+
+// Function to release generated puzzles
+static void generation_free(struct generation *g) {
+    free(g->puzzles);
+    free(g->grades);
+    free(g->ns);
+}
+
+// Function to generate one chunk of puzzles
+static void generate_chunk(void *ctx, int chunk) {
+    struct generation *g = ctx;
+    int end = (chunk + 1) * CHUNK < g->count ? (chunk + 1) * CHUNK : g->count;
+
+    for (int i = chunk * CHUNK; i < end; i++) {
+        long long start = now_ns();
+        g->grades[i] = (signed char)sudoku_generate(g->seed + (uint64_t)i, g->puzzles[i], NULL);
+        g->ns[i] = now_ns() - start;
+    }
+}
+
+// Function to print how many puzzles of every grade came out, how many of
+// them a second and how long one took to generate
+static void report_grades(FILE *out, const long *counts, const long long *ns, double seconds) {
+    long total = 0;
+
+    for (int grade = 0; grade < SUDOKU_GRADES; grade++) {
+        total += counts[grade];
+    }
+    for (int grade = 0; grade < SUDOKU_GRADES; grade++) {
+        fprintf(out, "%-6s %7ld puzzles, %5.1f%%, %9.1f puzzles/s, %8.1f us each\n", sudoku_grade_names[grade],
+                counts[grade], total > 0 ? 100.0 * counts[grade] / total : 0.0,
+                seconds > 0 ? counts[grade] / seconds : 0.0, counts[grade] > 0 ? ns[grade] / 1e3 / counts[grade] : 0.0);
+    }
+}
+
+// Function to generate count puzzles of the given grade, or of any if it is
+// -1, printing each with its grade
+static int generate_stream(struct pool *pool, long count, uint64_t seed, int wanted) {
+    long counts[SUDOKU_GRADES] = { 0 };
+    long long ns[SUDOKU_GRADES] = { 0 };
+    long printed = 0;
+    struct generation g;
+
+    if (generation_alloc(&g) != 0) {
+        generation_free(&g);
+        return -1;
+    }
+    long long start = now_ns();
+    while (printed < count) {
+        g.seed = seed;
+        // Enough for what is left, guessing that every grade is as likely when one is wanted
+        long left = (count - printed) * (wanted < 0 ? 1 : SUDOKU_GRADES);
+        left = left > CHUNK * pool->threads ? left : CHUNK * pool->threads;
+        g.count = left < BATCH ? (int)left : BATCH;
+        pool_run(pool, (g.count + CHUNK - 1) / CHUNK, generate_chunk, &g);
+        seed += (uint64_t)g.count;
+
+        for (int i = 0; i < g.count; i++) {
+            char text[SUDOKU_CELLS + 1];
+            int grade = g.grades[i];
+            counts[grade]++;
+            ns[grade] += g.ns[i];
+            if ((wanted < 0 || grade == wanted) && printed < count) {
+                sudoku_format(g.puzzles[i], text);
+                printf("%s %s\n", text, sudoku_grade_names[grade]);
+                printed++;
+            }
+        }
+    }
+    double seconds = (double)(now_ns() - start) / 1e9;
+    generation_free(&g);
+
+    long made = counts[0] + counts[1] + counts[2] + counts[3];
+    fprintf(stderr, "%ld puzzles generated in %.3f s on %d threads: %.0f puzzles/s\n", made, seconds,
+            pool->threads, made / seconds);
+    report_grades(stderr, counts, ns, seconds);
+    return 0;
+}
+
+// Function to generate the same puzzles on 1, 2, 4... threads, up to twice
+// the cores online; returns 0 if every run gives the same puzzles, each with
+// a unique solution
+static int bench_generator(void) {
+    int cores = pool_cores();
+    int failed = 0;
+    double single = 0;
+    uint64_t first_hash = 0;
+    struct generation g;
+
+    if (generation_alloc(&g) != 0) {
+        generation_free(&g);
+        return -1;
+    }
+    g.count = BENCH_GENERATED;
+    g.seed = 1;
+    printf("%d puzzles per run, %d cores online\n", g.count, cores);
+    for (int threads = 1; threads <= 2 * cores || threads <= 4; threads *= 2) {
+        long counts[SUDOKU_GRADES] = { 0 };
+        long long ns[SUDOKU_GRADES] = { 0 };
+        uint64_t hash = 14695981039346656037ULL;   // FNV-1a over the puzzles
+        struct pool pool;
+
+        if (pool_init(&pool, threads) != 0) {
+            failed = 1;
+            break;
+        }
+        long long start = now_ns();
+        pool_run(&pool, (g.count + CHUNK - 1) / CHUNK, generate_chunk, &g);
+        double seconds = (double)(now_ns() - start) / 1e9;
+        pool_free(&pool);
+
+        for (int i = 0; i < g.count; i++) {
+            for (int cell = 0; cell < SUDOKU_CELLS; cell++) {
+                hash = (hash ^ g.puzzles[i][cell]) * 1099511628211ULL;
+            }
+            counts[g.grades[i]]++;
+            ns[g.grades[i]] += g.ns[i];
+        }
+        double rate = g.count / seconds;
+        single = threads == 1 ? rate : single;
+        first_hash = threads == 1 ? hash : first_hash;
+        failed |= hash != first_hash;
+        printf("%2d threads: %8.0f puzzles/s, %.2fx one thread, hash %016llx\n", threads, rate, rate / single,
+               (unsigned long long)hash);
+        if (threads == 1) {
+            report_grades(stdout, counts, ns, seconds);
+        }
+    }
+
+    // Every puzzle must still have exactly one solution
+    for (int i = 0; i < g.count; i++) {
+        failed |= sudoku_solve(g.puzzles[i], NULL, SUDOKU_MANY, NULL) != 1 || g.grades[i] < 0;
+    }
+    generation_free(&g);
+
+    printf("puzzles %s\n", failed ? "WRONG" : "unique and identical");
+    return failed ? -1 : 0;
+}
+
+// Function to generate a bank of count puzzles and write it to path, through
+// a temporary file so that a game never maps half a bank
+static int build_bank(struct pool *pool, const char *path, long count, uint64_t seed) {
+    struct sudoku_bank_header header = { .magic = SUDOKU_BANK_MAGIC, .record_size = SUDOKU_BANK_RECORD };
+    long counts[SUDOKU_GRADES] = { 0 };
+    long long ns[SUDOKU_GRADES] = { 0 };
+    long made = 0, skipped = 0;
+    struct generation g;
+    char tmp[4096];
+
+    if (count > UINT32_MAX || snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        fprintf(stderr, "%s: bank too large or path too long\n", path);
+        return -1;
+    }
+    if (generation_alloc(&g) != 0) {
+        generation_free(&g);
+        return -1;
+    }
+    unsigned char *packed = malloc((size_t)count * SUDOKU_BANK_RECORD);
+    unsigned char *sorted = malloc((size_t)count * SUDOKU_BANK_RECORD);
+    signed char *grades = malloc((size_t)count);
+    if (packed == NULL || sorted == NULL || grades == NULL) {
+        perror("malloc");
+        free(packed);
+        free(sorted);
+        free(grades);
+        generation_free(&g);
+        return -1;
+    }
+
+    long long start = now_ns();
+    while (made < count) {
+        long left = count - made > CHUNK * pool->threads ? count - made : CHUNK * pool->threads;
+        g.seed = seed;
+        g.count = left < BATCH ? (int)left : BATCH;
+        pool_run(pool, (g.count + CHUNK - 1) / CHUNK, generate_chunk, &g);
+        seed += (uint64_t)g.count;
+
+        for (int i = 0; i < g.count && made < count; i++) {
+            if (sudoku_bank_pack(g.puzzles[i], packed + made * SUDOKU_BANK_RECORD) != 0) {
+                skipped++;
+                continue;
+            }
+            grades[made++] = g.grades[i];
+            counts[g.grades[i]]++;
+            ns[g.grades[i]] += g.ns[i];
+        }
+    }
+    double seconds = (double)(now_ns() - start) / 1e9;
+    generation_free(&g);
+
+    // Sort the records by grade, keeping the order they were made in within one
+    uint32_t next[SUDOKU_GRADES];
+    header.count = (uint32_t)count;
+    for (int grade = 0; grade < SUDOKU_GRADES; grade++) {
+        header.first[grade] = grade == 0 ? 0 : header.first[grade - 1] + header.per_grade[grade - 1];
+        header.per_grade[grade] = (uint32_t)counts[grade];
+        next[grade] = header.first[grade];
+    }
+    for (long i = 0; i < count; i++) {
+        memcpy(sorted + (size_t)next[grades[i]]++ * SUDOKU_BANK_RECORD, packed + i * SUDOKU_BANK_RECORD,
+               SUDOKU_BANK_RECORD);
+    }
+    header.id = 14695981039346656037ULL;   // FNV-1a over the records
+    for (size_t i = 0; i < (size_t)count * SUDOKU_BANK_RECORD; i++) {
+        header.id = (header.id ^ sorted[i]) * 1099511628211ULL;
+    }
+
+    FILE *out = fopen(tmp, "wb");
+    int failed = out == NULL;
+    if (!failed) {
+        failed = fwrite(&header, sizeof(header), 1, out) != 1
+                 || fwrite(sorted, SUDOKU_BANK_RECORD, (size_t)count, out) != (size_t)count;
+        failed |= fclose(out) != 0;
+    }
+    failed = failed || rename(tmp, path) != 0;
+    if (failed) {
+        perror(tmp);
+        unlink(tmp);
+    }
+    free(packed);
+    free(sorted);
+    free(grades);
+    if (failed) {
+        return -1;
+    }
+
+    size_t size = sizeof(header) + (size_t)count * SUDOKU_BANK_RECORD;
+    fprintf(stderr, "%ld puzzles generated in %.3f s on %d threads, %ld with too many givens left out\n", count,
+            seconds, pool->threads, skipped);
+    report_grades(stderr, counts, ns, seconds);
+    fprintf(stderr, "%s: %zu bytes, %d bytes per puzzle, id %016llx\n", path, size, SUDOKU_BANK_RECORD,
+            (unsigned long long)header.id);
+    return 0;
+}
+
+// Function to time picks from a bank, with and without seen marks, and check
+// that picked puzzles are unique, of the grade asked for, and that a player is
+// not given the same puzzle twice before running out; returns 0 if they are
+static int bench_bank(const char *path) {
+    struct sudoku_bank bank;
+    unsigned char puzzle[SUDOKU_CELLS];
+    char seen_path[] = "/tmp/vgc_sudoku_seen_XXXXXX";
+    int failed = 0;
+
+    if (sudoku_bank_open(&bank, path) != 0) {
+        fprintf(stderr, "%s: cannot open the bank\n", path);
+        return -1;
+    }
+    const struct sudoku_bank_header *h = bank.header;
+    printf("%s: %u puzzles, %zu bytes\n", path, h->count, bank.size);
+    for (int grade = 0; grade < SUDOKU_GRADES; grade++) {
+        printf("%-6s %8u puzzles from record %u\n", sudoku_grade_names[grade], h->per_grade[grade], h->first[grade]);
+    }
+
+    unsigned int sum = 0;   // Keeps the picks from being optimised away
+    long long start = now_ns();
+    for (long i = 0; i < BENCH_PICKS; i++) {
+        sum += (unsigned int)sudoku_bank_pick(&bank, (int)(i % SUDOKU_GRADES), (uint64_t)i, puzzle) + puzzle[40];
+    }
+    printf("untracked picks: %6.1f ns each (%u)\n", (double)(now_ns() - start) / BENCH_PICKS, sum);
+
+    long long solve_ns = 0;
+    for (int i = 0; i < BENCH_CHECKED; i++) {
+        int grade = i % SUDOKU_GRADES;
+        if (sudoku_bank_pick(&bank, grade, (uint64_t)i * 7919, puzzle) < 0) {
+            continue;
+        }
+        long long solve_start = now_ns();
+        failed |= sudoku_solve(puzzle, NULL, SUDOKU_MANY, NULL) != 1;
+        solve_ns += now_ns() - solve_start;
+        failed |= sudoku_grade(puzzle) != grade;
+    }
+    printf("%d picked puzzles solved again: %.1f us to derive a solution\n", BENCH_CHECKED,
+           solve_ns / 1e3 / BENCH_CHECKED);
+
+    // A player picking every puzzle of the smallest grade must get each once,
+    // and then start over
+    int smallest = 0;
+    for (int grade = 1; grade < SUDOKU_GRADES; grade++) {
+        smallest = h->per_grade[grade] < h->per_grade[smallest] && h->per_grade[grade] > 0 ? grade : smallest;
+    }
+    int fd = mkstemp(seen_path);
+    unsigned char *had = calloc(h->count, 1);
+    if (fd < 0 || had == NULL || sudoku_bank_track(&bank, seen_path) != 0) {
+        perror("seen marks");
+        failed = 1;
+    } else {
+        long picks = h->per_grade[smallest];
+        start = now_ns();
+        for (long i = 0; i < picks; i++) {
+            long index = sudoku_bank_pick(&bank, smallest, (uint64_t)i, puzzle);
+            failed |= index < (long)h->first[smallest] || index >= (long)(h->first[smallest] + picks) || had[index];
+            had[index < 0 ? 0 : index] = 1;
+        }
+        double each = picks > 0 ? (double)(now_ns() - start) / picks : 0.0;
+        failed |= picks > 0 && sudoku_bank_pick(&bank, smallest, 0, puzzle) < 0;
+        printf("tracked picks:   %6.1f ns each, every %s puzzle once before starting over\n", each,
+               sudoku_grade_names[smallest]);
+    }
+    if (fd >= 0) {
+        close(fd);
+        unlink(seen_path);
+    }
+    free(had);
+    sudoku_bank_close(&bank);
+
+    printf("bank %s\n", failed ? "WRONG" : "consistent");
+    return failed ? -1 : 0;
+}
+
+// Function to generate and solve puzzles of every size from 4x4 to 25x25,
+// and the hard puzzles with both solvers; returns 0 if every puzzle has a
+// unique solution, the one it was generated from, and both solvers agree
+static int bench_sizes(void) {
+    static unsigned char puzzle[SUDOKU_N_MAX_CELLS], solution[SUDOKU_N_MAX_CELLS], solved[SUDOKU_N_MAX_CELLS];
+    int failed = 0;
+
+    for (int box = SUDOKU_N_MIN_BOX; box <= SUDOKU_N_MAX_BOX; box++) {
+        int side = box * box, cells = side * side;
+        long long generate_ns = 0, solve_ns = 0, guesses = 0, givens = 0;
+        int unique = 0;
+
+        for (int i = 0; i < BENCH_SIZED; i++) {
+            struct sudoku_stats stats = { 0 };
+            long long start = now_ns();
+            sudoku_n_generate(box, (uint64_t)i + 1, puzzle, solution);
+            generate_ns += now_ns() - start;
+
+            start = now_ns();
+            int found = sudoku_n_solve(box, puzzle, solved, SUDOKU_MANY, &stats);
+            solve_ns += now_ns() - start;
+            guesses += stats.guesses;
+            for (int c = 0; c < cells; c++) {
+                givens += puzzle[c] != 0;
+            }
+
+            int right = found == 1 && sudoku_n_check(box, solved) && memcmp(solved, solution, cells) == 0;
+            if (box == 3) {
+                unsigned char classic[SUDOKU_CELLS];
+                right &= sudoku_solve(puzzle, classic, SUDOKU_MANY, NULL) == 1 &&
+                         memcmp(classic, solved, SUDOKU_CELLS) == 0;
+            }
+            unique += right;
+        }
+        failed |= unique != BENCH_SIZED;
+        printf("%2dx%-2d: generated in %8.2f ms, %4.1f%% given, solved in %8.1f us, %5lld guesses, %d/%d unique\n",
+               side, side, generate_ns / 1e6 / BENCH_SIZED, 100.0 * givens / ((long long)cells * BENCH_SIZED),
+               solve_ns / 1e3 / BENCH_SIZED, guesses / BENCH_SIZED, unique, BENCH_SIZED);
+    }
+
+    for (int i = 0; i < HARD_COUNT; i++) {
+        unsigned char classic[SUDOKU_CELLS];
+
+        sudoku_parse(hard_puzzles[i], puzzle);
+        long long start = now_ns();
+        int found = sudoku_n_solve(3, puzzle, solved, SUDOKU_MANY, NULL);
+        long long wide_ns = now_ns() - start;
+        start = now_ns();
+        int classic_found = sudoku_solve(puzzle, classic, SUDOKU_MANY, NULL);
+        long long classic_ns = now_ns() - start;
+
+        int same = found == 1 && classic_found == 1 && memcmp(classic, solved, SUDOKU_CELLS) == 0;
+        failed |= !same;
+        printf("%.20s... %7.1f us on any size, %7.1f us on 9x9 only, %s\n", hard_puzzles[i], wide_ns / 1e3,
+               classic_ns / 1e3, same ? "same solution" : "SOLUTIONS DIFFER");
+    }
+
+    printf("sizes %s\n", failed ? "WRONG" : "consistent");
+    return failed ? -1 : 0;
+}
+
+// Function to explain the options
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-j threads] [--first] < puzzles\n"
+            "       %s [-j threads] --generate count [--seed n] [--grade easy|medium|hard|expert]\n"
+            "       %s [-j threads] --build-bank path count [--seed n]\n"
+            "       %s --bench-solver | --bench-generator | --bench-sizes | --bench-bank path\n"
+            "Solves puzzles of 81 cells, one per line, '0' or '.' for an empty cell, and prints\n"
+            "each solution with none, unique or multiple; --first stops at the first solution.\n"
+            "--generate prints new puzzles with a unique solution, each with its grade.\n"
+            "--build-bank writes as many to a bank for the sudoku game to pick from.\n",
+            prog, prog, prog, prog);
+}
+
+// Main function
+int main(int argc, char *argv[]) {
+    struct pool pool;
+    int threads = pool_cores();
+    int limit = SUDOKU_MANY;
+    long generate = 0;
+    uint64_t seed = (uint64_t)time(NULL);
+    int grade = -1;
+    const char *bank = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        int has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--bench-solver") == 0) {
+            return bench_solver() == 0 ? 0 : 1;
+        } else if (strcmp(argv[i], "--bench-generator") == 0) {
+            return bench_generator() == 0 ? 0 : 1;
+        } else if (strcmp(argv[i], "--bench-sizes") == 0) {
+            return bench_sizes() == 0 ? 0 : 1;
+        } else if (strcmp(argv[i], "--bench-bank") == 0 && has_value) {
+            return bench_bank(argv[i + 1]) == 0 ? 0 : 1;
+        } else if (strcmp(argv[i], "--build-bank") == 0 && i + 2 < argc && atol(argv[i + 2]) > 0) {
+            bank = argv[++i];
+            generate = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--first") == 0) {
+            limit = 1;
+        } else if (strcmp(argv[i], "-j") == 0 && has_value && atoi(argv[i + 1]) > 0) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--generate") == 0 && has_value && atol(argv[i + 1]) > 0) {
+            generate = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--grade") == 0 && has_value && sudoku_find_grade(argv[i + 1]) >= 0) {
+            grade = sudoku_find_grade(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (pool_init(&pool, threads) != 0) {
+        return 1;
+    }
+    int result;
+    if (bank != NULL) {
+        result = build_bank(&pool, bank, generate, seed);
+    } else {
+        result = generate > 0 ? generate_stream(&pool, generate, seed, grade) : solve_stream(&pool, limit);
+    }
+    pool_free(&pool);
+    return result == 0 ? 0 : 1;
+}